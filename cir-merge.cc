@@ -0,0 +1,224 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <G4ios.hh>
+#include <G4String.hh>
+
+#include "CIR_Campaign.hh"
+#include "CIR_Parallel.hh"
+#include "CIR_ProjectionGrid.hh"
+#include "CIR_TrackReconstruction.hh"
+
+using CarbonIonRadiography::ShardManifest;
+using CarbonIonRadiography::ProjectionGrid;
+using CarbonIonRadiography::TrackReconstruction;
+using CarbonIonRadiography::hardware_threads;
+using CarbonIonRadiography::parallel_for;
+
+// Merge of the campaign shards outputs, checks that the shards manifests
+// cover all events of the campaign exactly once
+//
+// cir-merge [-threads n] output manifest...
+
+namespace {
+
+void
+usage(const char* name)
+{
+	G4cerr << "Usage: " << name << " [-threads n] output manifest..."
+		<< G4endl;
+}
+
+// hits and tracks dumps are the number of records and the records,
+// so they are merged by copying the records of every shard to its offset
+int
+merge_dumps( const std::vector<ShardManifest>& shards, const char* output,
+	G4int threads)
+{
+	const size_t header = sizeof(size_t);
+	std::vector<size_t> records( shards.size(), 0);
+	std::vector<std::streamoff> sizes( shards.size(), 0);
+
+	for ( size_t i = 0; i < shards.size(); ++i) {
+		std::ifstream dump( shards[i].output.c_str(), std::ios::binary);
+		dump.read( (char *)&records[i], header);
+		dump.seekg( 0, std::ios::end);
+		if (!dump || dump.tellg() < std::streamoff(header)) {
+			G4cerr << "Can't read " << shards[i].output << G4endl;
+			return 1;
+		}
+		sizes[i] = dump.tellg() - std::streamoff(header);
+
+		// one hits record per event
+		if (shards[i].type == "hits" &&
+			records[i] != size_t(shards[i].events)) {
+			G4cerr << shards[i].output << " has " << records[i]
+				<< " events instead of " << shards[i].events << G4endl;
+			return 1;
+		}
+	}
+
+	size_t total = 0;
+	std::vector<std::streamoff> offsets( shards.size(), 0);
+	std::streamoff offset = header;
+	for ( size_t i = 0; i < shards.size(); ++i) {
+		total += records[i];
+		offsets[i] = offset;
+		offset += sizes[i];
+	}
+
+	{
+		std::ofstream dump( output, std::ios::binary | std::ios::trunc);
+		dump.write( (char *)&total, header);
+		if (!dump) {
+			G4cerr << "Can't write " << output << G4endl;
+			return 1;
+		}
+	}
+
+	std::vector<char> failed( shards.size(), 0);
+	parallel_for( shards.size(), threads,
+		[&]( G4int, size_t begin, size_t end) {
+			std::vector<char> buffer(1 << 20);
+			for ( size_t i = begin; i < end; ++i) {
+				std::ifstream in( shards[i].output.c_str(), std::ios::binary);
+				std::fstream out( output,
+					std::ios::binary | std::ios::in | std::ios::out);
+				in.seekg(header);
+				out.seekp(offsets[i]);
+
+				std::streamoff rest = sizes[i];
+				while (rest > 0 && in && out) {
+					std::streamsize n = std::min( std::streamoff(buffer.size()), rest);
+					in.read( &buffer[0], n);
+					out.write( &buffer[0], in.gcount());
+					rest -= in.gcount();
+				}
+				failed[i] = (rest != 0 || !out);
+			}
+	});
+
+	for ( size_t i = 0; i < shards.size(); ++i) {
+		if (failed[i]) {
+			G4cerr << "Can't merge " << shards[i].output << G4endl;
+			return 1;
+		}
+	}
+
+	G4cout << "Merged " << total << " records of " << shards.size()
+		<< " shards into " << output << G4endl;
+	return 0;
+}
+
+// projection grids are added, partial sums of every thread are reduced
+// in the thread order
+int
+merge_grids( const std::vector<ShardManifest>& shards, const char* output,
+	G4int threads)
+{
+	TrackReconstruction rec;
+	threads = CarbonIonRadiography::parallel_threads( shards.size(), threads);
+
+	std::vector<ProjectionGrid> sums( threads,
+		ProjectionGrid( rec.axis_x(), rec.axis_y()));
+	std::vector<char> failed( shards.size(), 0);
+
+	parallel_for( shards.size(), threads,
+		[&]( G4int t, size_t begin, size_t end) {
+			ProjectionGrid grid( rec.axis_x(), rec.axis_y());
+			for ( size_t i = begin; i < end; ++i) {
+				failed[i] = !ProjectionGrid::load( shards[i].output.c_str(), grid) ||
+					!sums[t].add(grid);
+			}
+	});
+
+	for ( size_t i = 0; i < shards.size(); ++i) {
+		if (failed[i]) {
+			G4cerr << "Can't merge projection grid " << shards[i].output
+				<< G4endl;
+			return 1;
+		}
+	}
+
+	for ( G4int t = 1; t < threads; ++t)
+		sums[0].add(sums[t]);
+
+	if (!sums[0].save(output)) {
+		G4cerr << "Can't write " << output << G4endl;
+		return 1;
+	}
+
+	G4cout << "Merged " << sums[0].entries() << " tracks of " << shards.size()
+		<< " shards into " << output << G4endl;
+	return 0;
+}
+
+} // namespace
+
+int main( int argc, char** argv)
+{
+	G4int threads = 0;
+	G4int arg = 1;
+	if (argc > 2 && !strcmp( argv[1], "-threads")) {
+		threads = atoi(argv[2]);
+		arg = 3;
+	}
+
+	if (argc - arg < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	const char* output = argv[arg++];
+
+	std::vector<ShardManifest> shards( argc - arg);
+	for ( size_t i = 0; i < shards.size(); ++i) {
+		if (!ShardManifest::read( argv[arg + i], shards[i])) {
+			G4cerr << "Can't read shard manifest " << argv[arg + i] << G4endl;
+			return 1;
+		}
+	}
+
+	// shards in the campaign order, whatever the order of the arguments
+	// (shard.10 before shard.2 of a shell glob), so the records follow
+	// the events and the grids are added in the same order
+	std::sort( shards.begin(), shards.end(),
+		[]( const ShardManifest& a, const ShardManifest& b) {
+			return a.index < b.index;
+		});
+
+	std::string error;
+	if (!ShardManifest::check_coverage( shards, error)) {
+		G4cerr << "Incomplete campaign: " << error << G4endl;
+		return 1;
+	}
+
+	threads = hardware_threads(threads);
+	if (shards.front().type == "projection")
+		return merge_grids( shards, output, threads);
+
+	return merge_dumps( shards, output, threads);
+}
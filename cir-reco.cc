@@ -0,0 +1,469 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <G4ios.hh>
+#include <G4String.hh>
+#include <G4SystemOfUnits.hh>
+
+#include <TH2.h>
+#include <TH3.h>
+#include <TFile.h>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_TrackReconstruction.hh"
+#include "CIR_ProjectionGrid.hh"
+#include "CIR_ReconstructionPipeline.hh"
+#include "CIR_WeplCalibration.hh"
+#include "CIR_MostLikelyPath.hh"
+#include "CIR_FilteredBackProjection.hh"
+#include "CIR_SartReconstruction.hh"
+
+using CarbonIonRadiography::GeometryConfig;
+using CarbonIonRadiography::TrackReconstruction;
+using CarbonIonRadiography::FullTracksVector;
+using CarbonIonRadiography::MainTracksVector;
+using CarbonIonRadiography::ProjectionGrid;
+using CarbonIonRadiography::ReconstructionPipeline;
+using CarbonIonRadiography::WeplCalibration;
+using CarbonIonRadiography::MostLikelyPath;
+using CarbonIonRadiography::FilteredBackProjection;
+using CarbonIonRadiography::SartReconstruction;
+using CarbonIonRadiography::Histogram2D;
+using CarbonIonRadiography::HistogramAxis;
+
+// Offline reconstruction of the saved tracks or hits,
+// doesn't initialize Geant4 kernel
+//
+// cir-reco [clear_full object_main object_full [image.root [threads]]]
+// cir-reco -hits clear_hits object_hits [image.root [threads]]
+// cir-reco -grid clear_projection object_projection [image.root]
+// cir-reco -calibrate table clear_projection [wepl step_projection ...]
+// cir-reco -mlp clear_full object_main object_full z_in z_out
+//          [image.root [steps [threads]]]
+// cir-reco -fbp clear_projection ct.manifest [volume.root [threads]]
+// cir-reco -sart clear_hits ct.manifest z_in z_out
+//          [volume.root [iterations [threads]]]
+//
+// every mode can start with -geometry file, the geometry parameters
+// of the run (see CIR_GeometryConfig.hh), and with -wepl table, the WEPL
+// calibration of the object images (see CIR_WeplCalibration.hh)
+
+namespace {
+
+// WEPL calibration of the images, empty -- slices from the clear peak
+WeplCalibration calibration;
+
+const WeplCalibration*
+image_calibration()
+{
+	return calibration.empty() ? 0 : &calibration;
+}
+
+void
+usage(const char* name)
+{
+	G4cerr << "Usage: " << name
+		<< " [clear_full object_main object_full [image.root [threads]]]"
+		<< G4endl;
+	G4cerr << "       " << name
+		<< " -hits clear_hits object_hits [image.root [threads]]"
+		<< G4endl;
+	G4cerr << "       " << name
+		<< " -grid clear_projection object_projection [image.root]"
+		<< G4endl;
+	G4cerr << "       " << name
+		<< " -calibrate table clear_projection [wepl step_projection ...]"
+		<< G4endl;
+	G4cerr << "       " << name
+		<< " -mlp clear_full object_main object_full z_in z_out"
+		<< " [image.root [steps [threads]]]" << G4endl;
+	G4cerr << "       " << name
+		<< " -fbp clear_projection ct.manifest [volume.root [threads]]"
+		<< G4endl;
+	G4cerr << "       " << name
+		<< " -sart clear_hits ct.manifest z_in z_out"
+		<< " [volume.root [iterations [threads]]]" << G4endl;
+	G4cerr << "       " << name << " -geometry file <any of above>" << G4endl;
+	G4cerr << "       " << name << " -wepl table <any of above>" << G4endl;
+}
+
+// saved projection grids -> image
+int
+reconstruct_grids( int argc, char** argv)
+{
+	if (argc < 4) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	G4String image_file = (argc >= 5) ? argv[4] : "image.root";
+
+	TrackReconstruction rec;
+	rec.set_calibration(image_calibration());
+	ProjectionGrid clear( rec.axis_x(), rec.axis_y());
+	ProjectionGrid object( rec.axis_x(), rec.axis_y());
+
+	if (!ProjectionGrid::load( argv[2], clear)) {
+		G4cerr << "Can't load projection grid " << argv[2] << G4endl;
+		return 1;
+	}
+	if (!ProjectionGrid::load( argv[3], object)) {
+		G4cerr << "Can't load projection grid " << argv[3] << G4endl;
+		return 1;
+	}
+
+	rec.reconstruct( clear, object, image_file.c_str());
+
+	return 0;
+}
+
+// hits files -> projection grids -> image, in one pass
+int
+reconstruct_hits( int argc, char** argv)
+{
+	if (argc < 4) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	G4String image_file = (argc >= 5) ? argv[4] : "image.root";
+	G4int threads = (argc >= 6) ? atoi(argv[5]) : 0;
+
+	TrackReconstruction rec;
+	rec.set_threads(threads);
+	rec.set_calibration(image_calibration());
+
+	ProjectionGrid clear( rec.axis_x(), rec.axis_y());
+	ProjectionGrid object( rec.axis_x(), rec.axis_y());
+
+	ReconstructionPipeline pipeline(threads);
+	pipeline.process( argv[2], clear);
+	G4cout << "Clear: " << pipeline.events() << " events, "
+		<< pipeline.tracks() << " tracks" << G4endl;
+
+	pipeline.process( argv[3], object);
+	G4cout << "Object: " << pipeline.events() << " events, "
+		<< pipeline.tracks() << " tracks" << G4endl;
+
+	rec.reconstruct( clear, object, image_file.c_str());
+
+	return 0;
+}
+
+// clear field and known step phantom projection grids -> WEPL calibration
+int
+calibrate( int argc, char** argv)
+{
+	if (argc < 4 || argc % 2) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	WeplCalibration table;
+	TrackReconstruction rec;
+	for ( G4int i = 3; i < argc; i += 2) {
+		G4double wepl = (i == 3) ? 0.0 : atof(argv[i - 1]);
+		ProjectionGrid grid( rec.axis_x(), rec.axis_y());
+		if (!ProjectionGrid::load( argv[i], grid)) {
+			G4cerr << "Can't load projection grid " << argv[i] << G4endl;
+			return 1;
+		}
+		table.add_run( grid, wepl);
+	}
+
+	if (!table.save(argv[2])) {
+		G4cerr << "Can't save WEPL calibration " << argv[2] << G4endl;
+		return 1;
+	}
+	G4cout << "WEPL calibration of " << table.points() << " points" << G4endl;
+
+	return 0;
+}
+
+// saved tracks -> images of the most likely paths in the object slab
+// [z_in, z_out] (mm)
+int
+reconstruct_paths( int argc, char** argv)
+{
+	if (argc < 7) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	G4double z_in = atof(argv[5]) * 1000.0; // um
+	G4double z_out = atof(argv[6]) * 1000.0; // um
+	G4String image_file = (argc >= 8) ? argv[7] : "image.root";
+	G4int steps = (argc >= 9) ? atoi(argv[8]) : 32;
+	G4int threads = (argc >= 10) ? atoi(argv[9]) : 0;
+
+	FullTracksVector clear_full, object_full;
+	MainTracksVector object_main;
+
+	TrackReconstruction::load( argv[2], clear_full);
+	TrackReconstruction::load( argv[3], object_main);
+	TrackReconstruction::load( argv[4], object_full);
+
+	if (object_main.size() != object_full.size()) {
+		G4cerr << "Number of main tracks " << object_main.size()
+			<< " differs from number of full tracks " << object_full.size()
+			<< G4endl;
+		return 1;
+	}
+
+	MostLikelyPath path( z_in, z_out, steps);
+	TrackReconstruction rec( object_main, object_full);
+	rec.set_threads(threads);
+	rec.set_calibration(image_calibration());
+	rec.reconstruct( clear_full, path, image_file.c_str());
+
+	return 0;
+}
+
+// projection grids of the CT acquisition (see /campaign/ct) -> volume
+int
+reconstruct_volume( int argc, char** argv)
+{
+	if (argc < 4) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	G4String volume_file = (argc >= 5) ? argv[4] : "volume.root";
+	G4int threads = (argc >= 6) ? atoi(argv[5]) : 0;
+
+	TrackReconstruction rec;
+	rec.set_calibration(image_calibration());
+	ProjectionGrid clear( rec.axis_x(), rec.axis_y());
+	if (!ProjectionGrid::load( argv[2], clear)) {
+		G4cerr << "Can't load projection grid " << argv[2] << G4endl;
+		return 1;
+	}
+
+	std::ifstream manifest(argv[3]);
+	if (!manifest) {
+		G4cerr << "Can't open CT manifest " << argv[3] << G4endl;
+		return 1;
+	}
+
+	// "projection angle(deg) events output" lines
+	FilteredBackProjection fbp( clear.axis_x(), clear.axis_y());
+	fbp.set_threads(threads);
+	std::string line;
+	while (std::getline( manifest, line)) {
+		std::istringstream fields(line);
+		G4int index = 0, events = 0;
+		G4double angle = 0.0;
+		std::string output;
+		if (line.empty() || line[0] == '#' ||
+			!(fields >> index >> angle >> events >> output))
+			continue;
+
+		ProjectionGrid object( clear.axis_x(), clear.axis_y());
+		if (!ProjectionGrid::load( output.c_str(), object)) {
+			G4cerr << "Can't load projection grid " << output << G4endl;
+			return 1;
+		}
+
+		Histogram2D<G4double> image( object.axis_x(), object.axis_y());
+		rec.form_projection_image( clear, object, image);
+		if (!fbp.add_projection( angle * CLHEP::deg, image))
+			return 1;
+	}
+	G4cout << "CT reconstruction of " << fbp.projections() << " projections"
+		<< G4endl;
+
+	std::vector<G4double> volume;
+	fbp.reconstruct(volume);
+
+	TFile* file = new TFile( volume_file.c_str(), "RECREATE");
+	TH3D* hist = fbp.create_volume( "volume", "Volume", volume);
+	TH2D* sinogram = fbp.create_sinogram( "sinogram", "Sinogram",
+		clear.axis_y().bins / 2);
+	hist->Write();
+	sinogram->Write();
+	file->Close();
+
+	delete file;
+
+	return 0;
+}
+
+// hits files of the CT acquisition (see /campaign/ct) -> volume along
+// the most likely paths in the object slab [z_in, z_out] (mm)
+int
+reconstruct_histories( int argc, char** argv)
+{
+	if (argc < 6) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	G4double z_in = atof(argv[4]) * 1000.0; // um
+	G4double z_out = atof(argv[5]) * 1000.0; // um
+	G4String volume_file = (argc >= 7) ? argv[6] : "volume.root";
+	G4int iterations = (argc >= 8) ? atoi(argv[7]) : 10;
+	G4int threads = (argc >= 9) ? atoi(argv[8]) : 0;
+
+	TrackReconstruction rec;
+	rec.set_calibration(image_calibration());
+	ProjectionGrid clear( rec.axis_x(), rec.axis_y());
+
+	ReconstructionPipeline pipeline(threads);
+	pipeline.process( argv[2], clear);
+	G4cout << "Clear: " << pipeline.events() << " events, "
+		<< pipeline.tracks() << " tracks" << G4endl;
+	const std::vector<G4double> values = rec.position_values(clear);
+
+	std::ifstream manifest(argv[3]);
+	if (!manifest) {
+		G4cerr << "Can't open CT manifest " << argv[3] << G4endl;
+		return 1;
+	}
+
+	// volume of the image binning, slices along the rotation axis,
+	// two path steps per voxel
+	const HistogramAxis& u = rec.axis_x();
+	G4int steps = G4int(2.0 * (z_out - z_in) * u.bins / (u.max - u.min));
+	MostLikelyPath path( z_in, z_out, steps);
+	SartReconstruction sart( u, rec.axis_y(), path,
+		(volume_file + ".matrix").c_str());
+	sart.set_threads(threads);
+
+	// "projection angle(deg) events output" lines
+	std::string line;
+	while (std::getline( manifest, line)) {
+		std::istringstream fields(line);
+		G4int index = 0, events = 0;
+		G4double angle = 0.0;
+		std::string output;
+		if (line.empty() || line[0] == '#' ||
+			!(fields >> index >> angle >> events >> output))
+			continue;
+
+		sart.begin_projection(angle * CLHEP::deg);
+		pipeline.process( output.c_str(),
+			[&]( const MainTracksVector& main, const FullTracksVector& full) {
+				sart.add_histories( main, full, values);
+			});
+		sart.end_projection();
+		G4cout << "Projection " << index << ": " << pipeline.events()
+			<< " events, " << pipeline.tracks() << " tracks" << G4endl;
+	}
+	G4cout << "SART reconstruction of " << sart.histories() << " histories, "
+		<< sart.subsets() << " subsets" << G4endl;
+
+	std::vector<G4double> volume;
+	if (!sart.reconstruct( iterations, volume))
+		return 1;
+
+	TFile* file = new TFile( volume_file.c_str(), "RECREATE");
+	TH3D* hist = sart.create_volume( "volume", "Volume", volume);
+	hist->Write();
+	file->Close();
+
+	delete file;
+
+	return 0;
+}
+
+// saved tracks -> image
+int
+reconstruct_tracks( int argc, char** argv)
+{
+	if (argc != 1 && argc < 4) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	G4String clear_full_file = "clear_full_tracks.dat";
+	G4String object_main_file = "objects_main_tracks.dat";
+	G4String object_full_file = "objects_full_tracks.dat";
+	G4String image_file = "image.root";
+	G4int threads = 0;
+
+	if (argc >= 4) {
+		clear_full_file = argv[1];
+		object_main_file = argv[2];
+		object_full_file = argv[3];
+	}
+	if (argc >= 5)
+		image_file = argv[4];
+	if (argc >= 6)
+		threads = atoi(argv[5]);
+
+	FullTracksVector clear_full, object_full;
+	MainTracksVector object_main;
+
+	TrackReconstruction::load( clear_full_file.c_str(), clear_full);
+	TrackReconstruction::load( object_main_file.c_str(), object_main);
+	TrackReconstruction::load( object_full_file.c_str(), object_full);
+
+	if (object_main.size() != object_full.size()) {
+		G4cerr << "Number of main tracks " << object_main.size()
+			<< " differs from number of full tracks " << object_full.size()
+			<< G4endl;
+		return 1;
+	}
+
+	TrackReconstruction rec( object_main, object_full);
+	rec.set_threads(threads);
+	rec.set_calibration(image_calibration());
+	rec.reconstruct( clear_full, image_file.c_str());
+
+	return 0;
+}
+
+} // namespace
+
+int main( int argc, char** argv)
+{
+	while (argc > 2 && (!strcmp( argv[1], "-geometry") ||
+		!strcmp( argv[1], "-wepl"))) {
+		if (!strcmp( argv[1], "-geometry") &&
+			!GeometryConfig::instance().load(argv[2]))
+			return 1;
+		if (!strcmp( argv[1], "-wepl") &&
+			!WeplCalibration::load( argv[2], calibration))
+			return 1;
+		// drop the option, keep the program name
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+	}
+
+	if (argc > 1 && !strcmp( argv[1], "-hits"))
+		return reconstruct_hits( argc, argv);
+	if (argc > 1 && !strcmp( argv[1], "-grid"))
+		return reconstruct_grids( argc, argv);
+	if (argc > 1 && !strcmp( argv[1], "-calibrate"))
+		return calibrate( argc, argv);
+	if (argc > 1 && !strcmp( argv[1], "-mlp"))
+		return reconstruct_paths( argc, argv);
+	if (argc > 1 && !strcmp( argv[1], "-fbp"))
+		return reconstruct_volume( argc, argv);
+	if (argc > 1 && !strcmp( argv[1], "-sart"))
+		return reconstruct_histories( argc, argv);
+
+	return reconstruct_tracks( argc, argv);
+}
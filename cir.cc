@@ -40,16 +40,12 @@
 #include "CIR_PhysicsList.hh"
 #include "CIR_DetectorConstruction.hh"
 #include "CIR_ActionInitialization.hh"
-#include "CIR_TrackReconstruction.hh"
 #include "CIR_SharedData.hh"
 
 using CarbonIonRadiography::DetectorConstruction;
 using CarbonIonRadiography::PhysicsList;
 using CarbonIonRadiography::ActionInitialization;
 using CarbonIonRadiography::ParallelWorldPhysicsStr;
-using CarbonIonRadiography::TrackReconstruction;
-using CarbonIonRadiography::FullTracksVector;
-using CarbonIonRadiography::MainTracksVector;
 
 int main( int argc, char** argv)
 {
@@ -86,9 +82,20 @@ int main( int argc, char** argv)
 	// set mandatory user action class
 	runManager->SetUserInitialization(new ActionInitialization());
 
+	// commands of the PreInit state (geometry, phantom)
+	// cir-run threads macro [pre-init macro]
+	if (argc > 3) {
+		G4String command = "/control/execute ";
+		G4String fileName = argv[3];
+		G4UImanager::GetUIpointer()->ApplyCommand(command + fileName);
+	}
+
 	// initialize G4 kernel
 	runManager->Initialize();
 
+	// physics tables of the cache (/physics/cache of the pre-init macro)
+	physicsList->BuildTables();
+
 #ifdef G4VIS_USE
 	// Initialize visualization
 	// G4VisManager* visManager = new G4VisExecutive;
@@ -100,18 +107,6 @@ int main( int argc, char** argv)
 
 	// Get the pointer to the User Interface manager
 	G4UImanager* UImanager = G4UImanager::GetUIpointer();
-/*
-	FullTracksVector clear_full, object_full;
-	MainTracksVector clear_main, object_main;
-
-	TrackReconstruction::load( "clear_full_tracks.dat", clear_full);
-	TrackReconstruction::load( "clear_main_tracks.dat", clear_main);
-	TrackReconstruction::load( "objects_full_tracks.dat", object_full);
-	TrackReconstruction::load( "objects_main_tracks.dat", object_main);
-
-	TrackReconstruction rec( object_main, object_full);
-	rec.reconstruct( clear_full, "image.root");
-*/
 	if (argc != 1) { // batch mode
 		G4String command = "/control/execute ";
 		G4String fileName = argv[2];
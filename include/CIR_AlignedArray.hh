@@ -0,0 +1,91 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <boost/noncopyable.hpp>
+
+namespace CarbonIonRadiography {
+
+// Fixed size array of POD values aligned to the cache line size,
+// so loops over it can be vectorized with aligned loads and stores.
+
+template< typename T, size_t Alignment = 64 >
+class AlignedArray : private boost::noncopyable {
+public:
+	AlignedArray() : data_(0), size_(0) {}
+	explicit AlignedArray(size_t n) : data_(0), size_(0) { resize(n); }
+	~AlignedArray() { std::free(data_); }
+
+	void resize(size_t n);
+	void clear() { resize(0); }
+	void swap(AlignedArray& src);
+
+	size_t size() const { return size_; }
+	T* data() { return data_; }
+	const T* data() const { return data_; }
+	T& operator[](size_t i) { return data_[i]; }
+	const T& operator[](size_t i) const { return data_[i]; }
+
+private:
+	T* data_;
+	size_t size_;
+};
+
+template< typename T, size_t Alignment >
+void
+AlignedArray< T, Alignment >::resize(size_t n)
+{
+	if (n == size_)
+		return;
+
+	T* data = 0;
+	if (n) {
+		void* ptr = 0;
+		if (posix_memalign( &ptr, Alignment, n * sizeof(T)))
+			throw std::bad_alloc();
+		data = static_cast<T*>(ptr);
+		size_t copy = (n < size_) ? n : size_;
+		if (copy)
+			std::memcpy( data, data_, copy * sizeof(T));
+		if (n > copy)
+			std::memset( data + copy, 0, (n - copy) * sizeof(T));
+	}
+	std::free(data_);
+	data_ = data;
+	size_ = n;
+}
+
+template< typename T, size_t Alignment >
+void
+AlignedArray< T, Alignment >::swap(AlignedArray& src)
+{
+	T* data = data_;
+	size_t size = size_;
+	data_ = src.data_;
+	size_ = src.size_;
+	src.data_ = data;
+	src.size_ = size;
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,102 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+#include <boost/noncopyable.hpp>
+
+namespace CarbonIonRadiography {
+
+// Blocking FIFO queue with limited capacity between pipeline stages.
+// push() waits while the queue is full, pop() waits while it is empty,
+// after close() pop() returns false once the queue is drained.
+
+template< typename T >
+class BoundedQueue : private boost::noncopyable {
+public:
+	explicit BoundedQueue(size_t capacity)
+		:
+		capacity_(capacity ? capacity : 1),
+		closed_(false)
+	{
+	}
+
+	// false if the queue is closed
+	bool push(T&& item);
+	// false if the queue is closed and empty
+	bool pop(T& item);
+	void close();
+
+private:
+	size_t capacity_;
+	bool closed_;
+	std::deque<T> items_;
+	std::mutex mutex_;
+	std::condition_variable not_full_;
+	std::condition_variable not_empty_;
+};
+
+template< typename T >
+bool
+BoundedQueue<T>::push(T&& item)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (!closed_ && items_.size() >= capacity_)
+		not_full_.wait(lock);
+
+	if (closed_)
+		return false;
+
+	items_.push_back(std::move(item));
+	not_empty_.notify_one();
+	return true;
+}
+
+template< typename T >
+bool
+BoundedQueue<T>::pop(T& item)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (!closed_ && items_.empty())
+		not_empty_.wait(lock);
+
+	if (items_.empty())
+		return false;
+
+	item = std::move(items_.front());
+	items_.pop_front();
+	not_full_.notify_one();
+	return true;
+}
+
+template< typename T >
+void
+BoundedQueue<T>::close()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	closed_ = true;
+	not_full_.notify_all();
+	not_empty_.notify_all();
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,64 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4VFastSimulationModel.hh>
+
+#include <map>
+#include <vector>
+
+class G4Material;
+
+namespace CarbonIonRadiography {
+
+// Fast simulation of the ions stopping in the calorimeter. The ion
+// entering the calorimeter deposits the Bragg curve of its residual range
+// (with the sampled range straggling) directly into the calorimeter slices
+// of the event and is killed, the nuclear fragmentation is left out.
+// The model is active when the /fastsim/calorimeter flag is set.
+
+class CalorimeterFastModel : public G4VFastSimulationModel {
+public:
+	CalorimeterFastModel( const G4String& name, G4Region* envelope);
+	virtual ~CalorimeterFastModel();
+
+	virtual G4bool IsApplicable(const G4ParticleDefinition&);
+	virtual G4bool ModelTrigger(const G4FastTrack&);
+	virtual void DoIt( const G4FastTrack&, G4FastStep&);
+
+private:
+	// CSDA range of the species in the material
+	struct RangeTable {
+		std::vector<G4double> energy;
+		std::vector<G4double> range;
+		G4double Range(G4double kinEnergy) const;
+		G4double Energy(G4double residualRange) const;
+	};
+	typedef std::pair< const G4ParticleDefinition*, const G4Material*> TableKey;
+
+	const RangeTable& Table( const G4ParticleDefinition*, const G4Material*);
+
+	std::map< TableKey, RangeTable> tables;
+	G4double frontZ; // front face in the calorimeter frame
+	G4double sliceThickness;
+	G4int slices;
+};
+
+} // namespace CarbonIonRadiography
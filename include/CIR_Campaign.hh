@@ -0,0 +1,69 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+#include <G4String.hh>
+
+#include <string>
+#include <vector>
+
+namespace CarbonIonRadiography {
+
+// two positive seeds of the random stream of the key, different streams
+// of one key are independent
+void random_stream_seeds( G4long key, G4long stream, long* seeds);
+
+// Campaign of the total number of events split into independent shards.
+// Shard index of count runs a contiguous range of events with seeds
+// derived only from the campaign seed and the index, so every shard can
+// be run (or rerun) alone in any process and on any node. Each shard
+// writes its output and a text manifest, cir-merge checks the manifests
+// for coverage and merges the outputs.
+
+struct ShardManifest {
+	G4long seed; // campaign seed
+	G4int index; // shard index, 0 .. count-1
+	G4int count; // number of shards
+	G4int total; // total number of events of the campaign
+	G4int first; // first event of the shard
+	G4int events; // number of events of the shard
+	G4String type; // output type: hits, tracks or projection
+	G4String output; // output file
+
+	ShardManifest();
+	ShardManifest( G4long seed, G4int index, G4int count, G4int total);
+
+	G4bool valid() const;
+	// two positive seeds of the shard random engine
+	void seeds(long* seeds) const;
+	// name.<index>.ext
+	G4String file_name( const G4String& name, const G4String& ext) const;
+
+	G4bool write(const char* filename) const;
+	static G4bool read( const char* filename, ShardManifest&);
+
+	// shards are of one campaign and cover all its events exactly once,
+	// otherwise the error describes the first problem
+	static G4bool check_coverage( const std::vector<ShardManifest>&,
+		std::string& error);
+};
+
+} // namespace CarbonIonRadiography
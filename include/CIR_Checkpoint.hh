@@ -0,0 +1,83 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+#include <G4String.hh>
+
+#include <trec_hits_positions.hh>
+
+#include <vector>
+
+namespace CarbonIonRadiography {
+
+class ProjectionGrid;
+
+// Checkpoint files of a run with the prefix:
+//   <prefix>.<generation>.<thread>.dat -- worker state (number of events,
+//     random engine status, projection grid),
+//   <prefix>.<generation>.<thread>.<segment>.dat -- hits positions recorded
+//     by the worker between two checkpoints,
+//   <prefix>.<generation>.<thread>.<segment>.ids.dat -- campaign IDs of the
+//     events recorded between two checkpoints (per event seeding only),
+//   <prefix>.base.dat, <prefix>.base.0.dat -- data of all previous runs and
+//     the generation of the worker files that belong to the current run.
+// Every file is written to a temporary file and renamed, so a killed
+// process leaves either the previous or the new checkpoint, and worker
+// files of an older generation are ignored.
+
+class Checkpoint {
+public:
+	static const G4int base = -1; // thread index of the base files
+
+	static G4String StateFile( const G4String& prefix, G4int generation,
+		G4int thread);
+	static G4String SegmentFile( const G4String& prefix, G4int generation,
+		G4int thread, G4int segment);
+	static G4String IDsFile( const G4String& prefix, G4int generation,
+		G4int thread, G4int segment);
+
+	// state of the calling thread, with its random engine status
+	static G4bool SaveState( const G4String& file, G4int events,
+		G4int segments, G4int idSegments, G4int generation,
+		const ProjectionGrid* grid);
+	static G4bool SaveHits( const G4String& file,
+		const TREC::HitsPositionsVector& hits);
+	// event IDs [begin, end)
+	static G4bool SaveIDs( const G4String& file, const G4int* begin,
+		const G4int* end);
+
+	// sum of the base and the worker checkpoints, hits and event IDs are
+	// appended (in the same order) and the grid (if not zero) is added,
+	// engines -- random engine status of all files, generation --
+	// generation of the loaded worker files
+	static G4bool Load( const G4String& prefix, G4int& events,
+		TREC::HitsPositionsVector& hits, std::vector<G4int>& ids,
+		ProjectionGrid* grid, std::string& engines, G4int& generation);
+	// save the loaded data as the base of the next generation
+	static G4bool SaveBase( const G4String& prefix, G4int events,
+		const TREC::HitsPositionsVector& hits, const std::vector<G4int>& ids,
+		const ProjectionGrid* grid, G4int generation);
+	// remove the worker files up to the generation and the base files
+	static void Remove( const G4String& prefix, G4int generation,
+		G4bool withBase = true);
+};
+
+} // namespace CarbonIonRadiography
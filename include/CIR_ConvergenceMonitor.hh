@@ -0,0 +1,116 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <vector>
+
+#include "CIR_Histogram2D.hh"
+
+namespace CarbonIonRadiography {
+
+// Adaptive end of the run (projection mode only): every worker keeps
+// the running mean and variance (Welford) of the stopping positions in
+// the image pixels and adds them to the shared statistics every interval
+// events (parallel update of Chan et al.), then the shared statistics are
+// checked. The run stops when the standard error of the mean position
+// (in calorimeter slices) is under the target in every pixel of the
+// region. A pixel of an explicit region with tracks but fewer than the
+// minimal number keeps the run going; without a region the pixels of the
+// beam tails, with a fluence under a fraction of the maximal one, are
+// skipped. /run/beamOn events is the cap. The settings are set by the
+// master between runs.
+
+class ConvergenceMonitor : private boost::noncopyable {
+public:
+	// running statistics of the pixels of the image
+	class Statistics {
+	public:
+		Statistics( const HistogramAxis& x, const HistogramAxis& y);
+
+		void Fill( G4double x, G4double y, G4double value);
+		// adds the statistics of the same binning
+		void Add(const Statistics& other);
+		void Clear();
+
+		const HistogramAxis& AxisX() const { return axisX; }
+		const HistogramAxis& AxisY() const { return axisY; }
+		G4double Count(G4int bin) const { return count[bin]; }
+		G4double Mean(G4int bin) const { return mean[bin]; }
+		// unbiased variance, zero with less than 2 entries
+		G4double Variance(G4int bin) const;
+
+	private:
+		HistogramAxis axisX;
+		HistogramAxis axisY;
+		// bins of the image with underflow and overflow,
+		// index by * (x bins + 2) + bx
+		std::vector<G4double> count;
+		std::vector<G4double> mean;
+		std::vector<G4double> m2; // sum of squared deviations
+	};
+
+	static ConvergenceMonitor* Instance();
+
+	// target standard error of the mean position in slices, zero -- off
+	void SetTarget(G4double relative) { target = relative; }
+	G4bool IsEnabled() const { return target > 0.0; }
+	G4double Target() const { return target; }
+	// events of a worker between two updates of the shared statistics
+	void SetInterval(G4int events) { interval = (events > 0) ? events : 1; }
+	G4int Interval() const { return interval; }
+	// tracks of a pixel needed to estimate its error
+	void SetMinEntries(G4int n) { minEntries = n; }
+	// region of interest in the image plane, empty -- the whole image
+	void SetRegion( G4double xMin, G4double xMax, G4double yMin,
+		G4double yMax);
+
+	// shared statistics, reset by the master before the run
+	void Reset();
+	// adds the statistics of a worker, clears them and checks the target
+	void Update(Statistics& local);
+	G4bool IsConverged() const { return converged.load(std::memory_order_relaxed); }
+	// largest error (slices) of the region at the last check,
+	// negative -- a pixel of the region has too few tracks
+	G4double Uncertainty() const { return uncertainty; }
+
+private:
+	ConvergenceMonitor();
+
+	// largest error of the pixels of the region, negative if a pixel
+	// needs more tracks
+	G4double RegionUncertainty() const;
+
+	G4double target;
+	G4int interval;
+	G4int minEntries;
+	G4double regionX[2]; // G4 length units
+	G4double regionY[2];
+
+	Statistics total;
+	G4double uncertainty;
+	std::atomic<G4bool> converged;
+};
+
+} // namespace CarbonIonRadiography
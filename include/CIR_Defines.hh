@@ -19,6 +19,8 @@
 
 #pragma once
 
+// Default detector geometry, GeometryConfig changes it at run time
+
 #define CIR_ENERGY_PER_NUCLEON 455
 
 #define CIR_NUMBER_OF_SILICON_DETECTORS 8
@@ -51,3 +53,8 @@
 #define CIR_SIZE_SILICON_STRIP 200
 #define CIR_SIZE_SILICON_THICKNESS 300
 #define CIR_SIZE_CALORIMETER_SLICE_THICKNESS 1500
+
+// Resolution of the XY1, XY2 and XY3 planes in the track fits, um
+#define CIR_SIGMA_XY1 58
+#define CIR_SIGMA_XY2 94
+#define CIR_SIGMA_XY3 1000
@@ -20,6 +20,11 @@
 #pragma once
 
 #include <G4VUserDetectorConstruction.hh>
+#include <G4ThreeVector.hh>
+#include <G4RotationMatrix.hh>
+
+#include <map>
+#include <vector>
 
 #include "CIR_Defines.hh"
 #include <trec_strip_geometry.hh>
@@ -37,6 +42,7 @@ namespace CarbonIonRadiography {
 
 class ParallelWorld;
 class DetectorMessenger;
+class VoxelPhantom;
 
 class DetectorConstruction : public G4VUserDetectorConstruction {
 
@@ -49,16 +55,53 @@ public:
 	virtual void ConstructSDandField();
 	void UpdateGeometry();
 
+	// load the voxelized phantom and select it
+	G4bool SetVoxelPhantom(const G4String& header);
+	void SetPhantomPosition(const G4ThreeVector& position);
+	// rotation of the phantom around the vertical axis (Y) in addition to
+	// its construction rotation, the projection angle of a CT acquisition
+	void SetPhantomAngle(G4double angle);
+	G4double GetPhantomAngle() const { return phantomAngle; }
+
+	// phantom of the catalog, in the Idle state it replaces the phantom
+	// of the built geometry without the physics reinitialization
+	G4bool SelectPhantom(const G4String& name);
+	// names of the catalog phantoms
+	static G4String PhantomNames();
+
 private:
+	// sizes of the run geometry
+	void ReadGeometryConfig();
 	void ConstructWorld();
 	void ConstructSiliconPlane( G4int pos, const TREC::StripGeometryPair&);
 	void ConstructCalorimeter(G4double offset_z);
 	void ConstructSiliconDetectors();
-	void ConstructObject();
 
-	DetectorMessenger* detectorMessenger; // for future use
+	// catalog phantom placed into the world, 0 for "none"
+	G4VPhysicalVolume* ConstructPhantom(const G4String& name);
+	G4VPhysicalVolume* ConstructCylinderPhantom();
+	G4VPhysicalVolume* ConstructWaterMusclePhantom();
+	G4VPhysicalVolume* ConstructSpherePhantom();
+	G4VPhysicalVolume* ConstructBoxPhantom();
+	// place the selected phantom into the world instead of the current one
+	void PlacePhantom();
+	// construction rotation of the placed phantom turned by the angle
+	void RotatePhantom();
+
+	DetectorMessenger* detectorMessenger;
 	ParallelWorld* parallelWorld;
 
+	VoxelPhantom* voxelPhantom;
+	G4String phantomName;
+	// built phantoms, the selected one is placed into the world
+	std::map< G4String, G4VPhysicalVolume*> phantomVolumes;
+	G4VPhysicalVolume* phantomPhysicalVolume;
+	G4ThreeVector phantomPosition;
+	G4double phantomAngle;
+	// construction and current rotations of the built phantoms
+	std::map< G4String, G4RotationMatrix> phantomBaseRotations;
+	std::map< G4String, G4RotationMatrix> phantomRotations;
+
 	G4Box* worldBox;
 	G4LogicalVolume* worldLogicalVolume;
 	G4VPhysicalVolume* worldPhysicalVolume;
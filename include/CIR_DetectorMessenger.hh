@@ -0,0 +1,56 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4UImessenger.hh>
+#include <globals.hh>
+
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithADoubleAndUnit;
+
+namespace CarbonIonRadiography {
+
+class DetectorConstruction;
+
+class DetectorMessenger : public G4UImessenger {
+public:
+	DetectorMessenger(DetectorConstruction*);
+	virtual ~DetectorMessenger();
+	void SetNewValue( G4UIcommand*, G4String);
+
+private:
+	DetectorConstruction* detector;
+
+	G4UIdirectory* detector_dir;
+	G4UIcmdWithAString* load_cmd;
+	G4UIcmdWithAString* set_cmd;
+	G4UIcmdWithoutParameter* print_cmd;
+
+	G4UIdirectory* phantom_dir;
+	G4UIcmdWithAString* select_cmd;
+	G4UIcmdWithAString* voxels_cmd;
+	G4UIcmdWith3VectorAndUnit* position_cmd;
+	G4UIcmdWithADoubleAndUnit* angle_cmd;
+};
+
+} // namespace CarbonIonRadiography
@@ -24,6 +24,7 @@
 
 #include "CIR_Track.hh"
 #include "CIR_HitCoordinates.hh"
+#include "CIR_RayCaster.hh"
 
 namespace CarbonIonRadiography {
 
@@ -40,6 +41,35 @@ public:
 	void update();
 	TREC::HitsPositions getPositions() const { return positions; }
 
+	// projection mode: tracks are fitted here, hits positions aren't kept
+	void setProjectionMode(G4bool flag) { projection_mode = flag; }
+	G4bool projectionMode() const { return projection_mode; }
+	// full track of the last event in the plane between XY2 and XY3 (um)
+	G4bool hasTrack() const { return track_ok; }
+	G4double trackX() const { return track_x; }
+	G4double trackY() const { return track_y; }
+	G4int trackPosition() const { return track_position; }
+
+	// fast simulation of the ions stopping in the calorimeter
+	void setCaloFastSimulation(G4bool flag) { calo_fast_simulation = flag; }
+	G4bool caloFastSimulation() const { return calo_fast_simulation; }
+	// energy deposit of the fast simulation in the calorimeter slice
+	void addCaloEnergy( G4int slice, G4double energy) {
+		coordinates.calo[slice] += energy;
+	}
+	// fast simulation of the silicon planes
+	void setSiliconFastSimulation(G4bool flag) { silicon_fast_simulation = flag; }
+	G4bool siliconFastSimulation() const { return silicon_fast_simulation; }
+	// energy deposit of the fast simulation in the strip of the plane pos
+	void addSiliconEnergy( G4int pos, G4int strip, G4double energy);
+
+	// ray casting mode: primaries aren't transported, their rays are kept
+	void setRayCastMode(G4bool flag) { ray_cast_mode = flag; }
+	G4bool rayCastMode() const { return ray_cast_mode; }
+	void setRay(const RayRecord& record) { ray = record; ray_ok = true; }
+	G4bool hasRay() const { return ray_ok; }
+	const RayRecord& getRay() const { return ray; }
+
 private:
 	G4bool fillEnergyCoordinates( G4int pos, G4THitsMap<G4double>* energy);
 	EventActionMessenger* event_action_messenger;
@@ -52,6 +82,19 @@ private:
 	G4double threshold_energy_calo_slice;
 	G4double threshold_energy_si_strips;
 	G4int mod;
+
+	G4bool projection_mode;
+	G4bool track_ok;
+	G4double track_x;
+	G4double track_y;
+	G4int track_position;
+
+	G4bool calo_fast_simulation;
+	G4bool silicon_fast_simulation;
+
+	G4bool ray_cast_mode;
+	G4bool ray_ok;
+	RayRecord ray;
 };
 
 } // namespace CarbonIonRadiography
@@ -25,6 +25,7 @@
 class G4UIdirectory;
 class G4UIcmdWithADoubleAndUnit;
 class G4UIcmdWithoutParameter; 
+class G4UIcmdWithABool;
 
 namespace CarbonIonRadiography {
 
@@ -43,6 +44,14 @@ private:
 	G4UIcmdWithADoubleAndUnit* thres_calo_slice_cmd;
 	G4UIcmdWithADoubleAndUnit* thres_si_strips_cmd;
 	G4UIcmdWithoutParameter* update_cmd;
+
+	G4UIdirectory* output_dir;
+	G4UIcmdWithABool* projection_cmd;
+	G4UIcmdWithABool* raycast_cmd;
+
+	G4UIdirectory* fastsim_dir;
+	G4UIcmdWithABool* fast_calo_cmd;
+	G4UIcmdWithABool* fast_silicon_cmd;
 };
 
 } // namespace CarbonIonRadiography
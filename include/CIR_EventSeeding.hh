@@ -0,0 +1,59 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <vector>
+
+namespace CarbonIonRadiography {
+
+// Per event seeding: the random engine of the thread which generates
+// an event is reseeded from the run seed and the event ID, so the event
+// doesn't depend on the thread it is dealt to and on the number of
+// threads. The settings are changed by the master between runs only.
+
+class EventSeeding {
+public:
+	static void SetEnabled(G4bool flag) { enabled = flag; }
+	static G4bool IsEnabled() { return enabled; }
+	static void SetRunSeed(G4long seed) { runSeed = seed; }
+	static G4long RunSeed() { return runSeed; }
+	// ID of the first event of the run in the campaign
+	static void SetEventOffset(G4int offset) { eventOffset = offset; }
+	static G4int EventOffset() { return eventOffset; }
+	// campaign IDs of the events of the run instead of the offset, e.g.
+	// the events missing from a checkpoint; empty -- the offset
+	static void SetEventIDs(const std::vector<G4int>& ids) { eventIDs = ids; }
+
+	static G4int GlobalEventID(G4int eventID) {
+		return eventIDs.empty() ? eventOffset + eventID : eventIDs[eventID];
+	}
+	// reseed the engine of the calling thread for the event
+	static void Reseed(G4int eventID);
+
+private:
+	static G4bool enabled;
+	static G4long runSeed;
+	static G4int eventOffset;
+	static std::vector<G4int> eventIDs;
+};
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,87 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include "CIR_Histogram2D.hh"
+
+class TH2D;
+class TH3D;
+
+namespace CarbonIonRadiography {
+
+// Parallel beam filtered back-projection of the CT acquisition. The phantom
+// rotates around the vertical axis, so every detector row v of the
+// projection images is the sinogram of one slice of the volume, and the
+// slices are reconstructed independently by the threads.
+//
+// The ramp (Ram-Lak) filter is applied with the GSL radix-2 FFT of the
+// zero padded rows, its frequency response is computed once for the row
+// size. The back-projection runs over tiles of the slice, so a tile and
+// the filtered rows stay in the cache while all projections are added.
+
+class FilteredBackProjection : private boost::noncopyable {
+public:
+	// detector axes of the projection images (um): u -- across the rotation
+	// axis (X), v -- along it (Y)
+	FilteredBackProjection( const HistogramAxis& u, const HistogramAxis& v);
+
+	// number of reconstruction threads, zero -- all hardware threads
+	void set_threads(G4int threads) { threads_ = threads; }
+	G4int threads() const { return threads_; }
+
+	// mean value (sum / count) image of the projection at the angle (rad)
+	// of the phantom, pixels without tracks are zero
+	G4bool add_projection( G4double angle, const Histogram2D<G4double>& image);
+	G4int projections() const { return G4int(angles_.size()); }
+
+	// volume of v slices of u x u pixels, index (slice * u + z) * u + x,
+	// values per mm of the projection values (e.g. RSP of WEPL in mm)
+	void reconstruct(std::vector<G4double>& volume) const;
+
+	TH3D* create_volume( const char* name, const char* title,
+		const std::vector<G4double>& volume) const;
+	TH2D* create_sinogram( const char* name, const char* title,
+		G4int slice) const;
+
+private:
+	// ramp filter of the rows of the slice sinogram in place
+	void filter(std::vector<G4double>& sinogram) const;
+	void back_project( const std::vector<G4double>& sinogram,
+		G4double* slice) const;
+
+	HistogramAxis u_;
+	HistogramAxis v_;
+	G4int threads_;
+	std::vector<G4double> angles_;
+	// slice sinograms, [slice][projection * u + bin]
+	std::vector< std::vector<G4double> > sinograms_;
+	// padded row size, power of 2
+	size_t fft_size_;
+	// real response of the filter (halfcomplex indices 0 ... fft_size / 2)
+	std::vector<G4double> response_;
+};
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,107 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+#include <G4String.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include "CIR_StripGeometry.hh"
+
+namespace CarbonIonRadiography {
+
+// Detector geometry of the run. The defaults are the values of
+// CIR_Defines.hh and of the strip geometry table, a text file or the
+// /detector/ commands change them before the geometry is constructed, so
+// variants of the geometry are run by one binary.
+//
+// File and command keys (units of CIR_Defines.hh):
+//   energy_per_nucleon MeV
+//   beam_distance mm
+//   world_size mm
+//   silicon_size mm
+//   silicon_thickness um
+//   silicon_strips n
+//   calorimeter_size mm
+//   calorimeter_thickness mm
+//   calorimeter_slice_thickness um
+//   first_plane_sigma um -- resolution of the XY1 planes in the track fits
+//   second_plane_sigma um -- XY2 planes
+//   third_plane_sigma um -- XY3 planes, also the trajectory check
+//   plane name z(um) angle(degree), name: Y1 X1 Y2 X2 Y3 X3 U V
+
+class GeometryConfig : private boost::noncopyable {
+public:
+	static GeometryConfig& instance();
+
+	// "key value" lines, '#' -- comment
+	G4bool load(const G4String& filename);
+	// false for unknown key or wrong value
+	G4bool set( const G4String& key, const G4String& value);
+	void print() const;
+
+	// Geant4 units
+	G4double energy_per_nucleon() const { return energy_per_nucleon_; }
+	G4double beam_distance() const { return beam_distance_; }
+	G4double world_size() const { return world_size_; } // full size
+	G4double silicon_size() const { return silicon_size_; } // full size
+	G4double silicon_thickness() const { return silicon_thickness_; }
+	G4double strip_pitch() const { return silicon_size_ / silicon_strips_; }
+	G4int silicon_strips() const { return silicon_strips_; }
+	G4double calorimeter_size() const { return calorimeter_size_; } // full size
+	G4double calorimeter_thickness() const { return calorimeter_thickness_; }
+	G4double calorimeter_slice_thickness() const {
+		return calorimeter_slice_thickness_;
+	}
+	G4int calorimeter_slices() const;
+	// resolution of the XY1, XY2, XY3 planes, the weights of the track fits
+	G4double first_plane_sigma() const { return first_plane_sigma_; }
+	G4double second_plane_sigma() const { return second_plane_sigma_; }
+	G4double third_plane_sigma() const { return third_plane_sigma_; }
+
+	// plane geometry with the strip geometry units (um, degree)
+	G4int planes() const { return G4int(planes_.size()); }
+	const StripGeometry& plane(G4int pos) const { return planes_[pos]; }
+	const StripGeometry& plane(StripGeometryType type) const;
+
+private:
+	GeometryConfig();
+	// silicon parameters of the planes
+	void update_planes();
+
+	G4double energy_per_nucleon_;
+	G4double beam_distance_;
+	G4double world_size_;
+	G4double silicon_size_;
+	G4double silicon_thickness_;
+	G4int silicon_strips_;
+	G4double calorimeter_size_;
+	G4double calorimeter_thickness_;
+	G4double calorimeter_slice_thickness_;
+	G4double first_plane_sigma_;
+	G4double second_plane_sigma_;
+	G4double third_plane_sigma_;
+	std::vector<StripGeometry> planes_;
+};
+
+} // namespace CarbonIonRadiography
@@ -48,5 +48,9 @@ const char* const CalorimeterDivisionParallelStr = "CalorimeterDivisionParallel"
 const char* const CalorimeterLogDivisionParallelStr = "CalorimeterLogDivisionParallel";
 const char* const CalorimeterPhysDivisionParallelStr = "CalorimeterPhysDivisionParallel";
 const char* const CalorimeterSensitiveDetectorStr = "SensitiveDetectorCalorimeter";
+const char* const CalorimeterFastModelStr = "CalorimeterFastModel";
+const char* const SiliconFastModelStr = "SiliconFastModel";
+
+const char* const FastSimulationProcessStr = "FastSimulationProcess";
 
 } // namespace CarbonIonRadiography
@@ -0,0 +1,233 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <TH2.h>
+
+#include <vector>
+#include <cmath>
+
+namespace CarbonIonRadiography {
+
+// Fixed bins of an axis: bins in range [min, max)
+struct HistogramAxis {
+	HistogramAxis( G4int n = 1, G4double low = 0.0, G4double high = 1.0)
+		:
+		bins(n),
+		min(low),
+		max(high)
+	{
+	}
+	// inverse bin width
+	G4double scale() const { return bins / (max - min); }
+	// same as TAxis::FindBin: 0 -- underflow, bins + 1 -- overflow
+	G4int find_bin(G4double x) const;
+	// same with the precomputed inverse bin width
+	G4int find_bin( G4double x, G4double scale) const;
+
+	G4int bins;
+	G4double min;
+	G4double max;
+};
+
+inline
+G4int
+HistogramAxis::find_bin(G4double x) const
+{
+	if (x < min)
+		return 0;
+	else if (!(x < max))
+		return bins + 1;
+	return 1 + G4int(bins * (x - min) / (max - min));
+}
+
+inline
+G4int
+HistogramAxis::find_bin( G4double x, G4double scale) const
+{
+	if (x < min)
+		return 0;
+	else if (!(x < max))
+		return bins + 1;
+
+	G4int bin = 1 + G4int((x - min) * scale);
+	return (bin > bins) ? bins : bin;
+}
+
+// Dense 2D accumulator with the bin layout of TH2D (bin 0 -- underflow,
+// bin n + 1 -- overflow), keeps sum, count and sum of squares of every bin
+// in one contiguous array. It is filled in the track loops instead of TH2D
+// and converted to TH2D only for the output.
+
+template< typename T = G4double >
+class Histogram2D {
+public:
+	struct Bin {
+		Bin() : sum(0), count(0), sum2(0) {}
+		T sum;
+		T count;
+		T sum2;
+	};
+
+	enum Content {
+		content_sum,
+		content_count
+	};
+
+	Histogram2D( const HistogramAxis& x, const HistogramAxis& y);
+
+	G4int find_bin( G4double x, G4double y) const;
+	void fill( G4double x, G4double y, T w = T(1));
+	void fill_bin( G4int bin, T w = T(1));
+	// add n entries with the sum of values sum and the sum of squares sum2
+	void add_bin( G4int bin, T sum, T count, T sum2);
+	void add(const Histogram2D& src);
+	void reset();
+
+	const HistogramAxis& axis_x() const { return x_; }
+	const HistogramAxis& axis_y() const { return y_; }
+	// number of bins with underflow and overflow
+	G4int cells() const { return cells_x_ * cells_y_; }
+	const Bin& bin(G4int bin) const { return bins_[bin]; }
+	const Bin& bin( G4int bx, G4int by) const { return bins_[bx + cells_x_ * by]; }
+	T entries() const;
+
+	TH2D* create_histogram( const char* name, const char* title,
+		Content content = content_sum, G4double scale = 1.0) const;
+
+private:
+	HistogramAxis x_;
+	HistogramAxis y_;
+	G4double x_scale_; // inverse bin width
+	G4double y_scale_; // inverse bin width
+	G4int cells_x_;
+	G4int cells_y_;
+	std::vector<Bin> bins_;
+};
+
+template< typename T >
+Histogram2D<T>::Histogram2D( const HistogramAxis& x, const HistogramAxis& y)
+	:
+	x_(x),
+	y_(y),
+	x_scale_(x.scale()),
+	y_scale_(y.scale()),
+	cells_x_(x.bins + 2),
+	cells_y_(y.bins + 2),
+	bins_((x.bins + 2) * (y.bins + 2))
+{
+}
+
+template< typename T >
+inline
+G4int
+Histogram2D<T>::find_bin( G4double x, G4double y) const
+{
+	G4int bx = x_.find_bin( x, x_scale_);
+	G4int by = y_.find_bin( y, y_scale_);
+	return bx + cells_x_ * by;
+}
+
+template< typename T >
+inline
+void
+Histogram2D<T>::fill_bin( G4int bin, T w)
+{
+	Bin& b = bins_[bin];
+	b.sum += w;
+	b.count += T(1);
+	b.sum2 += w * w;
+}
+
+template< typename T >
+inline
+void
+Histogram2D<T>::add_bin( G4int bin, T sum, T count, T sum2)
+{
+	Bin& b = bins_[bin];
+	b.sum += sum;
+	b.count += count;
+	b.sum2 += sum2;
+}
+
+template< typename T >
+inline
+void
+Histogram2D<T>::fill( G4double x, G4double y, T w)
+{
+	fill_bin( find_bin( x, y), w);
+}
+
+template< typename T >
+void
+Histogram2D<T>::add(const Histogram2D& src)
+{
+	for ( size_t i = 0; i < bins_.size(); ++i) {
+		bins_[i].sum += src.bins_[i].sum;
+		bins_[i].count += src.bins_[i].count;
+		bins_[i].sum2 += src.bins_[i].sum2;
+	}
+}
+
+template< typename T >
+void
+Histogram2D<T>::reset()
+{
+	bins_.assign( bins_.size(), Bin());
+}
+
+template< typename T >
+T
+Histogram2D<T>::entries() const
+{
+	T entries = T(0);
+	for ( size_t i = 0; i < bins_.size(); ++i)
+		entries += bins_[i].count;
+	return entries;
+}
+
+template< typename T >
+TH2D*
+Histogram2D<T>::create_histogram( const char* name, const char* title,
+	Content content, G4double scale) const
+{
+	TH2D* hist = new TH2D( name, title,
+		x_.bins, x_.min, x_.max, y_.bins, y_.min, y_.max);
+
+	for ( G4int by = 0; by < cells_y_; ++by) {
+		for ( G4int bx = 0; bx < cells_x_; ++bx) {
+			const Bin& b = bin( bx, by);
+			if (content == content_sum) {
+				hist->SetBinContent( bx, by, b.sum * scale);
+				hist->SetBinError( bx, by, std::sqrt(G4double(b.sum2)) * scale);
+			}
+			else {
+				hist->SetBinContent( bx, by, b.count * scale);
+				hist->SetBinError( bx, by, std::sqrt(G4double(b.count)) * scale);
+			}
+		}
+	}
+	hist->SetEntries(entries());
+	return hist;
+}
+
+} // namespace CarbonIonRadiography
@@ -38,7 +38,9 @@ struct RawHitCoordinates {
 
 class FinalHitCoordinates {
 public:
-	FinalHitCoordinates(RawHitCoordinates& raw_hits);
+	// energy thresholds of a silicon strip and of a calorimeter slice
+	FinalHitCoordinates( RawHitCoordinates& raw_hits,
+		G4double threshold_strips, G4double threshold_slice);
 //	FinalHitCoordinates(const FinalHitCoordinates& src);
 //	FinalHitCoordinates& operator=(const FinalHitCoordinates& src);
 	
@@ -62,6 +64,9 @@ private:
 	void calculateMainTrack(G4bool);
 	void calculateFullTrack(G4bool);
 
+	G4double threshold_si; // energy threshold of silicon strips
+	G4double threshold_calo; // energy threshold of calorimeter slices
+
 	std::pair< G4double, G4double> xy1; // coordinate
 	std::pair< G4bool, G4bool> xy1_ok; // state
 	std::pair< G4double, G4double> xy2; // coordinate
@@ -0,0 +1,115 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include "CIR_Track.hh"
+#include "CIR_AlignedArray.hh"
+
+namespace CarbonIonRadiography {
+
+// Most likely path of the ions through the object slab [z_in, z_out] (um)
+// of water, the Bayesian MLP of Schulte et al. (2008) with the tracker
+// uncertainties of Krah et al. (2018). The entrance state (position and
+// direction) is the main track (xy1-xy2) in z_in, the exit state is the
+// chord from the xy2 hit to the xy3 hit in z_out.
+//
+// The scattering and measurement covariances depend only on the slab,
+// the planes, the ion and the beam energy, so the path at every depth step
+// is a fixed linear combination of the entrance and exit states. The
+// coefficients are computed once, a path position is four multiplications
+// per step and axis, and paths of a block of ions are one vectorized loop.
+
+class MostLikelyPath : private boost::noncopyable {
+public:
+	MostLikelyPath( G4double z_in, G4double z_out, G4int steps,
+		G4int charge = 6, G4int nucleons = 12);
+
+	G4double z_in() const { return z_in_; }
+	G4double z_out() const { return z_out_; }
+	G4int steps() const { return steps_; }
+	// length of a step (um)
+	G4double step_length() const { return (z_out_ - z_in_) / steps_; }
+	// depth of the step center (um)
+	G4double depth(G4int step) const {
+		return z_in_ + (step + 0.5) * step_length();
+	}
+
+	// entrance and exit states of the X (true) or Y (false) tracks:
+	// positions (um) in z_in and z_out and directions (rad)
+	void states( G4bool type, const Track& main, const Track& full,
+		G4double& x0, G4double& t0, G4double& x1, G4double& t1) const;
+
+	// positions of n paths at the step, states of the paths one by one
+	void estimate( G4int step, const G4double* x0, const G4double* t0,
+		const G4double* x1, const G4double* t1, size_t n, G4double* out) const;
+
+private:
+	// 2x2 symmetric covariance
+	struct Covariance {
+		Covariance( G4double x = 0.0, G4double c = 0.0, G4double t = 0.0)
+			: xx(x), xt(c), tt(t) {}
+		G4double xx;
+		G4double xt;
+		G4double tt;
+	};
+
+	void precompute( G4int charge, G4int nucleons);
+	// scattering covariances from z_in to the step center and from
+	// the step center to z_out
+	void scattering( G4int step, Covariance& in, Covariance& out) const;
+
+	G4double z_in_;
+	G4double z_out_;
+	G4int steps_;
+	// planes z (um) of X (0) and Y (1) tracks
+	G4double z1_[2], z2_[2], z3_[2];
+	// scattering power (rad^2/um) of the integration bins
+	std::vector<G4double> power_;
+	// first rows of the entrance and exit coefficient matrices of the steps
+	AlignedArray<G4double> in_x_, in_t_, out_x_, out_t_;
+};
+
+inline
+void
+MostLikelyPath::estimate( G4int step, const G4double* x0, const G4double* t0,
+	const G4double* x1, const G4double* t1, size_t n, G4double* out) const
+{
+	const G4double a0 = in_x_[step];
+	const G4double a1 = in_t_[step];
+	const G4double b0 = out_x_[step];
+	const G4double b1 = out_t_[step];
+
+	const G4double* __restrict__ px0 = x0;
+	const G4double* __restrict__ pt0 = t0;
+	const G4double* __restrict__ px1 = x1;
+	const G4double* __restrict__ pt1 = t1;
+	G4double* __restrict__ x = out;
+
+	for ( size_t i = 0; i < n; ++i)
+		x[i] = a0 * px0[i] + a1 * pt0[i] + b0 * px1[i] + b1 * pt1[i];
+}
+
+} // namespace CarbonIonRadiography
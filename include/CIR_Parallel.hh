@@ -0,0 +1,84 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <thread>
+#include <vector>
+
+namespace CarbonIonRadiography {
+
+// Number of threads to use, zero or negative value -- all hardware threads
+inline
+G4int
+hardware_threads(G4int threads = 0)
+{
+	if (threads > 0)
+		return threads;
+
+	G4int n = std::thread::hardware_concurrency();
+	return (n > 0) ? n : 1;
+}
+
+// Number of threads parallel_for runs for n elements
+inline
+G4int
+parallel_threads( size_t n, G4int threads)
+{
+	threads = hardware_threads(threads);
+	if (size_t(threads) > n)
+		threads = (n > 0) ? G4int(n) : 1;
+	return threads;
+}
+
+// Split range [0, n) into contiguous chunks, one chunk per thread, and call
+// func( thread, begin, end) for every chunk in its own thread. The chunks
+// depend only on n and the number of threads, so results reduced in the
+// thread order are reproducible.
+template< typename Function >
+void
+parallel_for( size_t n, G4int threads, Function func)
+{
+	threads = parallel_threads( n, threads);
+
+	size_t chunk = n / threads;
+	size_t rest = n % threads;
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+
+	size_t begin = 0;
+	size_t first_end = chunk + (rest > 0 ? 1 : 0);
+	size_t end = first_end;
+	for ( G4int t = 1; t < threads; ++t) {
+		begin = end;
+		end = begin + chunk + (size_t(t) < rest ? 1 : 0);
+		workers.push_back(std::thread( func, t, begin, end));
+	}
+
+	// the first chunk in the calling thread
+	func( 0, size_t(0), first_end);
+
+	for ( size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+}
+
+} // namespace CarbonIonRadiography
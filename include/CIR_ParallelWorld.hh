@@ -38,6 +38,8 @@ public:
 
 private:
 
+	// sizes of the run geometry
+	void ReadGeometryConfig();
 	void ConstructSiliconPlane( G4int pos, const TREC::StripGeometryPair&);
 	void ConstructCalorimeter(G4double offset);
 
@@ -0,0 +1,85 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+#include <G4String.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+
+namespace CarbonIonRadiography {
+
+// Phase space file:
+//   "CIRPHSP1" magic, number of records (unsigned 64 bit),
+//   records of PhaseSpaceRecord.
+struct PhaseSpaceRecord {
+	G4float x, y, z; // position (mm)
+	G4float dx, dy, dz; // direction
+	G4float energy; // kinetic energy (MeV)
+	G4float weight;
+	G4int pdg; // PDG code, ions 100ZZZAAA0
+};
+
+// Read only phase space file mapped into memory once and shared by all
+// threads, so the records are never copied into the workers. The threads
+// claim disjoint chunks of records through an atomic cursor, the file is
+// replayed from the beginning when the cursor passes the end. The file is
+// opened by the master between runs; every open gets a new generation, so
+// the threads drop the chunks claimed from a previous file even if the new
+// phase space has the same address.
+
+class PhaseSpace : private boost::noncopyable {
+public:
+	~PhaseSpace();
+
+	// map the file (master only, between runs), the same file is mapped
+	// only once; an empty name unmaps the file
+	static G4bool Open(const G4String& filename);
+	// the mapped phase space, zero if none
+	static PhaseSpace* Instance() { return instance; }
+
+	const G4String& FileName() const { return fileName; }
+	// number of the open of the file, from 1
+	unsigned long Generation() const { return generation; }
+	unsigned long long Size() const { return size; }
+	const PhaseSpaceRecord& Record(unsigned long long i) const { return records[i % size]; }
+
+	// claim next chunk [begin, end) of the records
+	void Claim( unsigned long long chunk, unsigned long long& begin,
+		unsigned long long& end);
+
+private:
+	PhaseSpace();
+
+	static PhaseSpace* instance;
+	static unsigned long generations;
+
+	G4String fileName;
+	unsigned long generation;
+	void* mapping;
+	size_t mappingSize;
+	const PhaseSpaceRecord* records;
+	unsigned long long size;
+	std::atomic<unsigned long long> cursor;
+};
+
+} // namespace CarbonIonRadiography
@@ -26,6 +26,8 @@ class G4VPhysicsConstructor;
 
 namespace CarbonIonRadiography {
 
+class PhysicsListMessenger;
+
 class PhysicsList : public G4VModularPhysicsList {
 public:
 	PhysicsList();
@@ -35,8 +37,23 @@ public:
 	virtual void ConstructProcess();
 	virtual void SetCuts();
 	void AddPhysicsList(const G4String& name);
+
+	// Directory of the physics table cache, empty -- no cache
+	void SetTableCache(const G4String& dir) { tableCache = dir; }
+	// Build the physics tables after the initialization, retrieve them
+	// from the cache if it has the tables of the same physics and materials
+	void BuildTables();
+	// WEPL calibration of the calorimeter stopping position of the ion
+	// (Z, A) with the energy of the geometry, from the stopping powers
+	// of water and of the calorimeter material (see CIR_WeplCalibration.hh)
+	G4bool WriteWeplTable( const G4String& filename, G4int Z, G4int A);
 private:
 	void AddStepMax();
+	// physics configuration and material set of the cached tables
+	G4String TableDescription() const;
+
+	PhysicsListMessenger* messenger;
+	G4String tableCache;
 
 	G4EmConfigurator em_config;
 
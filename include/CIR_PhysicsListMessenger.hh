@@ -0,0 +1,47 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4UImessenger.hh>
+#include <globals.hh>
+
+class G4UIdirectory;
+class G4UIcmdWithAString;
+class G4UIcommand;
+
+namespace CarbonIonRadiography {
+
+class PhysicsList;
+
+class PhysicsListMessenger : public G4UImessenger {
+public:
+	PhysicsListMessenger(PhysicsList*);
+	virtual ~PhysicsListMessenger();
+	void SetNewValue( G4UIcommand*, G4String);
+
+private:
+	PhysicsList* physics;
+
+	G4UIdirectory* physics_dir;
+	G4UIcmdWithAString* cache_cmd;
+	G4UIcommand* wepl_table_cmd;
+};
+
+} // namespace CarbonIonRadiography
@@ -23,9 +23,13 @@
 #include <G4ParticleGun.hh>
 
 class G4Event;
+class G4ParticleDefinition;
 
 namespace CarbonIonRadiography {
-	
+
+class PhaseSpace;
+class PrimaryGeneratorMessenger;
+
 /// The primary generator action class with particle gun
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction {
@@ -36,10 +40,29 @@ public:
 	// method from the base class
 	virtual void GeneratePrimaries(G4Event*);
 
+	// number of phase space records claimed by the thread at once
+	void SetPhaseSpaceChunk(G4int chunk) { phaseSpaceChunk = chunk; }
+
 private:
 	void SetDefaultPrimaryParticle();
+	void SetIonBeam();
+	void SetPhaseSpacePrimary( PhaseSpace*, G4Event*);
+	void SetRasterPrimary(G4Event*);
+	G4ParticleDefinition* FindParticle(G4int pdg);
 
 	G4ParticleGun* gun;
+	PrimaryGeneratorMessenger* messenger;
+	G4bool ionBeam; // the gun is set to the carbon ion beam
+
+	// chunk of phase space records claimed by the thread from the
+	// generation of the phase space
+	unsigned long phaseSpaceGeneration;
+	G4int phaseSpaceChunk;
+	unsigned long long chunkBegin, chunkEnd;
+
+	// particle of the last phase space record
+	G4int particlePDG;
+	G4ParticleDefinition* particle;
 };
 
 } // namespace CarbonIonRadiography
@@ -0,0 +1,130 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <vector>
+#include <iostream>
+
+#include "CIR_Histogram2D.hh"
+
+class TH1I;
+
+namespace CarbonIonRadiography {
+
+// Number of tracks per image pixel and calorimeter stopping position.
+// The fluence, position and weight images of TrackReconstruction are formed
+// from these counts at the end, so no per-event data is kept, and grids of
+// several threads, chunks or runs are merged by plain addition.
+
+class ProjectionGrid {
+public:
+	ProjectionGrid( const HistogramAxis& x, const HistogramAxis& y,
+		G4int slices = calorimeter_slices());
+
+	// number of calorimeter slices of the detector
+	static G4int calorimeter_slices();
+
+	void fill( G4double x, G4double y, G4int position);
+	// false if the binning differs
+	G4bool add(const ProjectionGrid& src);
+	void reset();
+
+	const HistogramAxis& axis_x() const { return x_; }
+	const HistogramAxis& axis_y() const { return y_; }
+	G4int slices() const { return slices_; }
+	G4double entries() const { return entries_; }
+	G4double count( G4int bx, G4int by, G4int position) const;
+
+	// number of tracks of every stopping position -1 ... slices - 1
+	// (index position + 1) over all pixels
+	std::vector<G4double> position_counts() const;
+	// slice histogram contents with the bin layout of
+	// TH1I( name, title, slices, 0, slices - 1)
+	std::vector<G4double> slice_contents() const;
+	TH1I* create_slice_histogram( const char* name, const char* title) const;
+	// most frequent stopping position
+	G4int peak_position() const;
+
+	// position (offset + sign * position) and weight (slice histogram content
+	// of position + 1) images of tracks with position in [pos_min, pos_max]
+	void form_images( G4int pos_min, G4int pos_max, G4int offset, G4int sign,
+		Histogram2D<G4double>& position, Histogram2D<G4double>& weight) const;
+	// same with the values of the positions (index position + 1),
+	// e.g. the WEPL calibration table
+	void form_images( G4int pos_min, G4int pos_max,
+		const std::vector<G4double>& values,
+		Histogram2D<G4double>& position, Histogram2D<G4double>& weight) const;
+
+	G4bool write(std::ostream& dump) const;
+	static G4bool read( std::istream& dump, ProjectionGrid&);
+	G4bool save(const char* filename) const;
+	static G4bool load( const char* filename, ProjectionGrid&);
+
+private:
+	// stopping positions -1 (no hits) ... slices - 1
+	G4int positions() const { return slices_ + 1; }
+	G4int position_index(G4int position) const;
+
+	HistogramAxis x_;
+	HistogramAxis y_;
+	G4double x_scale_; // inverse bin width
+	G4double y_scale_; // inverse bin width
+	G4int cells_x_;
+	G4int cells_y_;
+	G4int slices_;
+	G4double entries_;
+	std::vector<G4double> counts_; // [pixel][position + 1]
+};
+
+inline
+G4int
+ProjectionGrid::position_index(G4int position) const
+{
+	G4int index = position + 1;
+	if (index < 0)
+		index = 0;
+	else if (index > slices_)
+		index = slices_;
+	return index;
+}
+
+inline
+void
+ProjectionGrid::fill( G4double x, G4double y, G4int position)
+{
+	G4int bx = x_.find_bin( x, x_scale_);
+	G4int by = y_.find_bin( y, y_scale_);
+	G4int pixel = bx + cells_x_ * by;
+
+	counts_[pixel * positions() + position_index(position)] += 1.0;
+	entries_ += 1.0;
+}
+
+inline
+G4double
+ProjectionGrid::count( G4int bx, G4int by, G4int position) const
+{
+	G4int pixel = bx + cells_x_ * by;
+	return counts_[pixel * positions() + position_index(position)];
+}
+
+} // namespace CarbonIonRadiography
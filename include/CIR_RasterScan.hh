@@ -0,0 +1,94 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+#include <G4VUserEventInformation.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace CarbonIonRadiography {
+
+// Raster scan delivery: pencil beam spots on the grid of nx by ny spots
+// for every energy layer, the same number of particles per spot. Event
+// of the campaign ID i belongs to the spot i / particles, the spot ID is
+// (layer * ny + iy) * nx + ix. A spot may stop early when it has got
+// the minimal number of full tracks (projection mode only).
+// The plan is set by the master between runs, the track counters are
+// shared by all threads.
+
+class RasterScan : private boost::noncopyable {
+public:
+	static RasterScan* Instance();
+
+	void SetEnabled(G4bool flag) { enabled = flag; }
+	G4bool IsEnabled() const { return enabled; }
+	void SetSpots( G4int nx, G4int ny, G4double pitchX, G4double pitchY);
+	void SetSigma(G4double value) { sigma = value; }
+	void SetParticlesPerSpot(G4int n) { particles = n; }
+	// kinetic energies per nucleon of the layers
+	void SetEnergies(const std::vector<G4double>& energies);
+	void SetMinTracks(G4int n) { minTracks = n; }
+
+	G4int NumberOfSpots() const { return spotsX * spotsY * G4int(layers.size()); }
+	G4int NumberOfEvents() const { return NumberOfSpots() * particles; }
+	G4int ParticlesPerSpot() const { return particles; }
+	G4double Sigma() const { return sigma; }
+
+	G4int SpotID(G4int eventID) const;
+	// center of the spot in the transverse plane and its energy per nucleon
+	void SpotCenter( G4int spot, G4double& x, G4double& y) const;
+	G4double SpotEnergy(G4int spot) const;
+
+	// track counters, reset by the master before the run
+	void ResetCounters();
+	G4bool SpotDone(G4int spot) const;
+	void CountTrack(G4int spot);
+
+private:
+	RasterScan();
+
+	G4bool enabled;
+	G4int spotsX, spotsY;
+	G4double pitchX, pitchY;
+	G4double sigma;
+	G4int particles;
+	std::vector<G4double> layers; // 0 -- energy of the run geometry
+	G4int minTracks; // 0 -- every spot gets all its particles
+
+	std::vector< std::atomic<G4int> > tracks;
+};
+
+// spot ID of the event
+class SpotInformation : public G4VUserEventInformation {
+public:
+	explicit SpotInformation(G4int spot) : spotID(spot) {}
+	virtual void Print() const;
+
+	G4int SpotID() const { return spotID; }
+
+private:
+	G4int spotID;
+};
+
+} // namespace CarbonIonRadiography
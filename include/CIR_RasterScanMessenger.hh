@@ -0,0 +1,56 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4UImessenger.hh>
+#include <globals.hh>
+
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithAString;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+
+namespace CarbonIonRadiography {
+
+class RunAction;
+
+class RasterScanMessenger : public G4UImessenger {
+public:
+	RasterScanMessenger(RunAction*);
+	virtual ~RasterScanMessenger();
+	void SetNewValue( G4UIcommand*, G4String);
+
+private:
+	RunAction* run_action;
+
+	G4UIdirectory* raster_dir;
+	G4UIcmdWithABool* enable_cmd;
+	G4UIcommand* spots_cmd;
+	G4UIcmdWithADoubleAndUnit* sigma_cmd;
+	G4UIcmdWithAnInteger* particles_cmd;
+	G4UIcmdWithAString* energies_cmd;
+	G4UIcmdWithAnInteger* min_tracks_cmd;
+	G4UIcmdWithoutParameter* beam_on_cmd;
+};
+
+} // namespace CarbonIonRadiography
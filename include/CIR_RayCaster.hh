@@ -0,0 +1,68 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Navigator.hh>
+#include <G4ThreeVector.hh>
+
+#include <map>
+
+#include "CIR_Defines.hh"
+
+class G4Material;
+
+namespace CarbonIonRadiography {
+
+// Straight line of a primary through the geometry: water equivalent
+// thickness (WET) and the crossing points of the silicon planes. The WET
+// ends at the first XY3 plane, so the rear tracker, air and calorimeter
+// don't add to the WET of the object.
+struct RayRecord {
+	G4double wet; // mm of water up to the front face of the XY3 planes
+	G4double x; // middle plane between XY2 and XY3 (um)
+	G4double y;
+	G4double planes[CIR_NUMBER_OF_SILICON_DETECTORS][2]; // x, y (um)
+};
+
+// Ray casting through the mass geometry with a navigator of its own,
+// one caster per thread. The path in every volume is weighted by the
+// stopping power of its material relative to water (Bethe formula at
+// the primary velocity), no particle is transported.
+
+class RayCaster {
+public:
+	RayCaster();
+	~RayCaster();
+
+	void Cast( const G4ThreeVector& position, const G4ThreeVector& direction,
+		G4double energyPerNucleon, RayRecord& ray);
+
+private:
+	G4double RelativeStoppingPower(const G4Material* material);
+	void SetVelocity(G4double energyPerNucleon);
+
+	G4Navigator navigator;
+	G4double energy; // kinetic energy per nucleon of the table
+	G4double beta2;
+	G4double waterLog; // stopping number of water
+	std::map< const G4Material*, G4double> stoppingPowers;
+};
+
+} // namespace CarbonIonRadiography
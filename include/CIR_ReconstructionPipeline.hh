@@ -0,0 +1,76 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <istream>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "CIR_Track.hh"
+
+namespace CarbonIonRadiography {
+
+class ProjectionGrid;
+
+// Streaming reconstruction of a hits file into a projection grid or into
+// a consumer of the accepted tracks. Chunks of events flow through
+// bounded queues between the stages
+//   decode -> coordinates -> fit -> filter -> bin (sink),
+// every stage runs in its own thread(s), so memory doesn't depend
+// on the number of events in the file. The bin stage (sink) gets the
+// chunks in the order of the file whatever the thread timing.
+
+class ReconstructionPipeline : private boost::noncopyable {
+public:
+	// accepted main and full tracks of a chunk, called from one thread
+	typedef std::function<void( const MainTracksVector&,
+		const FullTracksVector&)> TracksSink;
+
+	explicit ReconstructionPipeline(G4int threads = 0);
+
+	// number of coordinates and fit workers, zero -- all hardware threads
+	void set_threads(G4int threads) { threads_ = threads; }
+	// number of events in a chunk
+	void set_chunk_size(size_t size) { chunk_size_ = size ? size : 1; }
+	// number of chunks in a queue between stages, zero -- twice the workers
+	void set_queue_size(size_t size) { queue_size_ = size; }
+
+	// hits file (HitsPositions::save format), returns number of events read
+	size_t process( const char* filename, ProjectionGrid& grid);
+	size_t process( std::istream& hits, size_t events, ProjectionGrid& grid);
+	size_t process( const char* filename, const TracksSink& sink);
+	size_t process( std::istream& hits, size_t events, const TracksSink& sink);
+
+	// statistics of the last process
+	size_t events() const { return events_; }
+	size_t tracks() const { return tracks_; }
+
+private:
+	G4int threads_;
+	size_t chunk_size_;
+	size_t queue_size_;
+	size_t events_;
+	size_t tracks_;
+};
+
+} // namespace CarbonIonRadiography
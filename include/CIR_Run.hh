@@ -20,30 +20,70 @@
 #pragma once
 
 #include <vector>
+#include <utility>
 #include <G4Run.hh>
 
 #include <trec_hits_positions.hh>
 
 //#include "CIR_HitsPositions.hh"
 #include "CIR_Track.hh"
+#include "CIR_Histogram2D.hh"
+#include "CIR_RayCaster.hh"
+#include "CIR_ConvergenceMonitor.hh"
 
 class G4Event;
 
 namespace CarbonIonRadiography {
 
 class EventAction;
+class ProjectionGrid;
 
 class Run : public G4Run {
 public:
-	Run(EventAction* eventAction);
+	Run( EventAction* eventAction, G4int checkpointInterval = 0,
+		const G4String& checkpointPrefix = "checkpoint",
+		G4int checkpointGeneration = 0);
 	virtual ~Run();
 	virtual void RecordEvent(const G4Event*);
 	virtual void Merge(const G4Run*);
 	const TREC::HitsPositionsVector& hitsPositions() const { return hits_positions; }
+	// campaign IDs of the recorded events, with the per event seeding only
+	const std::vector<G4int>& eventIDs() const { return event_ids; }
+	// raster spot IDs of the recorded events, in the raster mode only
+	const std::vector<G4int>& spotIDs() const { return spot_ids; }
+	// order events (and hits positions) by spot and event ID
+	void SortEvents();
+	// projection grid of the run, zero if not in projection mode
+	const ProjectionGrid* projectionGrid() const { return projection_grid; }
+	// water equivalent thickness image and rays of the run, zero and
+	// empty if not in ray casting mode
+	const Histogram2D<G4double>* rayImage() const { return ray_image; }
+	const std::vector<RayRecord>& rays() const { return ray_records; }
 
 private:
+	void WriteCheckpoint();
+	// adds the pixel statistics to the monitor, stops the converged run
+	void UpdateConvergence();
+
 	EventAction* eventAction;
 	TREC::HitsPositionsVector hits_positions;
+	ProjectionGrid* projection_grid;
+	Histogram2D<G4double>* ray_image;
+	std::vector<RayRecord> ray_records;
+	// spot and event ID of every ray, events without a ray have no entry
+	std::vector< std::pair< G4int, G4int > > ray_events;
+	std::vector<G4int> event_ids;
+	std::vector<G4int> spot_ids;
+	// running statistics of the adaptive run, zero if off
+	ConvergenceMonitor::Statistics* statistics;
+
+	G4int checkpoint_interval; // events between checkpoints, 0 -- off
+	G4String checkpoint_prefix;
+	G4int checkpoint_generation; // generation of the worker files
+	G4int checkpoint_segments; // hits segments written
+	size_t checkpoint_hits; // hits positions written
+	G4int checkpoint_id_segments; // event IDs segments written
+	size_t checkpoint_ids; // event IDs written
 };
 
 } // namespace CarbonIonRadiography
@@ -20,12 +20,22 @@
 #pragma once
 
 #include <G4UserRunAction.hh>
+#include <globals.hh>
+
+#include <trec_hits_positions.hh>
+
+#include <vector>
 
 class G4Run;
 
 namespace CarbonIonRadiography {
 
 class EventAction;
+class ProjectionGrid;
+class Run;
+class RunActionMessenger;
+class RasterScanMessenger;
+struct ShardManifest;
 
 class RunAction : public G4UserRunAction {
 public:
@@ -36,8 +46,54 @@ public:
 	virtual void BeginOfRunAction(const G4Run*);
 	virtual void EndOfRunAction(const G4Run*);
 
+	void setCheckpointInterval(G4int interval) { checkpointInterval = interval; }
+	void setCheckpointPrefix(const G4String& prefix) { checkpointPrefix = prefix; }
+	// load the checkpoint and run the remaining events (master only)
+	void resume(G4int totalEvents);
+	// run shard index of count of the campaign (master only)
+	void runShard( G4int index, G4int count, G4int totalEvents, G4long seed);
+	// run all events of the raster scan (master only)
+	void runRaster();
+	// CT acquisition: events of every projection of the phantom rotated
+	// by span / projections from the start angle (master only)
+	void runTomography( G4int projections, G4int events, G4double span,
+		G4double start);
+	// tag of the output files of the following runs, one tag per
+	// configuration of a multi-configuration campaign
+	void setConfiguration(const G4String& tag);
+
 private:
+	void saveResults( const TREC::HitsPositionsVector& hits,
+		const ProjectionGrid* grid);
+	void saveRays(const Run* run);
+	void writeShardManifest( const G4String& type, const G4String& output);
+	void saveEventIDs(const std::vector<G4int>& ids);
+	void saveSpots(const std::vector<G4int>& spots);
+	// adds the events of the run to the resumed ones in the order of IDs,
+	// false if the hits don't follow the IDs and aren't added
+	G4bool mergeResumedEvents( const std::vector<G4int>& ids,
+		const TREC::HitsPositionsVector& hits);
+	void clearResumed();
+	G4String checkpointFiles() const;
+
 	EventAction* eventAction;
+	RunActionMessenger* messenger;
+	RasterScanMessenger* rasterMessenger;
+
+	G4int checkpointInterval;
+	G4String checkpointPrefix;
+
+	// data of the checkpoint being resumed
+	G4int resumedEvents;
+	TREC::HitsPositionsVector resumedHits;
+	std::vector<G4int> resumedIDs; // with the per event seeding only
+	ProjectionGrid* resumedGrid;
+
+	// shard of the campaign being run
+	ShardManifest* shard;
+
+	// output file of the last run
+	G4String lastOutput;
 };
 
 } // namespace CarbonIonRadiography
@@ -0,0 +1,68 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4UImessenger.hh>
+#include <globals.hh>
+
+class G4UIdirectory;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithAString;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithADouble;
+
+namespace CarbonIonRadiography {
+
+class RunAction;
+
+class RunActionMessenger : public G4UImessenger {
+public:
+	RunActionMessenger(RunAction*);
+	virtual ~RunActionMessenger();
+	void SetNewValue( G4UIcommand*, G4String);
+
+private:
+	RunAction* run_action;
+
+	G4UIdirectory* checkpoint_dir;
+	G4UIcmdWithAnInteger* interval_cmd;
+	G4UIcmdWithAString* file_cmd;
+	G4UIcmdWithAnInteger* resume_cmd;
+
+	G4UIdirectory* campaign_dir;
+	G4UIcommand* shard_cmd;
+	G4UIcmdWithAString* configuration_cmd;
+	G4UIcommand* ct_cmd;
+
+	G4UIdirectory* seeding_dir;
+	G4UIcmdWithABool* event_seeding_cmd;
+	G4UIcmdWithAnInteger* seed_cmd;
+
+	G4UIdirectory* convergence_dir;
+	G4UIcmdWithADouble* target_cmd;
+	G4UIcmdWithAnInteger* update_interval_cmd;
+	G4UIcmdWithAnInteger* min_entries_cmd;
+	G4UIcommand* region_cmd;
+
+	G4UIcmdWithAString* phase_space_cmd;
+};
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,133 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "CIR_Track.hh"
+#include "CIR_Histogram2D.hh"
+
+class TH3D;
+
+namespace CarbonIonRadiography {
+
+class MostLikelyPath;
+
+// Ordered subsets SART (OS-SART) of the CT acquisition over the single ion
+// histories. A history is a row of the system matrix: the voxels crossed by
+// the most likely path of the ion, rotated into the phantom frame by the
+// projection angle, with the path length in every voxel; the row value is
+// the WEPL (or slices) of the ion. The histories of a projection are
+// a subset.
+//
+// The rows are built in parallel for blocks of histories in compressed row
+// storage (CSR) and appended to the matrix file, so the number of histories
+// is limited by the disk, not by the memory. Every iteration streams the
+// file once, a reader thread prefetches the blocks of the subsets. The
+// threads add the corrections of their fixed row ranges into private
+// arrays, which are merged in the thread order after every subset, so the
+// updates are lock-free. The reconstruction pipeline delivers the
+// histories in the order of the hits files, so the same input and number
+// of threads give the same volume whatever the thread timing.
+
+class SartReconstruction : private boost::noncopyable {
+public:
+	// volume axes (um): u -- X and Z of the phantom frame, v -- Y along the
+	// rotation axis; the rotation axis crosses the middle of the path slab;
+	// matrix -- scratch file of the rows, removed by the destructor
+	SartReconstruction( const HistogramAxis& u, const HistogramAxis& v,
+		const MostLikelyPath& path, const char* matrix);
+	~SartReconstruction();
+
+	// number of threads, zero -- all hardware threads
+	void set_threads(G4int threads) { threads_ = threads; }
+	G4int threads() const { return threads_; }
+	// relaxation factor of the subset updates
+	void set_relaxation(G4double relaxation) { relaxation_ = relaxation; }
+
+	// starts the subset of the projection at the phantom angle (rad)
+	void begin_projection(G4double angle);
+	// accepted tracks of the projection ions, values of the stopping
+	// positions -1 ... slices - 1 (index position + 1), negative -- the ion
+	// is out of the cuts (see TrackReconstruction::position_values)
+	void add_histories( const MainTracksVector& main,
+		const FullTracksVector& full, const std::vector<G4double>& values);
+	void end_projection();
+
+	size_t histories() const { return histories_; }
+	G4int subsets() const { return G4int(blocks_.size()); }
+
+	// volume of v slices of u x u voxels, index (slice * u + z) * u + x,
+	// values per mm of the history values (e.g. RSP of WEPL in mm); the
+	// initial volume is uniform, the mean value per path length
+	G4bool reconstruct( G4int iterations, std::vector<G4double>& volume);
+
+	TH3D* create_volume( const char* name, const char* title,
+		const std::vector<G4double>& volume) const;
+
+private:
+	struct MatrixBlock;
+
+	// entrance and exit states of the pending histories
+	struct PathStates {
+		std::vector<G4double> x0, tx0, x1, tx1;
+		std::vector<G4double> y0, ty0, y1, ty1;
+		std::vector<G4double> value;
+	};
+
+	// rows of the pending histories [begin, end)
+	void build_rows( size_t begin, size_t end, MatrixBlock& rows) const;
+	// builds and writes the block of the pending histories
+	void write_block();
+	// corrections and weights of the rows for the volume
+	void project( const MatrixBlock& block, const std::vector<G4double>& volume,
+		std::vector< std::vector<G4double> >& delta,
+		std::vector< std::vector<G4double> >& weight) const;
+	// merges the corrections of the threads into the volume
+	void update( std::vector<G4double>& volume,
+		std::vector< std::vector<G4double> >& delta,
+		std::vector< std::vector<G4double> >& weight) const;
+
+	HistogramAxis u_;
+	HistogramAxis v_;
+	const MostLikelyPath& path_;
+	G4double axis_z_; // rotation axis (um)
+	G4int threads_;
+	G4double relaxation_;
+
+	std::string matrix_name_;
+	std::ofstream matrix_;
+	// file offsets of the blocks of the subsets
+	std::vector< std::vector<std::streamoff> > blocks_;
+
+	G4double cos_, sin_; // current projection angle
+	PathStates pending_;
+	size_t histories_;
+	G4double value_sum_; // sums of the values and path lengths of the rows
+	G4double length_sum_;
+};
+
+} // namespace CarbonIonRadiography
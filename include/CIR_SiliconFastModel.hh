@@ -0,0 +1,72 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4VFastSimulationModel.hh>
+
+#include <map>
+#include <vector>
+
+class G4Material;
+
+namespace CarbonIonRadiography {
+
+// Fast simulation of the charged hadrons and ions crossing a silicon
+// plane. The energy loss is sampled from the Landau distribution (thin
+// layer) or the Gaussian one (thick layer) around the tabulated mean loss,
+// the direction is deflected by the Highland multiple scattering angle,
+// the energy is shared between the crossed strips and the particle is
+// moved to the exit face. No delta rays are produced.
+// The model is active when the /fastsim/silicon flag is set.
+
+class SiliconFastModel : public G4VFastSimulationModel {
+public:
+	// pos -- index of the silicon plane
+	SiliconFastModel( const G4String& name, G4Region* envelope, G4int pos);
+	virtual ~SiliconFastModel();
+
+	virtual G4bool IsApplicable(const G4ParticleDefinition&);
+	virtual G4bool ModelTrigger(const G4FastTrack&);
+	virtual void DoIt( const G4FastTrack&, G4FastStep&);
+
+private:
+	// mean stopping power of the species in the material
+	struct StoppingTable {
+		std::vector<G4double> energy;
+		std::vector<G4double> dedx;
+		G4double DEDX(G4double kinEnergy) const;
+	};
+	typedef std::pair< const G4ParticleDefinition*, const G4Material*> TableKey;
+
+	const StoppingTable& Table( const G4ParticleDefinition*, const G4Material*);
+	// energy loss of the path with the velocity beta2 (thin layer)
+	G4double SampleEnergyLoss( G4double meanLoss, G4double xi, G4double tmax,
+		G4double beta2) const;
+	// energy shared between the strips crossed from y0 to y1 (local frame)
+	void DepositEnergy( G4double y0, G4double y1, G4double energy) const;
+
+	std::map< TableKey, StoppingTable> tables;
+	G4int plane;
+	G4double halfSize; // half size of the plane along the strips division
+	G4double pitch;
+	G4int strips;
+};
+
+} // namespace CarbonIonRadiography
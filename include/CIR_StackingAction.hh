@@ -22,15 +22,23 @@
 #include <G4UserStackingAction.hh>
 #include <globals.hh>
 
+#include "CIR_RayCaster.hh"
+
 namespace CarbonIonRadiography {
 
+class EventAction;
+
 class StackingAction : public G4UserStackingAction {
 public:
-	StackingAction();
+	StackingAction(EventAction* eventAction);
 	virtual ~StackingAction();
 	virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track*);
     virtual void NewStage() {}
     virtual void PrepareNewEvent() {}
+
+private:
+	EventAction* eventAction;
+	RayCaster rayCaster;
 };
 
 } // namespace CarbonIonRadiography
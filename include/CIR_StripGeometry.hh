@@ -65,13 +65,16 @@ struct StripGeometryNames {
 };
 
 // Micro strips detector plane geometry parameters
-const struct StripGeometry {
+struct StripGeometry {
 	static G4int index(StripGeometryType); // get plane index from type
 	static StripGeometryType index(G4int); // get plane type from index
 	static StripGeometryMap create();
 	static StripGeometryNames create(StripGeometryType);
 	static StripNamesMap create_names();
+	// geometry of the run (GeometryConfig)
 	static const StripGeometry* strip_geometry(StripGeometryType);
+	// geometry of the plane index of CIR_Defines.hh
+	static StripGeometry default_geometry(G4int pos);
 	static G4double sigma_geometry(StripGeometryType);
 
 	G4double z; // position z (um)
@@ -85,15 +88,6 @@ const struct StripGeometry {
 	G4int strips; // number of strips
 	G4double pitch; // pitch size (um)
 	G4double dx; // detector offset (um) -- reserved
-} strip_geometry_[CIR_NUMBER_OF_SILICON_DETECTORS] = {
-	{  -52000., 180.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
-	{  -50000.,  90.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
-	{  298000., 180.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
-	{  300000.,  90.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
-	{ 1300000., 180.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
-	{ 1302000.,  90.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
-	{ 1320000., -10.5, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
-	{ 1322000.,  10.5, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. }
 };
 
 inline
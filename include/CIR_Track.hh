@@ -47,13 +47,15 @@ public:
 	Track( G4double aa = 0.0, G4double bb = 0.0, G4double cov00 = 0.0,
 		G4double cov01 = 0.0, G4double cov11 = 0.0); // GSL
 	Track(const Track& src);
-	virtual ~Track() {};
 	Track& operator=(const Track& src);
 	G4bool operator==(const Track& src) const;
 	G4bool operator<(const Track& src) const;
 
 	G4double a() const { return a_; }
 	G4double b() const { return b_; }
+	G4double cov00() const { return cov00_; }
+	G4double cov01() const { return cov01_; }
+	G4double cov11() const { return cov11_; }
 	G4double fit(G4double z) const; // GSL
 	std::pair< G4double, G4double> fit_error(G4double z) const; // GSL
 
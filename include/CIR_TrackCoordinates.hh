@@ -28,6 +28,8 @@
 
 namespace CarbonIonRadiography {
 
+class TrackFitter;
+
 class TrackCoordinates {
 public:
 	TrackCoordinates(HitsPositions& hits_data);
@@ -37,6 +39,12 @@ public:
 	void calculate_tracks( G4bool& main, G4bool& full);
 	void get_tracks( TrackXYPair& track_main, TrackXYPair& track_full) const;
 	TrackXYPair get_track(G4bool type) const;
+	// plane XY1, XY2, XY3 coordinates (um), false if any plane has no cluster
+	G4bool get_coordinates( G4double* x, G4double* y) const;
+
+	// main track within 2 sigma from the hit (mx3, my3) in plane XY3 (um)
+	static G4bool within_trajectory( const TrackXYPair& main_track,
+		G4double mx3, G4double my3);
 private:
 	G4int check_one_cluster( const HitsVector& si_plane_hits,
 		HitsVector::const_iterator& begin,
@@ -0,0 +1,108 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <cstddef>
+
+#include "CIR_Track.hh"
+
+namespace CarbonIonRadiography {
+
+// Closed form least squares straight line fitter for a fixed set of planes.
+//
+// The weighted fit is the same as gsl_fit_wlinear, the unweighted one is
+// the same as ccm_qrlsq with a two parameters design matrix. All terms
+// which depend only on the planes positions and weights (weighted means,
+// covariance, coefficients of the linear estimators) are calculated once
+// in the constructor, so a fit is a few multiplications and additions
+// without any memory allocations.
+
+class TrackFitter {
+public:
+	static const G4int max_points = 3; // two and three planes geometries
+
+	TrackFitter( const G4double* z, G4int n); // CCMATH
+	TrackFitter( const G4double* z, const G4double* w, G4int n); // GSL
+
+	G4int points() const { return n_; }
+	G4bool valid() const { return valid_; }
+
+	// fit one event, f -- coordinates in planes (n values)
+	Track fit(const G4double* f) const;
+	// fit array of events, f -- coordinates of events one by one (events * n values)
+	void fit( const G4double* f, size_t events, Track* tracks) const;
+	// coordinate in the last plane of the fitted track, f -- coordinates
+	// in the other planes (n - 1 values), so the hit of the last plane
+	// is recovered from the track and the hits of the other planes
+	G4double coordinate( const Track& track, const G4double* f) const;
+
+private:
+	void precompute( const G4double* z, const G4double* w);
+
+	G4int n_;
+	G4bool weighted_;
+	G4bool valid_;
+	G4double ca_[max_points]; // intercept "b" estimator coefficients
+	G4double cb_[max_points]; // slope "a" estimator coefficients
+	G4double cov00_;
+	G4double cov01_;
+	G4double cov11_;
+};
+
+inline
+Track
+TrackFitter::fit(const G4double* f) const
+{
+	if (!valid_)
+		return Track();
+
+	G4double a = 0.0, b = 0.0;
+	for ( G4int i = 0; i < n_; ++i) {
+		a += cb_[i] * f[i];
+		b += ca_[i] * f[i];
+	}
+	return Track( a, b, cov00_, cov01_, cov11_);
+}
+
+inline
+G4double
+TrackFitter::coordinate( const Track& track, const G4double* f) const
+{
+	const G4int last = n_ - 1;
+	if (!valid_ || cb_[last] == 0.0)
+		return 0.0;
+
+	G4double a = track.a();
+	for ( G4int i = 0; i < last; ++i)
+		a -= cb_[i] * f[i];
+	return a / cb_[last];
+}
+
+// Fitters of the X (true) or Y (false) planes of the run geometry: the full
+// track (xy1-xy2-xy3) weighted by the plane sigmas and the main track
+// (xy1-xy2). They are built at the first call and cached for the process,
+// so the geometry config (plane positions and sigmas) is frozen at the
+// first fit.
+const TrackFitter& full_track_fitter(G4bool type);
+const TrackFitter& main_track_fitter(G4bool type);
+
+} // namespace CarbonIonRadiography
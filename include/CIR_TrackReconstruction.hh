@@ -21,24 +21,69 @@
 
 #include "CIR_Track.hh"
 #include "CIR_HitsPositions.hh"
+#include "CIR_Histogram2D.hh"
 
 class TH1I;
 class TH2D;
 
 namespace CarbonIonRadiography {
 
+class ProjectionGrid;
+class WeplCalibration;
+class MostLikelyPath;
+
 class TrackReconstruction {
 
 public:
 	TrackReconstruction( const MainTracksVector& main,
 		const FullTracksVector& full);
+	// reconstruction from projection grids, without tracks
+	TrackReconstruction();
 	virtual ~TrackReconstruction();
 	void formClearTracksData(const FullTracksVector& clear_tracks);
 	void formObjectTracksData(const FullTracksVector& clear_tracks);
+	void formClearGridData(const ProjectionGrid& clear);
+	void formObjectGridData( const ProjectionGrid& clear,
+		const ProjectionGrid& object);
 
 	void reconstruct(const char* filename = "reconstruct.root");
 	void reconstruct( const FullTracksVector& clear_tracks,
 		const char* filename = "reconstruct.root");
+	void reconstruct( const ProjectionGrid& clear, const ProjectionGrid& object,
+		const char* filename = "reconstruct.root");
+	// object images of the depth steps of the most likely paths, the image
+	// of a step is the mean value of the paths weighted by the path length
+	void reconstruct( const FullTracksVector& clear_tracks,
+		const MostLikelyPath& path, const char* filename = "reconstruct.root");
+	// mean value image (position sum / fluence) of the object projection,
+	// the values of the object images, e.g. a CT projection
+	void form_projection_image( const ProjectionGrid& clear,
+		const ProjectionGrid& object, Histogram2D<G4double>& image);
+	// values of the single ions of the object stopping at the positions
+	// -1 ... slices - 1 (index position + 1) with the clear projection grid,
+	// negative for the positions out of the object image cuts
+	std::vector<G4double> position_values(const ProjectionGrid& clear);
+	// slice, position, fluence and weight histograms of one projection grid
+	void reconstruct( const ProjectionGrid& projection,
+		const char* filename = "reconstruct.root");
+
+	// default image binning (um)
+	static HistogramAxis default_axis() { return HistogramAxis( 60, -29000.0, 29000.0); }
+
+	// number of reconstruction threads, zero -- all hardware threads
+	void set_threads(G4int threads) { threads_ = threads; }
+	G4int threads() const { return threads_; }
+
+	// object image values: WEPL (mm) of the calibration aligned to the clear
+	// field peak instead of the slices from the clear peak, zero -- slices
+	void set_calibration(const WeplCalibration* calibration) {
+		calibration_ = calibration;
+	}
+
+	// image binning in the plane between XY2 and XY3 planes (um)
+	void set_binning( const HistogramAxis& x, const HistogramAxis& y);
+	const HistogramAxis& axis_x() const { return axis_x_; }
+	const HistogramAxis& axis_y() const { return axis_y_; }
 
 	const MainTracksVector& main_tracks() const { return tracks_main_; }
 	const FullTracksVector& full_tracks() const { return tracks_full_; }
@@ -51,6 +96,18 @@ public:
 	static void load( const char* filename, std::vector<HitsPositions>&);
 
 private:
+	void write_image(const char* filename);
+	// calibration table of the positions -1 ... slices - 1
+	std::vector<G4double> wepl_table(G4int slices) const;
+	// clear peak positions (most frequent and centroid) of the clear grid
+	void set_clear_peak(const ProjectionGrid& clear);
+	// values of the object positions -1 ... slices - 1: WEPL of the
+	// calibration or the slices from the clear peak
+	std::vector<G4double> object_values(G4int slices) const;
+	// object images of the positions from object_pos_min_ to the clear peak
+	void form_object_images( const ProjectionGrid& object,
+		Histogram2D<G4double>& position, Histogram2D<G4double>& weight) const;
+
 	const MainTracksVector& tracks_main_;
 	const FullTracksVector& tracks_full_;
 	TH1I* clear_slice_;
@@ -63,6 +120,11 @@ private:
 	TH2D* object_weight_;
 	G4int clear_pos_min_, clear_pos_max_;
 	G4int object_pos_min_, object_pos_max_;
+	G4double clear_peak_; // centroid of the clear stopping positions
+	const WeplCalibration* calibration_;
+	G4int threads_;
+	HistogramAxis axis_x_;
+	HistogramAxis axis_y_;
 };
 
 inline
@@ -82,8 +144,22 @@ TrackReconstruction::TrackReconstruction( const MainTracksVector& main,
 	clear_pos_min_(-1),
 	clear_pos_max_(-1),
 	object_pos_min_(-1),
-	object_pos_max_(-1)
+	object_pos_max_(-1),
+	clear_peak_(-1.0),
+	calibration_(0),
+	threads_(0),
+	axis_x_(default_axis()),
+	axis_y_(default_axis())
+{
+}
+
+inline
+void
+TrackReconstruction::set_binning( const HistogramAxis& x,
+	const HistogramAxis& y)
 {
+	axis_x_ = x;
+	axis_y_ = y;
 }
 
 } // namespace CarbonIonRadiography
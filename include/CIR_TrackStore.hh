@@ -0,0 +1,93 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+#include "CIR_Track.hh"
+#include "CIR_AlignedArray.hh"
+
+namespace CarbonIonRadiography {
+
+// Structure of arrays storage of full tracks (X and Y tracks and
+// the calorimeter stopping position of each event). Every track parameter
+// is kept in a separate aligned array, so an extrapolation of the whole
+// set of tracks is a vectorized loop instead of a library call per track.
+
+class TrackStore : private boost::noncopyable {
+public:
+	TrackStore() : size_(0) {}
+	explicit TrackStore(const FullTracksVector& tracks);
+
+	void assign(const FullTracksVector& tracks);
+	void resize(size_t n);
+	void set( size_t i, const TracksPositionPair& track);
+	TracksPositionPair get(size_t i) const;
+	size_t size() const { return size_; }
+
+	// positions of all tracks in the plane z (um)
+	void extrapolate( G4double z, G4double* out_x, G4double* out_y) const;
+	// positions of X tracks in the plane z_x and Y tracks in the plane z_y (um)
+	void extrapolate( G4double z_x, G4double z_y,
+		G4double* out_x, G4double* out_y) const;
+	void extrapolate( G4double z_x, G4double z_y,
+		std::vector<G4double>& out_x, std::vector<G4double>& out_y) const;
+
+	const G4double* ax() const { return ax_.data(); }
+	const G4double* bx() const { return bx_.data(); }
+	const G4double* ay() const { return ay_.data(); }
+	const G4double* by() const { return by_.data(); }
+	const G4int* position() const { return position_.data(); }
+
+private:
+	size_t size_;
+	// X track
+	AlignedArray<G4double> ax_, bx_;
+	AlignedArray<G4double> cov00x_, cov01x_, cov11x_;
+	// Y track
+	AlignedArray<G4double> ay_, by_;
+	AlignedArray<G4double> cov00y_, cov01y_, cov11y_;
+	// calorimeter stopping position
+	AlignedArray<G4int> position_;
+};
+
+inline
+void
+TrackStore::extrapolate( G4double z, G4double* out_x, G4double* out_y) const
+{
+	extrapolate( z, z, out_x, out_y);
+}
+
+inline
+void
+TrackStore::extrapolate( G4double z_x, G4double z_y,
+	std::vector<G4double>& out_x, std::vector<G4double>& out_y) const
+{
+	out_x.resize(size_);
+	out_y.resize(size_);
+	if (size_)
+		extrapolate( z_x, z_y, &out_x[0], &out_y[0]);
+}
+
+} // namespace CarbonIonRadiography
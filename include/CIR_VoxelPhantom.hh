@@ -0,0 +1,95 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+#include <G4String.hh>
+#include <G4ThreeVector.hh>
+
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+class G4Material;
+class G4LogicalVolume;
+class G4VPhysicalVolume;
+
+namespace CarbonIonRadiography {
+
+// Voxelized phantom: a text header and a raw grid of nx * ny * nz voxels
+// (x is the fastest index). Header keys:
+//   voxels nx ny nz
+//   size dx dy dz -- voxel size (mm)
+//   data file -- raw grid, relative to the header directory
+//   format id|density -- unsigned 16 bit material IDs or
+//     32 bit float densities (g/cm3)
+//   material id name [density] -- id format: NIST material of the ID,
+//     optionally with another density (g/cm3)
+//   range min_density name -- density format: NIST material of densities
+//     from min_density up to the next higher range, in any order
+//   step density -- density format: width of density bins (g/cm3)
+// Voxels of the same material (ID or density bin) share one G4Material,
+// the phantom is built with the regular navigation parameterisation
+// instead of a placement per voxel.
+
+class VoxelPhantom : private boost::noncopyable {
+public:
+	VoxelPhantom();
+	~VoxelPhantom();
+
+	G4bool Load(const G4String& header);
+	// container of the voxels placed into the mother volume
+	G4VPhysicalVolume* Construct( G4LogicalVolume* mother,
+		const G4ThreeVector& position, G4Material* containerMaterial);
+
+	const G4String& FileName() const { return fileName; }
+	size_t NumberOfVoxels() const { return indices.size(); }
+	size_t NumberOfMaterials() const { return materials.size(); }
+
+private:
+	G4bool LoadIDs(const G4String& data);
+	G4bool LoadDensities(const G4String& data);
+	G4Material* FindMaterial( const G4String& name, G4double density);
+
+	G4String fileName;
+	G4int voxelsX, voxelsY, voxelsZ;
+	G4double voxelX, voxelY, voxelZ; // full size
+
+	// material table of the ID format
+	struct MaterialEntry {
+		G4int id;
+		G4String name;
+		G4double density; // zero -- NIST density
+	};
+	std::vector<MaterialEntry> materialEntries;
+
+	// density ranges of the density format
+	struct DensityRange {
+		G4double minDensity;
+		G4String name;
+	};
+	std::vector<DensityRange> densityRanges;
+	G4double densityStep;
+
+	std::vector<G4Material*> materials; // compact material table
+	std::vector<size_t> indices; // material index of every voxel
+};
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,90 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#pragma once
+
+#include <G4Types.hh>
+
+#include <utility>
+#include <vector>
+
+namespace CarbonIonRadiography {
+
+class ProjectionGrid;
+
+// Water equivalent path length (WEPL) of the calorimeter stopping position.
+// The calibration points (fractional stopping position, WEPL in mm) come
+// from the clear field and known step phantom runs or from the stopping
+// power tables (/physics/weplTable of cir-run). The points are
+// interpolated once into the table of the integer positions, so every
+// track is calibrated by an indexed lookup.
+//
+// File: "point position wepl" lines, '#' -- comment
+
+class WeplCalibration {
+public:
+	WeplCalibration();
+
+	void add_point( G4double position, G4double wepl);
+	// point of the run with the known WEPL: peak of the stopping positions
+	void add_run( const ProjectionGrid& grid, G4double wepl);
+	void clear();
+	size_t points() const { return points_.size(); }
+	G4bool empty() const { return points_.empty(); }
+
+	// shift the points, so that WEPL 0 is at the clear field position
+	void align(G4double clear_position);
+	// table of the stopping positions -1 ... slices - 1
+	void build(G4int slices);
+
+	// linear interpolation of the points, linear extrapolation outside
+	G4double interpolate(G4double position) const;
+	// lookup of the built table
+	G4double wepl(G4int position) const;
+	const std::vector<G4double>& table() const { return table_; }
+
+	// centroid of the peak of the counts of the stopping positions
+	// -1 ... slices - 1 (index position + 1)
+	static G4double peak_position(const std::vector<G4double>& counts);
+
+	G4bool save(const char* filename) const;
+	static G4bool load( const char* filename, WeplCalibration&);
+
+private:
+	void sort_points();
+	// position of the WEPL on the interpolated points
+	G4double position_of(G4double wepl) const;
+
+	std::vector< std::pair< G4double, G4double> > points_;
+	std::vector<G4double> table_; // index position + 1
+};
+
+inline
+G4double
+WeplCalibration::wepl(G4int position) const
+{
+	G4int index = position + 1;
+	if (index < 0)
+		index = 0;
+	else if (index >= G4int(table_.size()))
+		index = G4int(table_.size()) - 1;
+	return table_[index];
+}
+
+} // namespace CarbonIonRadiography
@@ -51,7 +51,7 @@ ActionInitialization::Build() const
 	SetUserAction(new PrimaryGeneratorAction);
 	SetUserAction(new RunAction(eventAction));
 	SetUserAction(eventAction);
-	SetUserAction(new StackingAction);
+	SetUserAction(new StackingAction(eventAction));
 	SetUserAction(new SteppingAction(eventAction));
 	SetUserAction(new TrackingAction);
 }
@@ -0,0 +1,212 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4SystemOfUnits.hh>
+#include <G4FastTrack.hh>
+#include <G4FastStep.hh>
+#include <G4Track.hh>
+#include <G4Material.hh>
+#include <G4ParticleDefinition.hh>
+#include <G4EmCalculator.hh>
+#include <G4EventManager.hh>
+#include <G4VSolid.hh>
+#include <Randomize.hh>
+
+#include <algorithm>
+#include <cmath>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_EventAction.hh"
+#include "CIR_CalorimeterFastModel.hh"
+
+namespace {
+
+// energy grid of the range tables per nucleon
+const G4double min_energy_per_nucleon = 0.1 * CLHEP::MeV;
+const G4double max_energy_per_nucleon = 1.0 * CLHEP::GeV;
+const G4int range_table_bins = 256;
+
+// relative range straggling of the proton, for the ions it is
+// scaled by 1 / sqrt(A)
+const G4double proton_range_straggling = 0.012;
+
+// linear interpolation of y(x), x is increasing
+G4double
+interpolate( const std::vector<G4double>& x, const std::vector<G4double>& y,
+	G4double value)
+{
+	if (value <= x.front())
+		return y.front() * value / x.front();
+	if (value >= x.back())
+		return y.back();
+
+	size_t i = std::upper_bound( x.begin(), x.end(), value) - x.begin();
+	G4double w = (value - x[i - 1]) / (x[i] - x[i - 1]);
+	return y[i - 1] + w * (y[i] - y[i - 1]);
+}
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+/////////////////////////////////////////////////////////////////////////////
+G4double
+CalorimeterFastModel::RangeTable::Range(G4double kinEnergy) const
+{
+	return interpolate( energy, range, kinEnergy);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+G4double
+CalorimeterFastModel::RangeTable::Energy(G4double residualRange) const
+{
+	if (residualRange <= 0.0)
+		return 0.0;
+	return interpolate( range, energy, residualRange);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+CalorimeterFastModel::CalorimeterFastModel( const G4String& name,
+	G4Region* envelope)
+	:
+	G4VFastSimulationModel( name, envelope),
+	frontZ(-0.5 * GeometryConfig::instance().calorimeter_thickness()),
+	sliceThickness(GeometryConfig::instance().calorimeter_slice_thickness()),
+	slices(GeometryConfig::instance().calorimeter_slices())
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+CalorimeterFastModel::~CalorimeterFastModel()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+G4bool
+CalorimeterFastModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+	// protons and ions
+	return particle.GetPDGCharge() > 0.0 && particle.GetBaryonNumber() > 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+G4bool
+CalorimeterFastModel::ModelTrigger(const G4FastTrack&)
+{
+	const EventAction* eventAction = static_cast<const EventAction*>(
+		G4EventManager::GetEventManager()->GetUserEventAction());
+	return eventAction && eventAction->caloFastSimulation();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+const CalorimeterFastModel::RangeTable&
+CalorimeterFastModel::Table( const G4ParticleDefinition* particle,
+	const G4Material* material)
+{
+	TableKey key( particle, material);
+	std::map< TableKey, RangeTable>::iterator it = tables.find(key);
+	if (it != tables.end())
+		return it->second;
+
+	RangeTable& table = tables[key];
+	table.energy.resize(range_table_bins);
+	table.range.resize(range_table_bins);
+
+	G4int nucleons = particle->GetBaryonNumber();
+	G4double emin = min_energy_per_nucleon * nucleons;
+	G4double emax = max_energy_per_nucleon * nucleons;
+	G4double ratio = std::pow( emax / emin, 1.0 / (range_table_bins - 1));
+
+	// range is the integral of 1 / (dE/dx), the stopping power
+	// below the minimum energy is proportional to sqrt(E)
+	G4EmCalculator calculator;
+	G4double energy = emin;
+	G4double dedx = calculator.ComputeTotalDEDX( energy, particle, material);
+	G4double range = 2.0 * energy / dedx;
+	for ( G4int i = 0; i < range_table_bins; ++i) {
+		if (i) {
+			G4double next = energy * ratio;
+			G4double next_dedx = calculator.ComputeTotalDEDX( next, particle,
+				material);
+			range += 0.5 * (next - energy) * (1.0 / dedx + 1.0 / next_dedx);
+			energy = next;
+			dedx = next_dedx;
+		}
+		table.energy[i] = energy;
+		table.range[i] = range;
+	}
+	return table;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+CalorimeterFastModel::DoIt( const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+	EventAction* eventAction = static_cast<EventAction*>(
+		G4EventManager::GetEventManager()->GetUserEventAction());
+
+	const G4Track* track = fastTrack.GetPrimaryTrack();
+	const G4ThreeVector& position = fastTrack.GetPrimaryTrackLocalPosition();
+	const G4ThreeVector& direction = fastTrack.GetPrimaryTrackLocalDirection();
+
+	const RangeTable& table = Table( track->GetDefinition(),
+		track->GetMaterial());
+
+	G4double kinEnergy = track->GetKineticEnergy();
+	G4double range = table.Range(kinEnergy);
+
+	// sampled range, the residual range along the path is scaled to it
+	G4int nucleons = track->GetDefinition()->GetBaryonNumber();
+	G4double sigma = proton_range_straggling * range / std::sqrt(G4double(nucleons));
+	G4double sampled = std::max( range + sigma * G4RandGauss::shoot(),
+		0.01 * range);
+	G4double scale = range / sampled;
+
+	// the ion leaving the calorimeter deposits the energy up to the exit
+	G4double exit = fastTrack.GetEnvelopeSolid()->DistanceToOut( position,
+		direction);
+	G4double path = std::min( sampled, exit);
+
+	// slices along the local Z axis of the calorimeter
+	G4double step = 0.0;
+	while (step < path) {
+		// slice of the path just after the step
+		G4double probe = step + 1.0e-6 * sliceThickness;
+		G4int slice = G4int(std::floor( (position.z() + direction.z() * probe
+			- frontZ) / sliceThickness));
+		slice = std::max( 0, std::min( slices - 1, slice));
+
+		G4double next = path;
+		if (direction.z() > 0.0)
+			next = (frontZ + (slice + 1) * sliceThickness - position.z()) / direction.z();
+		else if (direction.z() < 0.0)
+			next = (frontZ + slice * sliceThickness - position.z()) / direction.z();
+		next = std::min( std::max( next, probe), path);
+
+		G4double energy = table.Energy((sampled - step) * scale)
+			- table.Energy((sampled - next) * scale);
+		eventAction->addCaloEnergy( slice, energy);
+		step = next;
+	}
+
+	fastStep.ProposePrimaryTrackPathLength(path);
+	fastStep.KillPrimaryTrack();
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,206 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "CIR_Campaign.hh"
+
+namespace {
+
+// splitmix64 finalizer, consecutive inputs give independent outputs
+unsigned long long
+mix(unsigned long long x)
+{
+	x += 0x9e3779b97f4a7c15ULL;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	return x ^ (x >> 31);
+}
+
+bool
+by_index( const CarbonIonRadiography::ShardManifest& a,
+	const CarbonIonRadiography::ShardManifest& b)
+{
+	return a.index < b.index;
+}
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+void
+random_stream_seeds( G4long key, G4long stream, long* seeds)
+{
+	unsigned long long x = mix( mix((unsigned long long)key) ^
+		(unsigned long long)stream);
+	// CLHEP engines want positive non-zero seeds
+	seeds[0] = long(x & 0x7fffffffULL) | 1;
+	seeds[1] = long((x >> 32) & 0x7fffffffULL) | 1;
+}
+
+ShardManifest::ShardManifest()
+	:
+	seed(0),
+	index(-1),
+	count(0),
+	total(0),
+	first(0),
+	events(0)
+{
+}
+
+ShardManifest::ShardManifest( G4long campaign_seed, G4int shard_index,
+	G4int shard_count, G4int total_events)
+	:
+	seed(campaign_seed),
+	index(shard_index),
+	count(shard_count),
+	total(total_events),
+	first(0),
+	events(0)
+{
+	if (!valid())
+		return;
+
+	// the first (total % count) shards run one more event
+	G4int chunk = total / count;
+	G4int rest = total % count;
+	first = index * chunk + std::min( index, rest);
+	events = chunk + ((index < rest) ? 1 : 0);
+}
+
+G4bool
+ShardManifest::valid() const
+{
+	return (count > 0 && index >= 0 && index < count && total >= 0);
+}
+
+void
+ShardManifest::seeds(long* out) const
+{
+	random_stream_seeds( seed, index, out);
+}
+
+G4String
+ShardManifest::file_name( const G4String& name, const G4String& ext) const
+{
+	std::ostringstream file;
+	file << name << '.' << index << ext;
+	return file.str();
+}
+
+G4bool
+ShardManifest::write(const char* filename) const
+{
+	std::ofstream file(filename);
+
+	file << "seed " << seed << '\n';
+	file << "shard " << index << ' ' << count << '\n';
+	file << "events " << first << ' ' << events << ' ' << total << '\n';
+	file << "type " << type << '\n';
+	file << "output " << output << '\n';
+
+	return file.good();
+}
+
+G4bool
+ShardManifest::read( const char* filename, ShardManifest& manifest)
+{
+	std::ifstream file(filename);
+	if (!file)
+		return false;
+
+	manifest = ShardManifest();
+
+	std::string line;
+	while (std::getline( file, line)) {
+		std::istringstream fields(line);
+		std::string key;
+		fields >> key;
+		if (key == "seed")
+			fields >> manifest.seed;
+		else if (key == "shard")
+			fields >> manifest.index >> manifest.count;
+		else if (key == "events")
+			fields >> manifest.first >> manifest.events >> manifest.total;
+		else if (key == "type")
+			fields >> manifest.type;
+		else if (key == "output")
+			std::getline( fields >> std::ws, manifest.output);
+		if (fields.fail())
+			return false;
+	}
+	return manifest.valid() && !manifest.output.empty();
+}
+
+G4bool
+ShardManifest::check_coverage( const std::vector<ShardManifest>& shards,
+	std::string& error)
+{
+	std::ostringstream message;
+
+	if (shards.empty()) {
+		error = "no shards";
+		return false;
+	}
+
+	std::vector<ShardManifest> sorted(shards);
+	std::sort( sorted.begin(), sorted.end(), by_index);
+
+	const ShardManifest& campaign = sorted.front();
+	if (G4int(sorted.size()) != campaign.count) {
+		message << sorted.size() << " shards of " << campaign.count;
+		error = message.str();
+		return false;
+	}
+
+	G4int next = 0;
+	for ( size_t i = 0; i < sorted.size(); ++i) {
+		const ShardManifest& shard = sorted[i];
+		if (shard.seed != campaign.seed || shard.count != campaign.count ||
+			shard.total != campaign.total || shard.type != campaign.type) {
+			message << "shard " << shard.index << " is of another campaign";
+			error = message.str();
+			return false;
+		}
+		if (shard.index != G4int(i)) {
+			message << "shard " << i << " is missing or duplicated";
+			error = message.str();
+			return false;
+		}
+		if (shard.first != next) {
+			message << "shard " << shard.index << " starts at event "
+				<< shard.first << " instead of " << next;
+			error = message.str();
+			return false;
+		}
+		next += shard.events;
+	}
+
+	if (next != campaign.total) {
+		message << next << " events of " << campaign.total;
+		error = message.str();
+		return false;
+	}
+	return true;
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,303 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4ios.hh>
+#include <Randomize.hh>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "CIR_ProjectionGrid.hh"
+#include "CIR_Checkpoint.hh"
+
+namespace {
+
+const char magic[8] = { 'C', 'I', 'R', 'C', 'K', 'P', 'T', '2' };
+
+// more worker threads than this are not expected
+const G4int max_threads = 4096;
+
+struct StateHeader {
+	G4int events;
+	G4int segments;
+	G4int idSegments;
+	G4int generation;
+	G4int projection;
+};
+
+// replace the file by the temporary one, atomic on POSIX file systems
+G4bool
+commit( const G4String& tmp, const G4String& file)
+{
+	if (std::rename( tmp.c_str(), file.c_str())) {
+		G4cerr << "Can't write checkpoint " << file << G4endl;
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return true;
+}
+
+G4bool
+read_state( const G4String& file, StateHeader& header, std::string& engine,
+	CarbonIonRadiography::ProjectionGrid* grid)
+{
+	std::ifstream dump( file.c_str(), std::ios::binary);
+	if (!dump)
+		return false;
+
+	char buffer[sizeof(magic)] = {};
+	dump.read( buffer, sizeof(magic));
+	if (!dump || std::memcmp( buffer, magic, sizeof(magic))) {
+		G4cerr << "Wrong checkpoint file " << file << G4endl;
+		return false;
+	}
+
+	dump.read( (char *)&header, sizeof(StateHeader));
+
+	size_t engine_size = 0;
+	dump.read( (char *)&engine_size, sizeof(size_t));
+	engine.resize(engine_size);
+	if (engine_size)
+		dump.read( &engine[0], engine_size);
+
+	if (header.projection && grid) {
+		CarbonIonRadiography::ProjectionGrid data(*grid);
+		if (!CarbonIonRadiography::ProjectionGrid::read( dump, data) ||
+			!grid->add(data)) {
+			G4cerr << "Wrong projection grid in checkpoint " << file << G4endl;
+			return false;
+		}
+	}
+	return dump.good();
+}
+
+G4bool
+read_ids( const G4String& file, std::vector<G4int>& ids)
+{
+	std::ifstream dump( file.c_str(), std::ios::binary);
+
+	size_t ids_size = 0;
+	dump.read( (char *)&ids_size, sizeof(size_t));
+	if (!dump) {
+		G4cerr << "Can't read checkpoint event IDs " << file << G4endl;
+		return false;
+	}
+
+	std::vector<G4int> segment(ids_size);
+	if (ids_size)
+		dump.read( (char *)&segment[0], ids_size * sizeof(G4int));
+	if (!dump) {
+		G4cerr << "Truncated checkpoint event IDs " << file << G4endl;
+		return false;
+	}
+	ids.insert( ids.end(), segment.begin(), segment.end());
+	return true;
+}
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+G4String
+Checkpoint::StateFile( const G4String& prefix, G4int generation,
+	G4int thread)
+{
+	std::ostringstream name;
+	name << prefix << '.';
+	if (thread == base)
+		name << "base";
+	else
+		name << generation << '.' << thread;
+	name << ".dat";
+	return name.str();
+}
+
+G4String
+Checkpoint::SegmentFile( const G4String& prefix, G4int generation,
+	G4int thread, G4int segment)
+{
+	std::ostringstream name;
+	name << prefix << '.';
+	if (thread == base)
+		name << "base";
+	else
+		name << generation << '.' << thread;
+	name << '.' << segment << ".dat";
+	return name.str();
+}
+
+G4String
+Checkpoint::IDsFile( const G4String& prefix, G4int generation,
+	G4int thread, G4int segment)
+{
+	G4String file = SegmentFile( prefix, generation, thread, segment);
+	return file.substr( 0, file.size() - 4) + ".ids.dat";
+}
+
+G4bool
+Checkpoint::SaveState( const G4String& file, G4int events, G4int segments,
+	G4int idSegments, G4int generation, const ProjectionGrid* grid)
+{
+	G4String tmp = file + ".tmp";
+	{
+		std::ofstream dump( tmp.c_str(), std::ios::binary);
+
+		StateHeader header = { events, segments, idSegments, generation,
+			grid ? 1 : 0 };
+
+		std::ostringstream engine;
+		CLHEP::HepRandom::getTheEngine()->put(engine);
+		std::string status = engine.str();
+		size_t status_size = status.size();
+
+		dump.write( magic, sizeof(magic));
+		dump.write( (char *)&header, sizeof(StateHeader));
+		dump.write( (char *)&status_size, sizeof(size_t));
+		dump.write( status.data(), status_size);
+		if (grid)
+			grid->write(dump);
+
+		dump.flush();
+		if (!dump) {
+			G4cerr << "Can't write checkpoint " << tmp << G4endl;
+			return false;
+		}
+	}
+	return commit( tmp, file);
+}
+
+G4bool
+Checkpoint::SaveHits( const G4String& file,
+	const TREC::HitsPositionsVector& hits)
+{
+	G4String tmp = file + ".tmp";
+	TREC::HitsPositions::save( tmp.c_str(), hits);
+	return commit( tmp, file);
+}
+
+G4bool
+Checkpoint::SaveIDs( const G4String& file, const G4int* begin,
+	const G4int* end)
+{
+	G4String tmp = file + ".tmp";
+	{
+		std::ofstream dump( tmp.c_str(), std::ios::binary);
+
+		size_t ids_size = end - begin;
+		dump.write( (char *)&ids_size, sizeof(size_t));
+		if (ids_size)
+			dump.write( (const char *)begin, ids_size * sizeof(G4int));
+
+		dump.flush();
+		if (!dump) {
+			G4cerr << "Can't write checkpoint " << tmp << G4endl;
+			return false;
+		}
+	}
+	return commit( tmp, file);
+}
+
+G4bool
+Checkpoint::Load( const G4String& prefix, G4int& events,
+	TREC::HitsPositionsVector& hits, std::vector<G4int>& ids,
+	ProjectionGrid* grid, std::string& engines, G4int& generation)
+{
+	events = 0;
+	generation = 0;
+	G4bool found = false;
+
+	for ( G4int thread = base; thread < max_threads; ++thread) {
+		StateHeader header = { 0, 0, 0, 0, 0 };
+		std::string engine;
+		G4String file = StateFile( prefix, generation, thread);
+
+		// no base before the first resume, no file of a worker
+		// which hasn't reached its first checkpoint
+		if (!read_state( file, header, engine, grid))
+			continue;
+		if (thread == base) // workers of the base generation
+			generation = header.generation;
+
+		for ( G4int segment = 0; segment < header.segments; ++segment) {
+			TREC::HitsPositionsVector segment_hits;
+			TREC::HitsPositions::load( SegmentFile( prefix, generation, thread,
+				segment).c_str(), segment_hits);
+			hits.insert( hits.end(), segment_hits.begin(), segment_hits.end());
+		}
+		for ( G4int segment = 0; segment < header.idSegments; ++segment) {
+			if (!read_ids( IDsFile( prefix, generation, thread, segment), ids))
+				return false;
+		}
+
+		events += header.events;
+		engines += engine;
+		found = true;
+	}
+	return found;
+}
+
+G4bool
+Checkpoint::SaveBase( const G4String& prefix, G4int events,
+	const TREC::HitsPositionsVector& hits, const std::vector<G4int>& ids,
+	const ProjectionGrid* grid, G4int generation)
+{
+	G4int segments = 0;
+	if (!grid) {
+		if (!SaveHits( SegmentFile( prefix, generation, base, 0), hits))
+			return false;
+		segments = 1;
+	}
+	G4int idSegments = 0;
+	if (!ids.empty()) {
+		const G4int* data = &ids[0];
+		if (!SaveIDs( IDsFile( prefix, generation, base, 0), data,
+			data + ids.size()))
+			return false;
+		idSegments = 1;
+	}
+	return SaveState( StateFile( prefix, generation, base), events, segments,
+		idSegments, generation, grid);
+}
+
+void
+Checkpoint::Remove( const G4String& prefix, G4int generation,
+	G4bool withBase)
+{
+	for ( G4int gen = 0; gen <= generation; ++gen) {
+		G4int first = withBase ? base : 0;
+		for ( G4int thread = first; thread < max_threads; ++thread) {
+			StateHeader header = { 0, 0, 0, 0, 0 };
+			std::string engine;
+			G4String file = StateFile( prefix, gen, thread);
+
+			if (!read_state( file, header, engine, 0))
+				continue;
+
+			for ( G4int segment = 0; segment < header.segments; ++segment)
+				std::remove(SegmentFile( prefix, gen, thread, segment).c_str());
+			for ( G4int segment = 0; segment < header.idSegments; ++segment)
+				std::remove(IDsFile( prefix, gen, thread, segment).c_str());
+			std::remove(file.c_str());
+		}
+	}
+}
+
+} // namespace CarbonIonRadiography
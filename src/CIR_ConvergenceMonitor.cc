@@ -0,0 +1,197 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4AutoLock.hh>
+#include <G4SystemOfUnits.hh>
+
+#include <cmath>
+#include <algorithm>
+
+#include "CIR_TrackReconstruction.hh"
+#include "CIR_ConvergenceMonitor.hh"
+
+namespace {
+
+G4Mutex convergenceMutex = G4MUTEX_INITIALIZER;
+
+// beam tails of the whole image: pixels with a fluence under the fraction
+// of the maximal one
+const G4double tail_fraction = 0.1;
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+ConvergenceMonitor::Statistics::Statistics( const HistogramAxis& x,
+	const HistogramAxis& y)
+	:
+	axisX(x),
+	axisY(y),
+	count( (x.bins + 2) * (y.bins + 2), 0.0),
+	mean(count),
+	m2(count)
+{
+}
+
+void
+ConvergenceMonitor::Statistics::Fill( G4double x, G4double y, G4double value)
+{
+	G4int bin = axisY.find_bin(y) * (axisX.bins + 2) + axisX.find_bin(x);
+
+	// Welford update
+	G4double n = count[bin] += 1.0;
+	G4double delta = value - mean[bin];
+	mean[bin] += delta / n;
+	m2[bin] += delta * (value - mean[bin]);
+}
+
+void
+ConvergenceMonitor::Statistics::Add(const Statistics& other)
+{
+	for ( size_t i = 0; i < count.size(); ++i) {
+		G4double nb = other.count[i];
+		if (nb <= 0.0)
+			continue;
+
+		// Chan et al. combination of the partial statistics
+		G4double na = count[i];
+		G4double n = na + nb;
+		G4double delta = other.mean[i] - mean[i];
+		mean[i] += delta * nb / n;
+		m2[i] += other.m2[i] + delta * delta * na * nb / n;
+		count[i] = n;
+	}
+}
+
+void
+ConvergenceMonitor::Statistics::Clear()
+{
+	std::fill( count.begin(), count.end(), 0.0);
+	std::fill( mean.begin(), mean.end(), 0.0);
+	std::fill( m2.begin(), m2.end(), 0.0);
+}
+
+G4double
+ConvergenceMonitor::Statistics::Variance(G4int bin) const
+{
+	return (count[bin] > 1.0) ? m2[bin] / (count[bin] - 1.0) : 0.0;
+}
+
+ConvergenceMonitor::ConvergenceMonitor()
+	:
+	target(0.0),
+	interval(1000),
+	minEntries(10),
+	total( TrackReconstruction::default_axis(),
+		TrackReconstruction::default_axis()),
+	uncertainty(-1.0),
+	converged(false)
+{
+	regionX[0] = regionX[1] = 0.0;
+	regionY[0] = regionY[1] = 0.0;
+}
+
+ConvergenceMonitor*
+ConvergenceMonitor::Instance()
+{
+	static ConvergenceMonitor instance;
+	return &instance;
+}
+
+void
+ConvergenceMonitor::SetRegion( G4double xMin, G4double xMax, G4double yMin,
+	G4double yMax)
+{
+	regionX[0] = xMin;
+	regionX[1] = xMax;
+	regionY[0] = yMin;
+	regionY[1] = yMax;
+}
+
+void
+ConvergenceMonitor::Reset()
+{
+	total.Clear();
+	uncertainty = -1.0;
+	converged = false;
+}
+
+void
+ConvergenceMonitor::Update(Statistics& local)
+{
+	G4AutoLock lock(&convergenceMutex);
+
+	total.Add(local);
+	local.Clear();
+
+	uncertainty = RegionUncertainty();
+	if (uncertainty >= 0.0 && uncertainty <= target)
+		converged = true;
+}
+
+G4double
+ConvergenceMonitor::RegionUncertainty() const
+{
+	const HistogramAxis& x = total.AxisX();
+	const HistogramAxis& y = total.AxisY();
+	const G4bool whole = !(regionX[1] > regionX[0] && regionY[1] > regionY[0]);
+
+	// the fluence of the beam tails, without an explicit region
+	G4double tail = 0.0;
+	if (whole) {
+		for ( G4int by = 1; by <= y.bins; ++by)
+			for ( G4int bx = 1; bx <= x.bins; ++bx)
+				tail = std::max( tail, total.Count(by * (x.bins + 2) + bx));
+		tail *= tail_fraction;
+	}
+	const G4double entries = std::max( G4double(minEntries), 2.0);
+
+	// pixel centers (um) inside the region, without underflow and overflow
+	G4double worst = 0.0;
+	G4int pixels = 0;
+	for ( G4int by = 1; by <= y.bins; ++by) {
+		G4double cy = (y.min + (by - 0.5) / y.scale()) * CLHEP::um;
+		if (!whole && (cy < regionY[0] || cy > regionY[1]))
+			continue;
+		for ( G4int bx = 1; bx <= x.bins; ++bx) {
+			G4double cx = (x.min + (bx - 0.5) / x.scale()) * CLHEP::um;
+			if (!whole && (cx < regionX[0] || cx > regionX[1]))
+				continue;
+
+			// pixels out of the beam, and the beam tails of the whole
+			// image, don't count
+			G4int bin = by * (x.bins + 2) + bx;
+			G4double n = total.Count(bin);
+			if (n <= 0.0 || (whole && n < tail))
+				continue;
+			// a pixel of the region without the error estimate yet
+			if (n < entries)
+				return -1.0;
+
+			// standard error of the mean position, slices
+			G4double error = std::sqrt(total.Variance(bin) / n);
+			if (error > worst)
+				worst = error;
+			++pixels;
+		}
+	}
+	return pixels ? worst : -1.0;
+}
+
+} // namespace CarbonIonRadiography
@@ -31,6 +31,7 @@
 #include <G4GeometryManager.hh>
 #include <G4RunManager.hh>
 #include <G4ProductionCuts.hh>
+#include <G4ProductionCutsTable.hh>
 
 #include <G4UserLimits.hh>
 #include <G4UnitsTable.hh>
@@ -45,34 +46,28 @@
 #include <cstdio>
 
 #include "CIR_GlobalStrings.hh"
+#include "CIR_GeometryConfig.hh"
 #include "CIR_ParallelWorld.hh"
+#include "CIR_VoxelPhantom.hh"
+#include "CIR_CalorimeterFastModel.hh"
+#include "CIR_SiliconFastModel.hh"
+#include "CIR_DetectorMessenger.hh"
 //#include "CIR_StripGeometry.hh"
 #include "CIR_DetectorConstruction.hh"
 
 #define UNIFORM_BOX_SIZE 15.0
 
-namespace {
-
-const G4double world_x = CIR_SIZE_WORLD * CLHEP::mm / 2.0;
-const G4double world_y = CIR_SIZE_WORLD * CLHEP::mm / 2.0;
-const G4double world_z = CIR_SIZE_WORLD * CLHEP::mm / 2.0;
-
-const G4double calo_x = CIR_SIZE_CALORIMETER * CLHEP::mm / 2.0;
-const G4double calo_y = CIR_SIZE_CALORIMETER * CLHEP::mm / 2.0;
-const G4double calo_z = CIR_SIZE_CALORIMETER_THICKNESS * CLHEP::mm / 2.0;
-
-const G4double si_x = CIR_SIZE_SILICON * CLHEP::mm / 2.0;
-const G4double si_y = CIR_SIZE_SILICON * CLHEP::mm / 2.0;
-const G4double si_z = CIR_SIZE_SILICON_THICKNESS * CLHEP::um / 2.0;
-
-} // namespace
-
 namespace CarbonIonRadiography {
 
 DetectorConstruction::DetectorConstruction()
 	:
 	detectorMessenger(0),
 	parallelWorld(0),
+	voxelPhantom(0),
+	phantomName("cylinder"),
+	phantomPhysicalVolume(0),
+	phantomPosition( 0.0, 0.0, 80.0 * CLHEP::cm),
+	phantomAngle(0.0),
 	worldBox(0),
 	worldLogicalVolume(0),
 	worldPhysicalVolume(0),
@@ -87,20 +82,22 @@ DetectorConstruction::DetectorConstruction()
 	siliconPhysicalVolumes(CIR_NUMBER_OF_SILICON_DETECTORS),
 	siliconMaterial(0),
 	siliconRegions(CIR_NUMBER_OF_SILICON_DETECTORS),
-	worldSizeX(world_x), // half size
-	worldSizeY(world_y), // half size
-	worldSizeZ(world_z), // half size
-	calorimeterSizeX(calo_x), // half size
-	calorimeterSizeY(calo_y), // half size
-	calorimeterSizeZ(calo_z), // half size
-	siliconSizeX(si_x), // half size
-	siliconSizeY(si_y), // half size
-	siliconSizeZ(si_z) // half size
+	worldSizeX(0.0), // half size
+	worldSizeY(0.0), // half size
+	worldSizeZ(0.0), // half size
+	calorimeterSizeX(0.0), // half size
+	calorimeterSizeY(0.0), // half size
+	calorimeterSizeZ(0.0), // half size
+	siliconSizeX(0.0), // half size
+	siliconSizeY(0.0), // half size
+	siliconSizeZ(0.0) // half size
 {
 	// parallel world for phantom
 	parallelWorld = new ParallelWorld(ParallelWorldStr);
 
 	RegisterParallelWorld(parallelWorld);
+
+	detectorMessenger = new DetectorMessenger(this);
 }
 
 DetectorConstruction::~DetectorConstruction()
@@ -109,6 +106,8 @@ DetectorConstruction::~DetectorConstruction()
 		iter != siliconRegions.end(); ++iter) {
 		delete *iter;
 	}
+	delete detectorMessenger;
+	delete voxelPhantom;
 }
 
 G4VPhysicalVolume*
@@ -122,16 +121,39 @@ DetectorConstruction::Construct()
 	siliconMaterial = man->FindOrBuildMaterial("G4_Si");
 	calorimeterMaterial = man->FindOrBuildMaterial("G4_POLYSTYRENE");
 
+	ReadGeometryConfig();
 	ConstructWorld();
 	ConstructSiliconDetectors();
-	ConstructObject();
 
-	const TREC::StripGeometry* V = TREC::StripGeometry::get(TREC::MSD__V);
-	ConstructCalorimeter(V->z + calorimeterSizeZ + 10 * CLHEP::mm);
+	// new world, the phantoms of the previous one are gone
+	phantomVolumes.clear();
+	phantomPhysicalVolume = 0;
+	PlacePhantom();
+
+	const StripGeometry& V = GeometryConfig::instance().plane(MSD__V);
+	ConstructCalorimeter(V.z + calorimeterSizeZ + 10 * CLHEP::mm);
 
 	return worldPhysicalVolume;
 }
 
+void
+DetectorConstruction::ReadGeometryConfig()
+{
+	const GeometryConfig& config = GeometryConfig::instance();
+
+	worldSizeX = config.world_size() / 2.0;
+	worldSizeY = config.world_size() / 2.0;
+	worldSizeZ = config.world_size() / 2.0;
+
+	calorimeterSizeX = config.calorimeter_size() / 2.0;
+	calorimeterSizeY = config.calorimeter_size() / 2.0;
+	calorimeterSizeZ = config.calorimeter_thickness() / 2.0;
+
+	siliconSizeX = config.silicon_size() / 2.0;
+	siliconSizeY = config.silicon_size() / 2.0;
+	siliconSizeZ = config.silicon_thickness() / 2.0;
+}
+
 void
 DetectorConstruction::ConstructWorld()
 {
@@ -173,7 +195,7 @@ void
 DetectorConstruction::ConstructSiliconPlane( G4int pos,
 	const TREC::StripGeometryPair& pair)
 {
-	const TREC::StripGeometry& geom = pair.first;
+	const StripGeometry& geom = GeometryConfig::instance().plane(pos);
 	const TREC::StripGeometryNames& names = pair.second;
 
 	//---------------- Volume definition --- Silicon plane
@@ -203,6 +225,15 @@ DetectorConstruction::ConstructSiliconPlane( G4int pos,
 	attr->SetForceWireframe(true);
 	siliconLogicalVolumes[pos]->SetVisAttributes(attr);
 
+	// Region of the plane fast simulation with the default cuts
+	if (!siliconRegions[pos]) {
+		siliconRegions[pos] = new G4Region(names.logical_name);
+		siliconLogicalVolumes[pos]->SetRegion(siliconRegions[pos]);
+		siliconRegions[pos]->AddRootLogicalVolume(siliconLogicalVolumes[pos]);
+		siliconRegions[pos]->SetProductionCuts(
+			G4ProductionCutsTable::GetProductionCutsTable()->GetDefaultProductionCuts());
+	}
+
 /*
 	// **************
 	// Cut per Region
@@ -212,10 +243,6 @@ DetectorConstruction::ConstructSiliconPlane( G4int pos,
 	// the energy deposit with the required accuracy
 
 	if (!siliconRegions[pos]) {
-		siliconRegions[pos] = new G4Region(names.logical_name);
-		siliconLogicalVolumes[pos]->SetRegion(siliconRegions[pos]);
-		siliconRegions[pos]->AddRootLogicalVolume(siliconLogicalVolumes[pos]);
-
 		G4double cut = 150. * CLHEP::um;
 		G4ProductionCuts* cuts = new G4ProductionCuts;
 		cuts->SetProductionCut( cut, G4ProductionCuts::GetIndex("gamma"));
@@ -225,9 +252,151 @@ DetectorConstruction::ConstructSiliconPlane( G4int pos,
     }
 */
 }
+
+// PMMA cylinder with air, lung and bone inserts (default)
+G4VPhysicalVolume*
+DetectorConstruction::ConstructCylinderPhantom()
+{
+	//--------- Material definition ---------
+	G4NistManager* man = G4NistManager::Instance();
+	man->SetVerbose(0);
+	G4Material* pmmaMaterial = man->FindOrBuildMaterial("G4_PLEXIGLASS");
+	G4Material* airMaterial = man->FindOrBuildMaterial("G4_AIR");
+	G4Material* lungMaterial = man->FindOrBuildMaterial("G4_LUNG_ICRP");
+	G4Material* boneMaterial = man->FindOrBuildMaterial("G4_BONE_CORTICAL_ICRP");
+//	G4Material* boneMaterial = man->FindOrBuildMaterial("G4_Pb");
+
+
+	//---------------- Volume definition ------- Objects
+
+	G4Tubs* TubePMMA = new G4Tubs( "TubePMMA",
+		0. * CLHEP::cm,
+		2.5 * CLHEP::cm,
+		2.0 * CLHEP::cm,
+		0 * CLHEP::deg,
+		360 * CLHEP::deg
+	);
+
+	G4Tubs* TubeAIR1 = new G4Tubs( "TubeINSIDE",
+		0. * CLHEP::cm,
+		0.5 * CLHEP::cm,
+		2.0 * CLHEP::cm,
+		0 * CLHEP::deg,
+		360 * CLHEP::deg
+	);
+	G4VSolid* TubeAIR2 = TubeAIR1->Clone();
+	G4VSolid* TubeLUNG = TubeAIR1->Clone();
+	G4VSolid* TubeBONE = TubeAIR1->Clone();
 /*
-void
-DetectorConstruction::ConstructObject()
+	G4SubtractionSolid* sub1 = new G4SubtractionSolid( "Sub1",
+		TubePMMA, TubeAIR1, 0, G4ThreeVector( -1.25 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm));
+
+	G4SubtractionSolid* sub2 = new G4SubtractionSolid( "Sub2",
+		TubePMMA, TubeAIR2, 0, G4ThreeVector( 1.25 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm));
+
+	G4SubtractionSolid* sub3 = new G4SubtractionSolid( "Sub3",
+		TubePMMA, TubeLUNG, 0, G4ThreeVector( 0.0 * CLHEP::cm, -1.75 * CLHEP::cm, 0.0 * CLHEP::cm));
+
+	G4SubtractionSolid* sub4 = new G4SubtractionSolid( "Sub4",
+		TubePMMA, TubeBONE, 0, G4ThreeVector( 0.0 * CLHEP::cm, 1.75 * CLHEP::cm, 0.0 * CLHEP::cm));
+
+	G4LogicalVolume* pmmaLogicalVolume = new G4LogicalVolume(
+		sub4, pmmaMaterial, "PMMALog");
+*/
+
+	G4LogicalVolume* pmmaLogicalVolume = new G4LogicalVolume(
+		TubePMMA, pmmaMaterial, "PMMALog");
+
+	G4LogicalVolume* air1LogicalVolume = new G4LogicalVolume(
+		TubeAIR1, airMaterial, "AIR1Log");
+
+	G4LogicalVolume* air2LogicalVolume = new G4LogicalVolume(
+		TubeAIR2, airMaterial, "AIR2Log");
+
+	G4LogicalVolume* lungLogicalVolume = new G4LogicalVolume(
+		TubeLUNG, lungMaterial, "LUNGLog");
+
+	G4LogicalVolume* boneLogicalVolume = new G4LogicalVolume(
+		TubeBONE, boneMaterial, "BONELog");
+
+	G4PVPlacement* pmmaPhysicalVolume = new G4PVPlacement(
+		0,
+		phantomPosition,
+		"PMMAPhys",
+		pmmaLogicalVolume,
+		worldPhysicalVolume,
+		false,
+		0);
+
+	G4PVPlacement* air1PhysicalVolume = new G4PVPlacement(
+		0,
+		G4ThreeVector( -1.25 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm),
+		"AIR1Phys",
+		air1LogicalVolume,
+		pmmaPhysicalVolume,
+		false,
+		0);
+
+	G4PVPlacement* air2PhysicalVolume = new G4PVPlacement(
+		0,
+		G4ThreeVector( 1.25 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm),
+		"AIR2Phys",
+		air2LogicalVolume,
+		pmmaPhysicalVolume,
+		false,
+		0);
+
+	G4PVPlacement* lungPhysicalVolume = new G4PVPlacement(
+		0,
+		G4ThreeVector( 0.0 * CLHEP::cm, -1.75 * CLHEP::cm, 0.0 * CLHEP::cm),
+		"LUNGPhys",
+		lungLogicalVolume,
+		pmmaPhysicalVolume,
+		false,
+		0);
+
+	G4PVPlacement* bonePhysicalVolume = new G4PVPlacement(
+		0,
+		G4ThreeVector( 0.0 * CLHEP::cm, 1.75 * CLHEP::cm, 0.0 * CLHEP::cm),
+		"BONEPhys",
+		boneLogicalVolume,
+		pmmaPhysicalVolume,
+		false,
+		0);
+
+	G4RotationMatrix* matrix = new G4RotationMatrix();
+	matrix->rotateX(90.0 * CLHEP::deg);
+	matrix->rotateZ(21.0 * CLHEP::deg);
+	pmmaPhysicalVolume->SetRotation(matrix);
+
+	G4VisAttributes* attr = new G4VisAttributes(G4Colour::Blue());
+	attr->SetVisibility(true);
+	attr->SetForceWireframe(true);
+	pmmaLogicalVolume->SetVisAttributes(attr);
+
+	G4VisAttributes* attr1 = new G4VisAttributes(G4Colour::Cyan());
+	attr1->SetVisibility(true);
+	attr1->SetForceWireframe(true);
+	air1LogicalVolume->SetVisAttributes(attr1);
+	air2LogicalVolume->SetVisAttributes(attr1);
+
+	G4VisAttributes* attr2 = new G4VisAttributes(G4Colour::Yellow());
+	attr2->SetVisibility(true);
+	attr2->SetForceWireframe(true);
+	lungLogicalVolume->SetVisAttributes(attr2);
+
+
+	G4VisAttributes* attr3 = new G4VisAttributes(G4Colour::Red());
+	attr3->SetVisibility(true);
+	attr3->SetForceWireframe(true);
+	boneLogicalVolume->SetVisAttributes(attr3);
+
+	return pmmaPhysicalVolume;
+}
+
+// water box with muscle insert
+G4VPhysicalVolume*
+DetectorConstruction::ConstructWaterMusclePhantom()
 {
 	//--------- Material definition ---------
 	G4NistManager* man = G4NistManager::Instance();
@@ -251,8 +420,8 @@ DetectorConstruction::ConstructObject()
 
 	G4PVPlacement* WatPhysicalVolume = new G4PVPlacement(
 		0,
-		G4ThreeVector( 0.0, 0.0, 80.0 * CLHEP::cm),
-		"SolidSpherePhys",
+		phantomPosition,
+		"WaterPhys",
 		WatLogicalVolume,
 		worldPhysicalVolume,
 		false,
@@ -261,7 +430,7 @@ DetectorConstruction::ConstructObject()
 	new G4PVPlacement(
 		0,
 		G4ThreeVector( 0.0 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm),
-		"SolidTubePhys",
+		"MusclePhys",
 		MusLogicalVolume,
 		WatPhysicalVolume,
 		false,
@@ -276,11 +445,13 @@ DetectorConstruction::ConstructObject()
 	attr1->SetVisibility(true);
 	attr1->SetForceWireframe(true);
 	MusLogicalVolume->SetVisAttributes(attr1);
+
+	return WatPhysicalVolume;
 }
-*/
-/*
-void
-DetectorConstruction::ConstructObject()
+
+// PMMA sphere with water tube and kapton insert
+G4VPhysicalVolume*
+DetectorConstruction::ConstructSpherePhantom()
 {
 	//--------- Material definition ---------
 	G4NistManager* man = G4NistManager::Instance();
@@ -329,7 +500,7 @@ DetectorConstruction::ConstructObject()
 
 	G4PVPlacement* SpherePhysicalVolume = new G4PVPlacement(
 		0,
-		G4ThreeVector( 0.0, 0.0, 80.0 * CLHEP::cm),
+		phantomPosition,
 		"SolidSpherePhys",
 		SphereLogicalVolume,
 		worldPhysicalVolume,
@@ -348,7 +519,7 @@ DetectorConstruction::ConstructObject()
 	G4LogicalVolume* TubeInsideLogicalVolume = new G4LogicalVolume(
 		TubeInside, kaptonMaterial, "TubeInsideLog");
 
-	G4PVPlacement* TubeInsidePhysicalVolume = new G4PVPlacement(
+	new G4PVPlacement(
 		0,
 		G4ThreeVector( 0.25 * CLHEP::cm, 0.25 * CLHEP::cm, 0. * CLHEP::cm),
 		"TubeInsidePhys",
@@ -371,11 +542,13 @@ DetectorConstruction::ConstructObject()
 	attr2->SetVisibility(true);
 	attr2->SetForceWireframe(true);
 	SphereLogicalVolume->SetVisAttributes(attr2);
+
+	return SpherePhysicalVolume;
 }
-*/
-/*
-void
-DetectorConstruction::ConstructObject()
+
+// uniform box of the calorimeter material
+G4VPhysicalVolume*
+DetectorConstruction::ConstructBoxPhantom()
 {
 	//---------------- Volume definition ------- Objects
 	G4Box* box = new G4Box( "Object",
@@ -384,9 +557,9 @@ DetectorConstruction::ConstructObject()
 	G4LogicalVolume* boxLog = new G4LogicalVolume( box,
 		calorimeterMaterial, "ObjectLog");
 
-	new G4PVPlacement(
+	G4VPhysicalVolume* boxPhys = new G4PVPlacement(
 		0,
-		G4ThreeVector( 0, 0, 80 * CLHEP::cm),
+		phantomPosition,
 		"ObjectPhys",
 		boxLog,
 		worldPhysicalVolume,
@@ -398,145 +571,125 @@ DetectorConstruction::ConstructObject()
 	attr->SetVisibility(true);
 	attr->SetForceWireframe(true);
 	boxLog->SetVisAttributes(attr);
+
+	return boxPhys;
 }
-*/
 
-void
-DetectorConstruction::ConstructObject()
+G4VPhysicalVolume*
+DetectorConstruction::ConstructPhantom(const G4String& name)
 {
-	//--------- Material definition ---------
-	G4NistManager* man = G4NistManager::Instance();
-	man->SetVerbose(0);
-	G4Material* pmmaMaterial = man->FindOrBuildMaterial("G4_PLEXIGLASS");
-	G4Material* airMaterial = man->FindOrBuildMaterial("G4_AIR");
-	G4Material* lungMaterial = man->FindOrBuildMaterial("G4_LUNG_ICRP");
-	G4Material* boneMaterial = man->FindOrBuildMaterial("G4_BONE_CORTICAL_ICRP");
-//	G4Material* boneMaterial = man->FindOrBuildMaterial("G4_Pb");
-
-
-	//---------------- Volume definition ------- Objects
-
-	G4Tubs* TubePMMA = new G4Tubs( "TubePMMA",
-		0. * CLHEP::cm,
-		2.5 * CLHEP::cm,
-		2.0 * CLHEP::cm,
-		0 * CLHEP::deg,
-		360 * CLHEP::deg
-	);
-
-	G4Tubs* TubeAIR1 = new G4Tubs( "TubeINSIDE",
-		0. * CLHEP::cm,
-		0.5 * CLHEP::cm,
-		2.0 * CLHEP::cm,
-		0 * CLHEP::deg,
-		360 * CLHEP::deg
-	);
-	G4VSolid* TubeAIR2 = TubeAIR1->Clone();
-	G4VSolid* TubeLUNG = TubeAIR1->Clone();
-	G4VSolid* TubeBONE = TubeAIR1->Clone();
-/*
-	G4SubtractionSolid* sub1 = new G4SubtractionSolid( "Sub1",
-		TubePMMA, TubeAIR1, 0, G4ThreeVector( -1.25 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm));
-
-	G4SubtractionSolid* sub2 = new G4SubtractionSolid( "Sub2",
-		TubePMMA, TubeAIR2, 0, G4ThreeVector( 1.25 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm));
-
-	G4SubtractionSolid* sub3 = new G4SubtractionSolid( "Sub3",
-		TubePMMA, TubeLUNG, 0, G4ThreeVector( 0.0 * CLHEP::cm, -1.75 * CLHEP::cm, 0.0 * CLHEP::cm));
-
-	G4SubtractionSolid* sub4 = new G4SubtractionSolid( "Sub4",
-		TubePMMA, TubeBONE, 0, G4ThreeVector( 0.0 * CLHEP::cm, 1.75 * CLHEP::cm, 0.0 * CLHEP::cm));
-
-	G4LogicalVolume* pmmaLogicalVolume = new G4LogicalVolume(
-		sub4, pmmaMaterial, "PMMALog");
-*/
-
-	G4LogicalVolume* pmmaLogicalVolume = new G4LogicalVolume(
-		TubePMMA, pmmaMaterial, "PMMALog");
-
-	G4LogicalVolume* air1LogicalVolume = new G4LogicalVolume(
-		TubeAIR1, airMaterial, "AIR1Log");
-
-	G4LogicalVolume* air2LogicalVolume = new G4LogicalVolume(
-		TubeAIR2, airMaterial, "AIR2Log");
+	if (name == "cylinder")
+		return ConstructCylinderPhantom();
+	if (name == "water_muscle")
+		return ConstructWaterMusclePhantom();
+	if (name == "sphere")
+		return ConstructSpherePhantom();
+	if (name == "box")
+		return ConstructBoxPhantom();
+	if (name == "voxels" && voxelPhantom)
+		return voxelPhantom->Construct( worldLogicalVolume, phantomPosition,
+			worldMaterial);
+	return 0; // none
+}
 
-	G4LogicalVolume* lungLogicalVolume = new G4LogicalVolume(
-		TubeLUNG, lungMaterial, "LUNGLog");
+void
+DetectorConstruction::PlacePhantom()
+{
+	// the phantoms are built once and then only moved in and out of
+	// the world, so the other volumes and their tables stay untouched
+	if (phantomPhysicalVolume) {
+		worldLogicalVolume->RemoveDaughter(phantomPhysicalVolume);
+		phantomPhysicalVolume = 0;
+	}
 
-	G4LogicalVolume* boneLogicalVolume = new G4LogicalVolume(
-		TubeBONE, boneMaterial, "BONELog");
+	std::map< G4String, G4VPhysicalVolume*>::iterator it =
+		phantomVolumes.find(phantomName);
+	if (it == phantomVolumes.end()) {
+		// placed into the world by the construction
+		phantomPhysicalVolume = ConstructPhantom(phantomName);
+		phantomVolumes[phantomName] = phantomPhysicalVolume;
+	}
+	else {
+		phantomPhysicalVolume = it->second;
+		if (phantomPhysicalVolume)
+			worldLogicalVolume->AddDaughter(phantomPhysicalVolume);
+	}
 
-	G4PVPlacement* pmmaPhysicalVolume = new G4PVPlacement(
-		0,
-		G4ThreeVector( 0.0, 0.0, 80.0 * CLHEP::cm),
-		"PMMAPhys",
-		pmmaLogicalVolume,
-		worldPhysicalVolume,
-		false,
-		0);
+	if (phantomPhysicalVolume) {
+		phantomPhysicalVolume->SetTranslation(phantomPosition);
+		RotatePhantom();
+	}
+}
 
-	G4PVPlacement* air1PhysicalVolume = new G4PVPlacement(
-		0,
-		G4ThreeVector( -1.25 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm),
-		"AIR1Phys",
-		air1LogicalVolume,
-		pmmaPhysicalVolume,
-		false,
-		0);
+void
+DetectorConstruction::RotatePhantom()
+{
+	if (!phantomPhysicalVolume)
+		return;
+
+	// the construction rotation is kept for all the following angles
+	if (!phantomBaseRotations.count(phantomName)) {
+		const G4RotationMatrix* rotation = phantomPhysicalVolume->GetRotation();
+		phantomBaseRotations[phantomName] = rotation ? *rotation :
+			G4RotationMatrix();
+	}
 
-	G4PVPlacement* air2PhysicalVolume = new G4PVPlacement(
-		0,
-		G4ThreeVector( 1.25 * CLHEP::cm, 0.0 * CLHEP::cm, 0.0 * CLHEP::cm),
-		"AIR2Phys",
-		air2LogicalVolume,
-		pmmaPhysicalVolume,
-		false,
-		0);
+	// frame rotation of the placement is the inverse of the object one,
+	// the map element lives as long as the phantom
+	G4RotationMatrix turn;
+	turn.rotateY(-phantomAngle);
+	G4RotationMatrix& rotation = phantomRotations[phantomName];
+	rotation = phantomBaseRotations[phantomName] * turn;
+	phantomPhysicalVolume->SetRotation(&rotation);
+}
 
-	G4PVPlacement* lungPhysicalVolume = new G4PVPlacement(
-		0,
-		G4ThreeVector( 0.0 * CLHEP::cm, -1.75 * CLHEP::cm, 0.0 * CLHEP::cm),
-		"LUNGPhys",
-		lungLogicalVolume,
-		pmmaPhysicalVolume,
-		false,
-		0);
+G4String
+DetectorConstruction::PhantomNames()
+{
+	return "cylinder water_muscle sphere box voxels none";
+}
 
-	G4PVPlacement* bonePhysicalVolume = new G4PVPlacement(
-		0,
-		G4ThreeVector( 0.0 * CLHEP::cm, 1.75 * CLHEP::cm, 0.0 * CLHEP::cm),
-		"BONEPhys",
-		boneLogicalVolume,
-		pmmaPhysicalVolume,
-		false,
-		0);
+G4bool
+DetectorConstruction::SelectPhantom(const G4String& name)
+{
+	if (name == "voxels" && !voxelPhantom) {
+		G4cerr << "No voxelized phantom, use /phantom/voxels" << G4endl;
+		return false;
+	}
 
-	G4RotationMatrix* matrix = new G4RotationMatrix();
-	matrix->rotateX(90.0 * CLHEP::deg);
-	matrix->rotateZ(21.0 * CLHEP::deg);
-	pmmaPhysicalVolume->SetRotation(matrix);
+	phantomName = name;
+	G4cout << "Phantom: " << phantomName << G4endl;
 
-	G4VisAttributes* attr = new G4VisAttributes(G4Colour::Blue());
-	attr->SetVisibility(true);
-	attr->SetForceWireframe(true);
-	pmmaLogicalVolume->SetVisAttributes(attr);
+	// Idle state, the geometry is reoptimized before the next run,
+	// the physics tables are kept
+	if (worldLogicalVolume) {
+		PlacePhantom();
+		G4RunManager::GetRunManager()->GeometryHasBeenModified();
+	}
+	return true;
+}
 
-	G4VisAttributes* attr1 = new G4VisAttributes(G4Colour::Cyan());
-	attr1->SetVisibility(true);
-	attr1->SetForceWireframe(true);
-	air1LogicalVolume->SetVisAttributes(attr1);
-	air2LogicalVolume->SetVisAttributes(attr1);
+void
+DetectorConstruction::SetPhantomPosition(const G4ThreeVector& position)
+{
+	phantomPosition = position;
 
-	G4VisAttributes* attr2 = new G4VisAttributes(G4Colour::Yellow());
-	attr2->SetVisibility(true);
-	attr2->SetForceWireframe(true);
-	lungLogicalVolume->SetVisAttributes(attr2);
+	if (worldLogicalVolume && phantomPhysicalVolume) {
+		phantomPhysicalVolume->SetTranslation(phantomPosition);
+		G4RunManager::GetRunManager()->GeometryHasBeenModified();
+	}
+}
 
+void
+DetectorConstruction::SetPhantomAngle(G4double angle)
+{
+	phantomAngle = angle;
 
-	G4VisAttributes* attr3 = new G4VisAttributes(G4Colour::Red());
-	attr3->SetVisibility(true);
-	attr3->SetForceWireframe(true);
-	boneLogicalVolume->SetVisAttributes(attr3);
+	// Idle state, the geometry is reoptimized before the next run
+	if (worldLogicalVolume && phantomPhysicalVolume) {
+		RotatePhantom();
+		G4RunManager::GetRunManager()->GeometryHasBeenModified();
+	}
 }
 
 void
@@ -586,6 +739,14 @@ DetectorConstruction::ConstructCalorimeter(G4double offset_z)
 void
 DetectorConstruction::ConstructSDandField()
 {
+	// thread local model, active with /fastsim/calorimeter
+	new CalorimeterFastModel( CalorimeterFastModelStr, calorimeterRegion);
+
+	// thread local models of the planes, active with /fastsim/silicon
+	for ( G4int pos = 0; pos < CIR_NUMBER_OF_SILICON_DETECTORS; ++pos) {
+		new SiliconFastModel( SiliconFastModelStr + siliconRegions[pos]->GetName(),
+			siliconRegions[pos], pos);
+	}
 }
 
 void
@@ -594,4 +755,29 @@ DetectorConstruction::UpdateGeometry()
 	G4cout << "Update" << G4endl;
 }
 
+G4bool
+DetectorConstruction::SetVoxelPhantom(const G4String& header)
+{
+	VoxelPhantom* phantom = new VoxelPhantom;
+	if (!phantom->Load(header)) {
+		delete phantom;
+		return false;
+	}
+
+	// the container of the previous voxelized phantom is left out
+	std::map< G4String, G4VPhysicalVolume*>::iterator it =
+		phantomVolumes.find("voxels");
+	if (it != phantomVolumes.end()) {
+		if (it->second == phantomPhysicalVolume && phantomPhysicalVolume) {
+			worldLogicalVolume->RemoveDaughter(phantomPhysicalVolume);
+			phantomPhysicalVolume = 0;
+		}
+		phantomVolumes.erase(it);
+	}
+
+	delete voxelPhantom;
+	voxelPhantom = phantom;
+	return SelectPhantom("voxels");
+}
+
 } // namespace CarbonIonRadiography
@@ -0,0 +1,173 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4UIdirectory.hh>
+#include <G4UIcmdWithAString.hh>
+#include <G4UIcmdWithoutParameter.hh>
+#include <G4UIcmdWith3VectorAndUnit.hh>
+#include <G4UIcmdWithADoubleAndUnit.hh>
+
+#include <sstream>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_DetectorConstruction.hh"
+#include "CIR_DetectorMessenger.hh"
+
+namespace CarbonIonRadiography {
+
+DetectorMessenger::DetectorMessenger(DetectorConstruction* construction)
+	:
+	detector(construction),
+	detector_dir(0),
+	load_cmd(0),
+	set_cmd(0),
+	print_cmd(0),
+	phantom_dir(0),
+	select_cmd(0),
+	voxels_cmd(0),
+	position_cmd(0),
+	angle_cmd(0)
+{
+	// Detector geometry directory
+	detector_dir = new G4UIdirectory("/detector/");
+	detector_dir->SetGuidance("Detector geometry parameters of the run");
+
+	// Geometry file
+	load_cmd = new G4UIcmdWithAString(
+		"/detector/load", this);
+
+	load_cmd->SetGuidance("Load the geometry parameters from the file of");
+	load_cmd->SetGuidance("\"key value\" lines (see CIR_GeometryConfig.hh).");
+	load_cmd->SetParameterName( "GeometryFile", false);
+	load_cmd->AvailableForStates(G4State_PreInit);
+
+	// Single parameter
+	set_cmd = new G4UIcmdWithAString(
+		"/detector/set", this);
+
+	set_cmd->SetGuidance("Set the geometry parameter: key value");
+	set_cmd->SetGuidance("e.g. /detector/set calorimeter_thickness 300");
+	set_cmd->SetGuidance("     /detector/set plane U 1320000 -10.5");
+	set_cmd->SetParameterName( "KeyValue", false);
+	set_cmd->AvailableForStates(G4State_PreInit);
+
+	// Print parameters
+	print_cmd = new G4UIcmdWithoutParameter(
+		"/detector/print", this);
+
+	print_cmd->SetGuidance("Print the geometry parameters.");
+
+	// Phantom directory
+	phantom_dir = new G4UIdirectory("/phantom/");
+	phantom_dir->SetGuidance("Commands to select the phantom");
+
+	// Catalog phantom
+	select_cmd = new G4UIcmdWithAString(
+		"/phantom/select", this);
+
+	select_cmd->SetGuidance("Select the phantom of the catalog. Between runs");
+	select_cmd->SetGuidance("only the geometry is reoptimized, so a campaign");
+	select_cmd->SetGuidance("of phantoms runs in one process.");
+	select_cmd->SetParameterName( "Phantom", false);
+	select_cmd->SetCandidates(DetectorConstruction::PhantomNames());
+	select_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	select_cmd->SetToBeBroadcasted(false);
+
+	// Voxelized phantom
+	voxels_cmd = new G4UIcmdWithAString(
+		"/phantom/voxels", this);
+
+	voxels_cmd->SetGuidance("Load the voxelized phantom from the header");
+	voxels_cmd->SetGuidance("file (see CIR_VoxelPhantom.hh) and select it");
+	voxels_cmd->SetGuidance("instead of the default PMMA cylinder.");
+	voxels_cmd->SetParameterName( "PhantomHeader", false);
+	voxels_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	voxels_cmd->SetToBeBroadcasted(false);
+
+	// Phantom position
+	position_cmd = new G4UIcmdWith3VectorAndUnit(
+		"/phantom/position", this);
+
+	position_cmd->SetGuidance("Position of the phantom center.");
+	position_cmd->SetParameterName( "X", "Y", "Z", false);
+	position_cmd->SetDefaultUnit("cm");
+	position_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	position_cmd->SetToBeBroadcasted(false);
+
+	// Phantom rotation
+	angle_cmd = new G4UIcmdWithADoubleAndUnit(
+		"/phantom/angle", this);
+
+	angle_cmd->SetGuidance("Rotation of the phantom around the vertical axis,");
+	angle_cmd->SetGuidance("the projection angle. Between runs only the");
+	angle_cmd->SetGuidance("geometry is reoptimized.");
+	angle_cmd->SetParameterName( "Angle", false);
+	angle_cmd->SetDefaultUnit("deg");
+	angle_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	angle_cmd->SetToBeBroadcasted(false);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+DetectorMessenger::~DetectorMessenger()
+{
+	delete load_cmd;
+	delete set_cmd;
+	delete print_cmd;
+	delete detector_dir;
+	delete select_cmd;
+	delete voxels_cmd;
+	delete position_cmd;
+	delete angle_cmd;
+	delete phantom_dir;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+DetectorMessenger::SetNewValue( G4UIcommand* command, G4String newValue)
+{
+	if (command == load_cmd) {
+		GeometryConfig::instance().load(newValue);
+	}
+	else if (command == set_cmd) {
+		std::istringstream fields(newValue);
+		std::string key, value;
+		fields >> key;
+		std::getline( fields >> std::ws, value);
+		GeometryConfig::instance().set( key, value);
+	}
+	else if (command == print_cmd) {
+		GeometryConfig::instance().print();
+	}
+	else if (command == select_cmd) {
+		detector->SelectPhantom(newValue);
+	}
+	else if (command == voxels_cmd) {
+		detector->SetVoxelPhantom(newValue);
+	}
+	else if (command == position_cmd) {
+		detector->SetPhantomPosition(
+			G4UIcmdWith3VectorAndUnit::GetNew3VectorValue(newValue));
+	}
+	else if (command == angle_cmd) {
+		detector->SetPhantomAngle(
+			G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+	}
+}
+
+} // namespace CarbonIonRadiography
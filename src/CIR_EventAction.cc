@@ -32,18 +32,11 @@
 #include "CIR_Defines.hh"
 #include "CIR_Track.hh"
 #include "CIR_GlobalStrings.hh"
+#include "CIR_GeometryConfig.hh"
 //#include "CIR_StripGeometry.hh"
 #include "CIR_EventActionMessenger.hh"
 #include "CIR_EventAction.hh"
 
-namespace {
-
-G4double calo_z = CIR_SIZE_CALORIMETER_THICKNESS * CLHEP::mm;
-G4double calo_slice_z = CIR_SIZE_CALORIMETER_SLICE_THICKNESS * CLHEP::um;
-G4int calo_slices = calo_z / calo_slice_z;
-
-}
-
 namespace CarbonIonRadiography {
 
 EventAction::EventAction()
@@ -55,7 +48,16 @@ EventAction::EventAction()
 	positions(),
 	threshold_energy_calo_slice(150.0 * CLHEP::MeV),
 	threshold_energy_si_strips(4.0 * CLHEP::MeV),
-	mod(100)
+	mod(100),
+	projection_mode(false),
+	track_ok(false),
+	track_x(0.0),
+	track_y(0.0),
+	track_position(-1),
+	calo_fast_simulation(false),
+	silicon_fast_simulation(false),
+	ray_cast_mode(false),
+	ray_ok(false)
 {
 	event_action_messenger = new EventActionMessenger(this);
 }
@@ -74,12 +76,13 @@ EventAction::BeginOfEventAction(const G4Event* event)
 		G4cout << G4endl << "---> Begin of Event: " << number << G4endl;
 
 	G4SDManager* pSDManager = G4SDManager::GetSDMpointer();
+	const GeometryConfig& config = GeometryConfig::instance();
 
 	// Init calorimeter (only once)
 	if (calorimeterID == -1) {
 		G4String collection_id = CalorimeterStr + G4String("/EnergyDeposit");
 		calorimeterID = pSDManager->GetCollectionID(collection_id);
-		coordinates.calo.resize(calo_slices);
+		coordinates.calo.resize(config.calorimeter_slices());
 	}
 
 	// Init silicon planes (only once)
@@ -96,7 +99,7 @@ EventAction::BeginOfEventAction(const G4Event* event)
 
 			TREC::StripGeometryType plane = TREC::StripGeometry::index(pos);
 			G4DataVector& energy = coordinates.energy[plane];
-			energy.resize(CIR_NUMBER_OF_STRIPS_PER_SILICON);
+			energy.resize(config.silicon_strips());
 		}
 	}
 
@@ -108,6 +111,8 @@ EventAction::BeginOfEventAction(const G4Event* event)
 
 	// clear energy deposition in calorimeter
 	std::fill( coordinates.calo.begin(), coordinates.calo.end(), 0.0);
+
+	ray_ok = false;
 }
 
 void
@@ -115,6 +120,8 @@ EventAction::EndOfEventAction(const G4Event* event)
 {
 	G4HCofThisEvent* HCE = event->GetHCofThisEvent();
 	G4THitsMap<G4double>* energy = 0;
+
+	track_ok = false;
 	if (!HCE)
 		return;
 
@@ -135,9 +142,31 @@ EventAction::EndOfEventAction(const G4Event* event)
 		}
 	}
 	
-	FinalHitCoordinates final_hit(coordinates);
+	FinalHitCoordinates final_hit( coordinates, threshold_energy_si_strips,
+		threshold_energy_calo_slice);
 
-	positions = final_hit.getPositions();
+	if (!projection_mode) {
+		positions = final_hit.getPositions();
+		return;
+	}
+
+	// fit the tracks, only the full track in the middle plane is kept
+	G4bool main = false, full = false;
+	final_hit.calculateCoordinates();
+	final_hit.calculateTracks( main, full);
+	if (full) {
+		const GeometryConfig& config = GeometryConfig::instance();
+		const StripGeometry& x2 = config.plane(MSD_X2);
+		const StripGeometry& x3 = config.plane(MSD_X3);
+		const StripGeometry& y2 = config.plane(MSD_Y2);
+		const StripGeometry& y3 = config.plane(MSD_Y3);
+
+		TrackXYPair track = final_hit.getTrack(true);
+		track_x = track.first.fit((x2.z + x3.z) / 2.0);
+		track_y = track.second.fit((y2.z + y3.z) / 2.0);
+		track_position = final_hit.slice();
+		track_ok = true;
+	}
 }
 
 G4bool
@@ -155,6 +184,13 @@ EventAction::fillEnergyCoordinates( G4int pos, G4THitsMap<G4double>* energy)
 	return res;
 }
 
+void
+EventAction::addSiliconEnergy( G4int pos, G4int strip, G4double energy)
+{
+	TREC::StripGeometryType type = TREC::StripGeometry::index(pos);
+	coordinates.energy[type][strip] += energy;
+}
+
 void
 EventAction::update()
 {
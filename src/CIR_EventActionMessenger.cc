@@ -20,6 +20,7 @@
 #include <G4UIdirectory.hh>
 #include <G4UIcmdWithADoubleAndUnit.hh>
 #include <G4UIcmdWithoutParameter.hh>
+#include <G4UIcmdWithABool.hh>
 #include <G4SystemOfUnits.hh>
 
 #include "CIR_EventAction.hh"
@@ -33,7 +34,13 @@ EventActionMessenger::EventActionMessenger(EventAction* event)
 	energy_thres_dir(0),
 	thres_calo_slice_cmd(0),
 	thres_si_strips_cmd(0),
-	update_cmd(0)
+	update_cmd(0),
+	output_dir(0),
+	projection_cmd(0),
+	raycast_cmd(0),
+	fastsim_dir(0),
+	fast_calo_cmd(0),
+	fast_silicon_cmd(0)
 {
 	// Threshold directory
 	energy_thres_dir = new G4UIdirectory("/thres/");
@@ -77,6 +84,60 @@ EventActionMessenger::EventActionMessenger(EventAction* event)
 	update_cmd->SetGuidance("This command MUST be applied before \"beamOn\" ");
 	update_cmd->SetGuidance("if you changed threshold value(s).");
 	update_cmd->AvailableForStates(G4State_Idle);
+
+	// Output directory
+	output_dir = new G4UIdirectory("/output/");
+	output_dir->SetGuidance("Commands to select the run output");
+
+	// Projection mode
+	projection_cmd = new G4UIcmdWithABool(
+		"/output/projection", this);
+
+	projection_cmd->SetGuidance("Fit tracks during the run and accumulate");
+	projection_cmd->SetGuidance("the projection grid instead of saving hits.");
+	projection_cmd->SetGuidance("The grid is saved to \"projection.dat\" and");
+	projection_cmd->SetGuidance("the images to \"projection.root\".");
+	projection_cmd->SetParameterName( "ProjectionMode", true);
+	projection_cmd->SetDefaultValue(true);
+	projection_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+	// Ray casting mode
+	raycast_cmd = new G4UIcmdWithABool(
+		"/output/raycast", this);
+
+	raycast_cmd->SetGuidance("Cast straight rays of the primaries through the");
+	raycast_cmd->SetGuidance("geometry instead of the transport. The water");
+	raycast_cmd->SetGuidance("equivalent thickness image is saved to");
+	raycast_cmd->SetGuidance("\"raycast.root\", the rays to \"rays.dat\".");
+	raycast_cmd->SetParameterName( "RayCastMode", true);
+	raycast_cmd->SetDefaultValue(true);
+	raycast_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+	// Fast simulation directory
+	fastsim_dir = new G4UIdirectory("/fastsim/");
+	fastsim_dir->SetGuidance("Fast simulation of the detector regions");
+
+	// Calorimeter fast simulation
+	fast_calo_cmd = new G4UIcmdWithABool(
+		"/fastsim/calorimeter", this);
+
+	fast_calo_cmd->SetGuidance("Ions entering the calorimeter deposit the");
+	fast_calo_cmd->SetGuidance("parameterized Bragg curve into the slices");
+	fast_calo_cmd->SetGuidance("instead of the full transport, set per run.");
+	fast_calo_cmd->SetParameterName( "CalorimeterFastSimulation", true);
+	fast_calo_cmd->SetDefaultValue(true);
+	fast_calo_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+	// Silicon planes fast simulation
+	fast_silicon_cmd = new G4UIcmdWithABool(
+		"/fastsim/silicon", this);
+
+	fast_silicon_cmd->SetGuidance("Protons and ions cross the silicon planes");
+	fast_silicon_cmd->SetGuidance("with the sampled energy loss and multiple");
+	fast_silicon_cmd->SetGuidance("scattering instead of the full transport.");
+	fast_silicon_cmd->SetParameterName( "SiliconFastSimulation", true);
+	fast_silicon_cmd->SetDefaultValue(true);
+	fast_silicon_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -86,6 +147,12 @@ EventActionMessenger::~EventActionMessenger()
 	delete thres_calo_slice_cmd;
 	delete thres_si_strips_cmd;
 	delete energy_thres_dir;
+	delete projection_cmd;
+	delete raycast_cmd;
+	delete output_dir;
+	delete fast_calo_cmd;
+	delete fast_silicon_cmd;
+	delete fastsim_dir;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -103,6 +170,22 @@ EventActionMessenger::SetNewValue( G4UIcommand* command, G4String newValue)
 	else if (command == update_cmd) {
 		event_action->update();
 	}
+	else if (command == projection_cmd) {
+		G4bool flag = G4UIcmdWithABool::GetNewBoolValue(newValue);
+		event_action->setProjectionMode(flag);
+	}
+	else if (command == raycast_cmd) {
+		G4bool flag = G4UIcmdWithABool::GetNewBoolValue(newValue);
+		event_action->setRayCastMode(flag);
+	}
+	else if (command == fast_calo_cmd) {
+		G4bool flag = G4UIcmdWithABool::GetNewBoolValue(newValue);
+		event_action->setCaloFastSimulation(flag);
+	}
+	else if (command == fast_silicon_cmd) {
+		G4bool flag = G4UIcmdWithABool::GetNewBoolValue(newValue);
+		event_action->setSiliconFastSimulation(flag);
+	}
 }
 
 } // namespace CarbonIonRadiography
@@ -0,0 +1,40 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <Randomize.hh>
+
+#include "CIR_Campaign.hh"
+#include "CIR_EventSeeding.hh"
+
+namespace CarbonIonRadiography {
+
+G4bool EventSeeding::enabled = false;
+G4long EventSeeding::runSeed = 1;
+G4int EventSeeding::eventOffset = 0;
+std::vector<G4int> EventSeeding::eventIDs;
+
+void
+EventSeeding::Reseed(G4int eventID)
+{
+	long seeds[3] = { 0, 0, 0 };
+	random_stream_seeds( runSeed, GlobalEventID(eventID), seeds);
+	CLHEP::HepRandom::setTheSeeds(seeds);
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,228 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4PhysicalConstants.hh>
+#include <G4ios.hh>
+
+#include <TH2.h>
+#include <TH3.h>
+
+#include <gsl/gsl_fft_real.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+
+#include <cmath>
+#include <algorithm>
+
+#include "CIR_Parallel.hh"
+#include "CIR_FilteredBackProjection.hh"
+
+namespace {
+
+// side of the square tiles of the back-projection (pixels)
+const G4int back_projection_tile = 32;
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+FilteredBackProjection::FilteredBackProjection( const HistogramAxis& u,
+	const HistogramAxis& v)
+	:
+	u_(u),
+	v_(v),
+	threads_(0),
+	sinograms_(v.bins),
+	fft_size_(1)
+{
+	// linear convolution of the row with the kernel without wrap around
+	while (fft_size_ < size_t(2 * u_.bins))
+		fft_size_ <<= 1;
+
+	// Ram-Lak kernel in the space domain (Kak and Slaney): h(0) = 1/(4 tau^2),
+	// h(n) = -1/(n pi tau)^2 for odd n, 0 for even n; tau in mm
+	const G4double tau = (u_.max - u_.min) / u_.bins / 1000.0;
+	std::vector<G4double> kernel( fft_size_, 0.0);
+	kernel[0] = 1.0 / (4.0 * tau * tau);
+	for ( size_t n = 1; n < fft_size_ / 2; n += 2) {
+		G4double h = -1.0 / (n * n * CLHEP::pi * CLHEP::pi * tau * tau);
+		kernel[n] = h;
+		kernel[fft_size_ - n] = h;
+	}
+
+	// the kernel is real and even, so its transform is real,
+	// tau -- the convolution step
+	gsl_fft_real_radix2_transform( &kernel[0], 1, fft_size_);
+	response_.resize(fft_size_ / 2 + 1);
+	for ( size_t i = 0; i <= fft_size_ / 2; ++i)
+		response_[i] = kernel[i] * tau;
+}
+
+G4bool
+FilteredBackProjection::add_projection( G4double angle,
+	const Histogram2D<G4double>& image)
+{
+	const HistogramAxis& x = image.axis_x();
+	const HistogramAxis& y = image.axis_y();
+	if (x.bins != u_.bins || x.min != u_.min || x.max != u_.max ||
+		y.bins != v_.bins || y.min != v_.min || y.max != v_.max) {
+		G4cerr << "FilteredBackProjection: projection binning differs" << G4endl;
+		return false;
+	}
+
+	angles_.push_back(angle);
+	for ( G4int s = 0; s < v_.bins; ++s) {
+		std::vector<G4double>& sinogram = sinograms_[s];
+		for ( G4int i = 0; i < u_.bins; ++i) {
+			// bins 1 ... n, without underflow and overflow
+			const Histogram2D<G4double>::Bin& b = image.bin( i + 1, s + 1);
+			sinogram.push_back( (b.count > 0.0) ? b.sum / b.count : 0.0);
+		}
+	}
+	return true;
+}
+
+void
+FilteredBackProjection::filter(std::vector<G4double>& sinogram) const
+{
+	const size_t n = fft_size_;
+	const size_t bins = u_.bins;
+	std::vector<G4double> row(n);
+
+	for ( size_t p = 0; p < angles_.size(); ++p) {
+		G4double* values = &sinogram[p * bins];
+		std::fill( row.begin(), row.end(), 0.0);
+		std::copy( values, values + bins, row.begin());
+
+		// halfcomplex: real parts in 0 ... n/2, imaginary in n - 1 ... n/2 + 1
+		gsl_fft_real_radix2_transform( &row[0], 1, n);
+		row[0] *= response_[0];
+		for ( size_t i = 1; i < n / 2; ++i) {
+			row[i] *= response_[i];
+			row[n - i] *= response_[i];
+		}
+		row[n / 2] *= response_[n / 2];
+		gsl_fft_halfcomplex_radix2_inverse( &row[0], 1, n);
+
+		std::copy( row.begin(), row.begin() + bins, values);
+	}
+}
+
+void
+FilteredBackProjection::back_project( const std::vector<G4double>& sinogram,
+	G4double* slice) const
+{
+	const G4int n = u_.bins;
+	const G4int tile = back_projection_tile;
+	const G4double du = (u_.max - u_.min) / n;
+	const size_t projections = angles_.size();
+
+	// pixels of the slice have the detector bins along X and Z, the rotation
+	// axis is at u = 0; detector coordinate of the pixel t = x cos(a) + z sin(a)
+	std::vector<G4double> c(projections), s(projections);
+	for ( size_t p = 0; p < projections; ++p) {
+		c[p] = std::cos(angles_[p]);
+		s[p] = std::sin(angles_[p]);
+	}
+
+	for ( G4int z0 = 0; z0 < n; z0 += tile) {
+		const G4int z1 = std::min( z0 + tile, n);
+		for ( G4int x0 = 0; x0 < n; x0 += tile) {
+			const G4int x1 = std::min( x0 + tile, n);
+			const G4double x = u_.min + (x0 + 0.5) * du;
+			for ( size_t p = 0; p < projections; ++p) {
+				const G4double* q = &sinogram[p * n];
+				for ( G4int iz = z0; iz < z1; ++iz) {
+					const G4double z = u_.min + (iz + 0.5) * du;
+					// position in the filtered row (bins), linear interpolation
+					G4double f = (x * c[p] + z * s[p] - u_.min) / du - 0.5;
+					G4double* out = slice + iz * n;
+					for ( G4int ix = x0; ix < x1; ++ix, f += c[p]) {
+						G4int i = G4int(std::floor(f));
+						if (i < 0 || i + 1 >= n)
+							continue;
+						G4double w = f - i;
+						out[ix] += q[i] + w * (q[i + 1] - q[i]);
+					}
+				}
+			}
+		}
+	}
+
+	// uniform angles over pi or 2 pi
+	const G4double scale = projections ? CLHEP::pi / projections : 0.0;
+	for ( G4int i = 0; i < n * n; ++i)
+		slice[i] *= scale;
+}
+
+void
+FilteredBackProjection::reconstruct(std::vector<G4double>& volume) const
+{
+	const size_t n = u_.bins;
+	const size_t slices = v_.bins;
+	volume.assign( slices * n * n, 0.0);
+	if (angles_.empty())
+		return;
+
+	parallel_for( slices, threads_,
+		[&]( G4int, size_t begin, size_t end) {
+			for ( size_t s = begin; s < end; ++s) {
+				std::vector<G4double> sinogram(sinograms_[s]);
+				filter(sinogram);
+				back_project( sinogram, &volume[s * n * n]);
+			}
+		});
+}
+
+TH3D*
+FilteredBackProjection::create_volume( const char* name, const char* title,
+	const std::vector<G4double>& volume) const
+{
+	// x, slice (y) and z axes of the volume, um
+	const G4int n = u_.bins;
+	TH3D* hist = new TH3D( name, title, n, u_.min, u_.max,
+		v_.bins, v_.min, v_.max, n, u_.min, u_.max);
+
+	for ( G4int s = 0; s < v_.bins; ++s) {
+		for ( G4int z = 0; z < n; ++z) {
+			for ( G4int x = 0; x < n; ++x)
+				hist->SetBinContent( x + 1, s + 1, z + 1,
+					volume[(size_t(s) * n + z) * n + x]);
+		}
+	}
+	return hist;
+}
+
+TH2D*
+FilteredBackProjection::create_sinogram( const char* name, const char* title,
+	G4int slice) const
+{
+	const G4int n = u_.bins;
+	const G4int projections = angles_.size();
+	TH2D* hist = new TH2D( name, title, n, u_.min, u_.max,
+		projections, 0, projections);
+
+	const std::vector<G4double>& sinogram = sinograms_[slice];
+	for ( G4int p = 0; p < projections; ++p) {
+		for ( G4int i = 0; i < n; ++i)
+			hist->SetBinContent( i + 1, p + 1, sinogram[p * n + i]);
+	}
+	return hist;
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,218 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4SystemOfUnits.hh>
+#include <G4ios.hh>
+
+#include <fstream>
+#include <sstream>
+
+#include "CIR_Defines.hh"
+#include "CIR_GeometryConfig.hh"
+
+namespace {
+
+const char* plane_names[CIR_NUMBER_OF_SILICON_DETECTORS] = {
+	"Y1", "X1", "Y2", "X2", "Y3", "X3", "U", "V"
+};
+
+// plane index of the name, -1 if unknown
+G4int
+plane_index(const std::string& name)
+{
+	for ( G4int i = 0; i < CIR_NUMBER_OF_SILICON_DETECTORS; ++i) {
+		if (name == plane_names[i])
+			return i;
+	}
+	return -1;
+}
+
+// positive value in the unit
+G4bool
+read_value( std::istringstream& fields, G4double unit, G4double& value)
+{
+	G4double v = 0.0;
+	if (!(fields >> v) || v <= 0.0)
+		return false;
+	value = v * unit;
+	return true;
+}
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+GeometryConfig::GeometryConfig()
+	:
+	energy_per_nucleon_(CIR_ENERGY_PER_NUCLEON * CLHEP::MeV),
+	beam_distance_(CIR_DISTANCE_BEAM_Y1 * CLHEP::mm),
+	world_size_(CIR_SIZE_WORLD * CLHEP::mm),
+	silicon_size_(CIR_SIZE_SILICON * CLHEP::mm),
+	silicon_thickness_(CIR_SIZE_SILICON_THICKNESS * CLHEP::um),
+	silicon_strips_(CIR_NUMBER_OF_STRIPS_PER_SILICON),
+	calorimeter_size_(CIR_SIZE_CALORIMETER * CLHEP::mm),
+	calorimeter_thickness_(CIR_SIZE_CALORIMETER_THICKNESS * CLHEP::mm),
+	calorimeter_slice_thickness_(CIR_SIZE_CALORIMETER_SLICE_THICKNESS * CLHEP::um),
+	first_plane_sigma_(CIR_SIGMA_XY1 * CLHEP::um),
+	second_plane_sigma_(CIR_SIGMA_XY2 * CLHEP::um),
+	third_plane_sigma_(CIR_SIGMA_XY3 * CLHEP::um)
+{
+	for ( G4int i = 0; i < CIR_NUMBER_OF_SILICON_DETECTORS; ++i)
+		planes_.push_back(StripGeometry::default_geometry(i));
+	update_planes();
+}
+
+GeometryConfig&
+GeometryConfig::instance()
+{
+	static GeometryConfig config;
+	return config;
+}
+
+G4int
+GeometryConfig::calorimeter_slices() const
+{
+	return G4int(calorimeter_thickness_ / calorimeter_slice_thickness_);
+}
+
+const StripGeometry&
+GeometryConfig::plane(StripGeometryType type) const
+{
+	return planes_[StripGeometry::index(type)];
+}
+
+void
+GeometryConfig::update_planes()
+{
+	for ( size_t i = 0; i < planes_.size(); ++i) {
+		StripGeometry& geom = planes_[i];
+		geom.t = silicon_thickness_ / CLHEP::um;
+		geom.x = silicon_size_ / 2.0 / CLHEP::um;
+		geom.strips = silicon_strips_;
+		geom.pitch = strip_pitch() / CLHEP::um;
+	}
+}
+
+G4bool
+GeometryConfig::set( const G4String& key, const G4String& value)
+{
+	std::istringstream fields(value);
+	G4bool res = false;
+
+	if (key == "energy_per_nucleon")
+		res = read_value( fields, CLHEP::MeV, energy_per_nucleon_);
+	else if (key == "beam_distance")
+		res = read_value( fields, CLHEP::mm, beam_distance_);
+	else if (key == "world_size")
+		res = read_value( fields, CLHEP::mm, world_size_);
+	else if (key == "silicon_size")
+		res = read_value( fields, CLHEP::mm, silicon_size_);
+	else if (key == "silicon_thickness")
+		res = read_value( fields, CLHEP::um, silicon_thickness_);
+	else if (key == "silicon_strips") {
+		G4int strips = 0;
+		res = (fields >> strips) && strips > 0;
+		if (res)
+			silicon_strips_ = strips;
+	}
+	else if (key == "calorimeter_size")
+		res = read_value( fields, CLHEP::mm, calorimeter_size_);
+	else if (key == "calorimeter_thickness")
+		res = read_value( fields, CLHEP::mm, calorimeter_thickness_);
+	else if (key == "calorimeter_slice_thickness")
+		res = read_value( fields, CLHEP::um, calorimeter_slice_thickness_);
+	else if (key == "first_plane_sigma")
+		res = read_value( fields, CLHEP::um, first_plane_sigma_);
+	else if (key == "second_plane_sigma")
+		res = read_value( fields, CLHEP::um, second_plane_sigma_);
+	else if (key == "third_plane_sigma")
+		res = read_value( fields, CLHEP::um, third_plane_sigma_);
+	else if (key == "plane") {
+		std::string name;
+		G4double z = 0.0, angle = 0.0;
+		res = static_cast<G4bool>(fields >> name >> z >> angle);
+		G4int pos = plane_index(name);
+		if (res && pos >= 0) {
+			planes_[pos].z = z;
+			planes_[pos].angle = angle;
+		}
+		else
+			res = false;
+	}
+
+	if (!res) {
+		G4cerr << "Wrong geometry parameter: " << key << " " << value << G4endl;
+		return false;
+	}
+
+	if (calorimeter_slices() < 1) {
+		G4cerr << "Calorimeter slice is thicker than the calorimeter" << G4endl;
+		calorimeter_slice_thickness_ = calorimeter_thickness_;
+	}
+	update_planes();
+	return true;
+}
+
+G4bool
+GeometryConfig::load(const G4String& filename)
+{
+	std::ifstream file(filename.c_str());
+	if (!file) {
+		G4cerr << "Can't open geometry file " << filename << G4endl;
+		return false;
+	}
+
+	std::string line;
+	while (std::getline( file, line)) {
+		std::istringstream fields(line);
+		std::string key, value;
+		if (!(fields >> key) || key[0] == '#')
+			continue;
+
+		std::getline( fields >> std::ws, value);
+		if (!set( key, value))
+			return false;
+	}
+	return true;
+}
+
+void
+GeometryConfig::print() const
+{
+	G4cout << "Energy per nucleon: " << energy_per_nucleon_ / CLHEP::MeV
+		<< " MeV" << G4endl;
+	G4cout << "Beam distance: " << beam_distance_ / CLHEP::mm << " mm" << G4endl;
+	G4cout << "World size: " << world_size_ / CLHEP::mm << " mm" << G4endl;
+	G4cout << "Silicon: " << silicon_size_ / CLHEP::mm << " mm, "
+		<< silicon_thickness_ / CLHEP::um << " um thick, "
+		<< silicon_strips_ << " strips" << G4endl;
+	G4cout << "Calorimeter: " << calorimeter_size_ / CLHEP::mm << " mm, "
+		<< calorimeter_thickness_ / CLHEP::mm << " mm thick, "
+		<< calorimeter_slices() << " slices of "
+		<< calorimeter_slice_thickness_ / CLHEP::um << " um" << G4endl;
+	G4cout << "Plane sigmas: " << first_plane_sigma_ / CLHEP::um << ", "
+		<< second_plane_sigma_ / CLHEP::um << ", "
+		<< third_plane_sigma_ / CLHEP::um << " um" << G4endl;
+	for ( size_t i = 0; i < planes_.size(); ++i) {
+		G4cout << "Plane " << plane_names[i] << ": z " << planes_[i].z
+			<< " um, angle " << planes_[i].angle << " deg" << G4endl;
+	}
+}
+
+} // namespace CarbonIonRadiography
@@ -26,6 +26,8 @@
 #include <gsl/gsl_fit.h>
 #include <trec_ccmath.h>
 //#include "CIR_ccmath.h"
+#include "CIR_GeometryConfig.hh"
+#include "CIR_TrackFitter.hh"
 #include "CIR_HitCoordinates.hh"
 
 #define SIZE 2
@@ -35,15 +37,18 @@ namespace {
 const G4bool border_down[SIZE] = { true, false };
 const G4bool border_up[SIZE] = { false, true };
 
-const G4double threshold_si = 4.0 * CLHEP::MeV;
-const G4double threshold_calo = 150.0 * CLHEP::MeV;
-
 const std::pair< G4bool, G4bool> pair_ok( true, true);
 
-// sigma^2 = pitch^2 / 12
-const G4double sigma_xy1 = CIR_SIZE_SILICON_STRIP / sqrt(12.0); // sigma on 1 module (Y1-X1 planes) in (um) 
-const G4double sigma_xy2 = 94.0; // sigma on 2 module (Y2-X2 planes) in (um) 
-const G4double sigma_xy3 = 1000.0; // sigma on 3 module (Y3-X3 planes) in (um) 
+// plane geometry of the run
+inline
+const CarbonIonRadiography::StripGeometry*
+plane_geometry(TREC::StripGeometryType type)
+{
+	G4int pos = TREC::StripGeometry::index(type);
+	if (pos < 0)
+		return 0;
+	return &CarbonIonRadiography::GeometryConfig::instance().plane(pos);
+}
 
 void
 fit_track( double* mean_z, double* x, double* y, double* w, int n,
@@ -99,8 +104,11 @@ output_test(G4double v)
 
 namespace CarbonIonRadiography {
 
-FinalHitCoordinates::FinalHitCoordinates(RawHitCoordinates& raw_hits)
+FinalHitCoordinates::FinalHitCoordinates( RawHitCoordinates& raw_hits,
+	G4double threshold_strips, G4double threshold_slice)
 	:
+	threshold_si(threshold_strips),
+	threshold_calo(threshold_slice),
 	xy1(std::make_pair( 0.0, 0.0)),
 	xy1_ok(std::make_pair( false, false)),
 	xy2(std::make_pair( 0.0, 0.0)),
@@ -175,7 +183,7 @@ FinalHitCoordinates::checkCalorimeterData() const
 G4int
 FinalHitCoordinates::findCoordinate( TREC::StripGeometryType type, G4DataVector& ene)
 {
-	const TREC::StripGeometry* geom = TREC::StripGeometry::get(type);
+	const StripGeometry* geom = plane_geometry(type);
 	G4double v = 0;
 	G4int res = 0;
 
@@ -359,18 +367,18 @@ FinalHitCoordinates::calculateMainTrack(G4bool type)
 
 	G4double f[2] = {}; // x coord for "true", y for "false"
 	G4double z[2] = {};
-	const TREC::StripGeometry* f1 = 0;
-	const TREC::StripGeometry* f2 = 0;
+	const StripGeometry* f1 = 0;
+	const StripGeometry* f2 = 0;
 
 	if (type) { // x coordinate (um)
-		f1 = TREC::StripGeometry::get(TREC::MSD_X1);
-		f2 = TREC::StripGeometry::get(TREC::MSD_X2);
+		f1 = plane_geometry(TREC::MSD_X1);
+		f2 = plane_geometry(TREC::MSD_X2);
 		f[0] = xy1.first / CLHEP::um;
 		f[1] = xy2.first / CLHEP::um;
 	}
 	else { // y coordinate (um)
-		f1 = TREC::StripGeometry::get(TREC::MSD_Y1);
-		f2 = TREC::StripGeometry::get(TREC::MSD_Y2);
+		f1 = plane_geometry(TREC::MSD_Y1);
+		f2 = plane_geometry(TREC::MSD_Y2);
 		f[0] = xy1.second / CLHEP::um;
 		f[1] = xy2.second / CLHEP::um;
 	}
@@ -397,23 +405,22 @@ FinalHitCoordinates::calculateFullTrack(G4bool type)
 
 	G4double f[3] = {}; // x coord for "true", y for "false"
 	G4double z[3] = {}; // z coord
-	G4double w[3] = { 58., 94., 1000. }; // sigma
-	const TREC::StripGeometry* f1 = 0;
-	const TREC::StripGeometry* f2 = 0;
-	const TREC::StripGeometry* f3 = 0;
+	const StripGeometry* f1 = 0;
+	const StripGeometry* f2 = 0;
+	const StripGeometry* f3 = 0;
 
 	if (type) { // x coordinate (um)
-		f1 = TREC::StripGeometry::get(TREC::MSD_X1);
-		f2 = TREC::StripGeometry::get(TREC::MSD_X2);
-		f3 = TREC::StripGeometry::get(TREC::MSD_X3);
+		f1 = plane_geometry(TREC::MSD_X1);
+		f2 = plane_geometry(TREC::MSD_X2);
+		f3 = plane_geometry(TREC::MSD_X3);
 		f[0] = xy1.first / CLHEP::um;
 		f[1] = xy2.first / CLHEP::um;
 		f[2] = xy3.first / CLHEP::um;
 	}
 	else { // y coordinate (um)
-		f1 = TREC::StripGeometry::get(TREC::MSD_Y1);
-		f2 = TREC::StripGeometry::get(TREC::MSD_Y2);
-		f3 = TREC::StripGeometry::get(TREC::MSD_Y3);
+		f1 = plane_geometry(TREC::MSD_Y1);
+		f2 = plane_geometry(TREC::MSD_Y2);
+		f3 = plane_geometry(TREC::MSD_Y3);
 		f[0] = xy1.second / CLHEP::um;
 		f[1] = xy2.second / CLHEP::um;
 		f[2] = xy3.second / CLHEP::um;
@@ -448,14 +455,15 @@ FinalHitCoordinates::calculateFullTrack(G4bool type)
 		gsl_fit_wlinear( z, 1, w, 1, f, 1, 3, 
 			&c0, &c1, &cov00, &cov01, &cov11, &chisq);
 */
+		// Closed form of the GSL weighted fit with precalculated geometry
 		if (type) // x coordinate
 //			full_x.a = c1;
 //			full_x.b = c0;
-			full_x = Track::create( z, f, w, 3);
+			full_x = full_track_fitter(type).fit(f);
 		else // y coordinate
 //			full_y.a = c1;
 //			full_y.b = c0;
-			full_y = Track::create( z, f, w, 3);
+			full_y = full_track_fitter(type).fit(f);
 
 		// CCMATH Compute least squares coefficients via QR reduction
 /*
@@ -493,8 +501,8 @@ FinalHitCoordinates::calculateFullTrack(G4bool type)
 G4bool
 FinalHitCoordinates::checkTracksWithinTrajectory()
 {
-	const TREC::StripGeometry* x3 = TREC::StripGeometry::get(TREC::MSD_X3);
-	const TREC::StripGeometry* y3 = TREC::StripGeometry::get(TREC::MSD_Y3);
+	const StripGeometry* x3 = plane_geometry(TREC::MSD_X3);
+	const StripGeometry* y3 = plane_geometry(TREC::MSD_Y3);
 
 	Track& main_x = main_track.first;
 	Track& main_y = main_track.second;
@@ -516,6 +524,8 @@ FinalHitCoordinates::checkTracksWithinTrajectory()
 	G4double dist_x3 = sqrt( (mx3 - main_x3) * (mx3 - main_x3) +
 		(my3 - main_y3) * (my3 - main_y3));
 
+	const G4double sigma_xy3 =
+		GeometryConfig::instance().third_plane_sigma() / CLHEP::um;
 	return (dist_x3 <= 2 * sigma_xy3);
 }
 
@@ -0,0 +1,222 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4SystemOfUnits.hh>
+#include <G4PhysicalConstants.hh>
+#include <G4ios.hh>
+
+#include <cmath>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_StripGeometry.hh"
+#include "CIR_TrackFitter.hh"
+#include "CIR_TrackCoordinates.hh"
+#include "CIR_MostLikelyPath.hh"
+
+namespace {
+
+// integration bins of the scattering power per step, even, so the step
+// center is a bin border
+const G4int bins_per_step = 16;
+
+// Highland formula
+const G4double highland_energy = 13.6 * CLHEP::MeV;
+const G4double water_radiation_length = 36.08 * CLHEP::cm;
+
+// Bragg-Kleeman rule of the proton range in water, R = alpha * T^p,
+// T -- kinetic energy (MeV), ions of the same energy per nucleon
+// have the range A / Z^2 of the proton one
+const G4double bragg_kleeman_alpha = 0.0022 * CLHEP::cm;
+const G4double bragg_kleeman_exponent = 1.77;
+const G4double min_energy_per_nucleon = 1.0 * CLHEP::MeV;
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+MostLikelyPath::MostLikelyPath( G4double z_in, G4double z_out, G4int steps,
+	G4int charge, G4int nucleons)
+	:
+	z_in_(z_in),
+	z_out_(z_out),
+	steps_(steps)
+{
+	if (steps_ < 1)
+		steps_ = 1;
+	if (!(z_out_ > z_in_)) {
+		G4cerr << "MostLikelyPath: empty object slab " << z_in_ << " "
+			<< z_out_ << " um" << G4endl;
+		z_out_ = z_in_ + 1.0;
+	}
+
+	precompute( charge, nucleons);
+}
+
+void
+MostLikelyPath::precompute( G4int charge, G4int nucleons)
+{
+	const GeometryConfig& config = GeometryConfig::instance();
+	const G4double length = z_out_ - z_in_;
+
+	// scattering power along the slab of water, 1 / (p beta)^2 with the
+	// energy of the residual range
+	const G4int bins = steps_ * bins_per_step;
+	const G4double bin = length / bins;
+	const G4double alpha = bragg_kleeman_alpha * nucleons / (charge * charge);
+	const G4double energy = config.energy_per_nucleon() / CLHEP::MeV;
+	const G4double range = alpha * std::pow( energy, bragg_kleeman_exponent);
+	const G4double min_range = alpha * std::pow(
+		min_energy_per_nucleon / CLHEP::MeV, bragg_kleeman_exponent);
+	const G4double amu = CLHEP::amu_c2 / CLHEP::MeV;
+	const G4double x0 = water_radiation_length / CLHEP::um;
+	const G4double log_term = 1.0 + 0.038 * std::log(length / x0);
+	const G4double es = highland_energy / CLHEP::MeV;
+
+	G4double total = 0.0;
+	power_.resize(bins);
+	for ( G4int j = 0; j < bins; ++j) {
+		G4double residual = range - (j + 0.5) * bin * CLHEP::um;
+		if (residual < min_range)
+			residual = min_range;
+		G4double t = std::pow( residual / alpha, 1.0 / bragg_kleeman_exponent);
+		G4double pv = nucleons * t * (t + 2.0 * amu) / (t + amu);
+		G4double theta = es * charge / pv;
+		power_[j] = theta * theta / x0 * log_term * log_term;
+		total += power_[j] * bin;
+	}
+
+	const StripGeometryType planes[2][3] = {
+		{ MSD_X1, MSD_X2, MSD_X3 },
+		{ MSD_Y1, MSD_Y2, MSD_Y3 }
+	};
+	for ( G4int i = 0; i < 2; ++i) {
+		z1_[i] = config.plane(planes[i][0]).z;
+		z2_[i] = config.plane(planes[i][1]).z;
+		z3_[i] = config.plane(planes[i][2]).z;
+	}
+
+	// tracker covariances, strips resolution pitch / sqrt(12); X and Y
+	// planes have the same strips, so the X covariances serve both
+	const G4double p1 = config.plane(MSD_X1).pitch;
+	const G4double p2 = config.plane(MSD_X2).pitch;
+	const G4double p3 = config.plane(MSD_X3).pitch;
+	const G4double v1 = p1 * p1 / 12.0;
+	const G4double v2 = p2 * p2 / 12.0;
+	const G4double v3 = p3 * p3 / 12.0;
+
+	// x0 = x2 * (1 + s) - x1 * s, t0 = (x2 - x1) / d
+	G4double d = z2_[0] - z1_[0];
+	G4double s = (z_in_ - z2_[0]) / d;
+	const Covariance in( v2 * (1.0 + s) * (1.0 + s) + v1 * s * s,
+		(v2 * (1.0 + s) + v1 * s) / d, (v1 + v2) / (d * d));
+
+	// x1 = x3 * (1 - r) + x2 * r, t1 = (x3 - x2) / d, the chord
+	// differs from the exit direction by the scattering in the slab
+	d = z3_[0] - z2_[0];
+	G4double r = (z3_[0] - z_out_) / d;
+	const Covariance out( v3 * (1.0 - r) * (1.0 - r) + v2 * r * r,
+		(v3 * (1.0 - r) - v2 * r) / d, (v2 + v3) / (d * d) + total);
+
+	// Krah et al.: y(u) = C2 (C1 + C2)^-1 R0 y0 + C1 (C1 + C2)^-1 R1^-1 y1,
+	// C1 = R0 Sin R0^T + S1(u), C2 = R1^-1 (Sout + S2(u)) R1^-T
+	in_x_.resize(steps_);
+	in_t_.resize(steps_);
+	out_x_.resize(steps_);
+	out_t_.resize(steps_);
+	for ( G4int k = 0; k < steps_; ++k) {
+		G4double u = (k + 0.5) * step_length(); // from z_in
+		G4double v = length - u; // to z_out
+
+		Covariance s1, s2;
+		scattering( k, s1, s2);
+
+		Covariance c1( in.xx + 2.0 * u * in.xt + u * u * in.tt + s1.xx,
+			in.xt + u * in.tt + s1.xt, in.tt + s1.tt);
+		Covariance c2( out.xx + s2.xx - 2.0 * v * (out.xt + s2.xt)
+			+ v * v * (out.tt + s2.tt),
+			out.xt + s2.xt - v * (out.tt + s2.tt), out.tt + s2.tt);
+
+		// (C1 + C2)^-1
+		G4double sxx = c1.xx + c2.xx;
+		G4double sxt = c1.xt + c2.xt;
+		G4double stt = c1.tt + c2.tt;
+		G4double det = sxx * stt - sxt * sxt;
+
+		// first rows of C2 (C1 + C2)^-1 and C1 (C1 + C2)^-1
+		G4double a0 = (c2.xx * stt - c2.xt * sxt) / det;
+		G4double a1 = (c2.xt * sxx - c2.xx * sxt) / det;
+		G4double b0 = (c1.xx * stt - c1.xt * sxt) / det;
+		G4double b1 = (c1.xt * sxx - c1.xx * sxt) / det;
+
+		// R0 = [[1, u], [0, 1]], R1^-1 = [[1, -v], [0, 1]]
+		in_x_[k] = a0;
+		in_t_[k] = a0 * u + a1;
+		out_x_[k] = b0;
+		out_t_[k] = b1 - b0 * v;
+	}
+}
+
+void
+MostLikelyPath::scattering( G4int step, Covariance& in, Covariance& out) const
+{
+	const G4int bins = G4int(power_.size());
+	const G4double bin = (z_out_ - z_in_) / bins;
+	const G4double length = z_out_ - z_in_;
+	const G4int center = step * bins_per_step + bins_per_step / 2;
+	const G4double u = center * bin;
+
+	in = Covariance();
+	out = Covariance();
+	for ( G4int j = 0; j < bins; ++j) {
+		G4double t = (j + 0.5) * bin;
+		G4double w = power_[j] * bin;
+		if (j < center) {
+			in.xx += (u - t) * (u - t) * w;
+			in.xt += (u - t) * w;
+			in.tt += w;
+		}
+		else {
+			out.xx += (length - t) * (length - t) * w;
+			out.xt += (length - t) * w;
+			out.tt += w;
+		}
+	}
+}
+
+void
+MostLikelyPath::states( G4bool type, const Track& main, const Track& full,
+	G4double& x0, G4double& t0, G4double& x1, G4double& t1) const
+{
+	const G4int i = type ? 0 : 1;
+
+	// main track passes through the xy1 and xy2 hits,
+	// the xy3 hit is recovered from the full track
+	G4double f[2] = {
+		main.a() * z1_[i] + main.b(),
+		main.a() * z2_[i] + main.b()
+	};
+	G4double x3 = full_track_fitter(type).coordinate( full, f);
+
+	t0 = main.a();
+	x0 = main.a() * z_in_ + main.b();
+	t1 = (x3 - f[1]) / (z3_[i] - z2_[i]);
+	x1 = x3 - t1 * (z3_[i] - z_out_);
+}
+
+} // namespace CarbonIonRadiography
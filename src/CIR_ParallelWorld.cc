@@ -32,45 +32,28 @@
 #include <G4VisAttributes.hh>
 
 #include "CIR_GlobalStrings.hh"
-#include "CIR_Defines.hh"
+#include "CIR_GeometryConfig.hh"
 //#include "CIR_StripGeometry.hh"
 
 #include "CIR_ParallelWorld.hh"
 
-namespace {
-
-G4int strips = CIR_NUMBER_OF_STRIPS_PER_SILICON;
-G4double si_x = CIR_SIZE_SILICON * CLHEP::mm / 2.0; // half size
-G4double si_y = si_x;  // half size
-G4double pitch_x = si_x / strips;  // half size
-G4double pitch_y = pitch_x;  // half size
-G4double si_z = CIR_SIZE_SILICON_THICKNESS * CLHEP::um / 2.0;  // half size
-
-G4double calo_x = CIR_SIZE_CALORIMETER * CLHEP::mm / 2.0;  // half size
-G4double calo_y = calo_x;  // half size
-G4double calo_z = CIR_SIZE_CALORIMETER_THICKNESS * CLHEP::mm / 2.0; // half size
-G4double calo_slice_z = CIR_SIZE_CALORIMETER_SLICE_THICKNESS * CLHEP::um / 2.0; // half size
-G4int calo_slices = calo_z / calo_slice_z;
-
-} // namespace
-
 namespace CarbonIonRadiography {
 
 ParallelWorld::ParallelWorld(const G4String& worldName)
 	:
 	G4VUserParallelWorld(worldName),
-	siliconYPitchSizeX(si_x), // half size
-	siliconYPitchSizeY(pitch_y), // half size
-	siliconYPitchSizeZ(si_z), // half size
-	numberOfSiliconStripsAlongX(strips),
-	numberOfSiliconStripsAlongY(strips),
-	calorimeterSizeX(calo_x), // half size
-	calorimeterSizeY(calo_y), // half size
-	calorimeterSizeZ(calo_z), // half size
-	sizeOfCalorimeterVoxelAlongX(calo_x), // half size
-	sizeOfCalorimeterVoxelAlongY(calo_y), // half size
-	sizeOfCalorimeterVoxelAlongZ(calo_slice_z), // half size
-	numberOfCalorimeterVoxelsAlongZ(calo_slices),
+	siliconYPitchSizeX(0.0), // half size
+	siliconYPitchSizeY(0.0), // half size
+	siliconYPitchSizeZ(0.0), // half size
+	numberOfSiliconStripsAlongX(0),
+	numberOfSiliconStripsAlongY(0),
+	calorimeterSizeX(0.0), // half size
+	calorimeterSizeY(0.0), // half size
+	calorimeterSizeZ(0.0), // half size
+	sizeOfCalorimeterVoxelAlongX(0.0), // half size
+	sizeOfCalorimeterVoxelAlongY(0.0), // half size
+	sizeOfCalorimeterVoxelAlongZ(0.0), // half size
+	numberOfCalorimeterVoxelsAlongZ(0),
 	ghostWorld(0)
 {
 }
@@ -79,11 +62,33 @@ ParallelWorld::~ParallelWorld()
 {
 }
 
+void
+ParallelWorld::ReadGeometryConfig()
+{
+	const GeometryConfig& config = GeometryConfig::instance();
+
+	G4int strips = config.silicon_strips();
+	siliconYPitchSizeX = config.silicon_size() / 2.0;
+	siliconYPitchSizeY = config.strip_pitch() / 2.0;
+	siliconYPitchSizeZ = config.silicon_thickness() / 2.0;
+	numberOfSiliconStripsAlongX = strips;
+	numberOfSiliconStripsAlongY = strips;
+
+	calorimeterSizeX = config.calorimeter_size() / 2.0;
+	calorimeterSizeY = config.calorimeter_size() / 2.0;
+	calorimeterSizeZ = config.calorimeter_thickness() / 2.0;
+	sizeOfCalorimeterVoxelAlongX = calorimeterSizeX;
+	sizeOfCalorimeterVoxelAlongY = calorimeterSizeY;
+	sizeOfCalorimeterVoxelAlongZ = config.calorimeter_slice_thickness() / 2.0;
+	numberOfCalorimeterVoxelsAlongZ = config.calorimeter_slices();
+}
+
 void
 ParallelWorld::Construct()
 {
 	// World
 	ghostWorld = GetWorld();
+	ReadGeometryConfig();
 	TREC::StripGeometryMap map = TREC::StripGeometry::create();
 
 	for ( TREC::StripGeometryMap::iterator it = map.begin();
@@ -95,23 +100,23 @@ ParallelWorld::Construct()
 		ConstructSiliconPlane( pos, pair);
 	}
 
-	const TREC::StripGeometry* V = TREC::StripGeometry::get(TREC::MSD__V);
+	const StripGeometry& V = GeometryConfig::instance().plane(MSD__V);
 
-	ConstructCalorimeter(V->z + calo_z + 10 * CLHEP::mm);
+	ConstructCalorimeter(V.z + calorimeterSizeZ + 10 * CLHEP::mm);
 }
 
 void
-ParallelWorld::ConstructSiliconPlane( G4int, const TREC::StripGeometryPair& pair)
+ParallelWorld::ConstructSiliconPlane( G4int pos, const TREC::StripGeometryPair& pair)
 {
-	const TREC::StripGeometry& geom = pair.first;
+	const StripGeometry& geom = GeometryConfig::instance().plane(pos);
 	const TREC::StripGeometryNames& names = pair.second;
 
 	// Phantom Geometry 
 	G4Box* siliconParallel = new G4Box(
 		names.parallel_body_name,
-		si_x, 
-		si_y,
-		si_z);
+		siliconYPitchSizeX,
+		siliconYPitchSizeX,
+		siliconYPitchSizeZ);
 
 	G4LogicalVolume* siliconLogParallel = new G4LogicalVolume(
 		siliconParallel,
@@ -147,7 +152,7 @@ ParallelWorld::ConstructSiliconPlane( G4int, const TREC::StripGeometryPair& pair
 		siliconPhysParallel,
 		kYAxis,
 		numberOfSiliconStripsAlongY,
-		pitch_y * 2); // pitch size
+		siliconYPitchSizeY * 2); // pitch size
 }
 
 void
@@ -156,9 +161,9 @@ ParallelWorld::ConstructCalorimeter(G4double offset_z)
 	// Phantom Geometry 
 	G4Box* CalorimeterBoxParallel = new G4Box(
 		CalorimeterParallelStr, 
-		calo_x, // half size 
-		calo_y, // half size 
-		calo_z); // half size
+		calorimeterSizeX, // half size
+		calorimeterSizeY, // half size
+		calorimeterSizeZ); // half size
 
 	G4LogicalVolume* CalorimeterLogParallel = new G4LogicalVolume(
 		CalorimeterBoxParallel,
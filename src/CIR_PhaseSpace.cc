@@ -0,0 +1,131 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4ios.hh>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "CIR_PhaseSpace.hh"
+
+namespace {
+
+const char magic[8] = { 'C', 'I', 'R', 'P', 'H', 'S', 'P', '1' };
+const size_t header_size = sizeof(magic) + sizeof(unsigned long long);
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+PhaseSpace* PhaseSpace::instance = 0;
+unsigned long PhaseSpace::generations = 0;
+
+PhaseSpace::PhaseSpace()
+	:
+	generation(0),
+	mapping(0),
+	mappingSize(0),
+	records(0),
+	size(0),
+	cursor(0)
+{
+}
+
+PhaseSpace::~PhaseSpace()
+{
+	if (mapping)
+		munmap( mapping, mappingSize);
+}
+
+G4bool
+PhaseSpace::Open(const G4String& filename)
+{
+	// the command isn't broadcast, the workers don't run events now
+	if (instance && instance->fileName == filename)
+		return true;
+
+	delete instance;
+	instance = 0;
+
+	if (filename.empty())
+		return true;
+
+	int fd = open( filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		G4cerr << "Can't open phase space file " << filename << G4endl;
+		return false;
+	}
+
+	struct stat st;
+	if (fstat( fd, &st) || size_t(st.st_size) < header_size) {
+		G4cerr << "Wrong phase space file " << filename << G4endl;
+		close(fd);
+		return false;
+	}
+
+	size_t length = st.st_size;
+	void* mapping = mmap( 0, length, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		G4cerr << "Can't map phase space file " << filename << G4endl;
+		return false;
+	}
+
+	const char* data = static_cast<const char*>(mapping);
+	unsigned long long size = 0;
+	std::memcpy( &size, data + sizeof(magic), sizeof(size));
+
+	if (std::memcmp( data, magic, sizeof(magic)) || size == 0 ||
+		size > (length - header_size) / sizeof(PhaseSpaceRecord)) {
+		G4cerr << "Wrong phase space file " << filename << G4endl;
+		munmap( mapping, length);
+		return false;
+	}
+
+	// records are read once, in chunks
+	madvise( mapping, length, MADV_SEQUENTIAL);
+
+	PhaseSpace* phase_space = new PhaseSpace;
+	phase_space->fileName = filename;
+	phase_space->generation = ++generations;
+	phase_space->mapping = mapping;
+	phase_space->mappingSize = length;
+	phase_space->records =
+		reinterpret_cast<const PhaseSpaceRecord*>(data + header_size);
+	phase_space->size = size;
+	instance = phase_space;
+
+	G4cout << "Phase space " << filename << " with " << size << " records"
+		<< G4endl;
+	return true;
+}
+
+void
+PhaseSpace::Claim( unsigned long long chunk, unsigned long long& begin,
+	unsigned long long& end)
+{
+	begin = cursor.fetch_add(chunk, std::memory_order_relaxed);
+	end = begin + chunk;
+}
+
+} // namespace CarbonIonRadiography
@@ -49,20 +49,80 @@
 #include <G4IonParametrisedLossModel.hh>
 #include <G4EmProcessOptions.hh>
 #include <G4ParallelWorldScoringProcess.hh>
+#include <G4FastSimulationManagerProcess.hh>
 
 #include <G4IonConstructor.hh>
+#include <G4IonTable.hh>
+#include <G4EmCalculator.hh>
+#include <G4NistManager.hh>
+#include <G4Material.hh>
+#include <G4Version.hh>
+#include <G4Timer.hh>
+
+#include <sys/stat.h>
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
 
 #include "CIR_GlobalStrings.hh"
+#include "CIR_GeometryConfig.hh"
+#include "CIR_WeplCalibration.hh"
 #include "CIR_PhysicsList.hh"
+#include "CIR_PhysicsListMessenger.hh"
+
+namespace {
+
+const char* cache_info_name = "cache.info";
+
+// energy grid of the WEPL table per nucleon
+const G4double wepl_min_energy_per_nucleon = 0.1 * MeV;
+const G4int wepl_table_bins = 512;
+
+// FNV-1a hash of the description, name of the cache subdirectory
+G4String
+description_key(const G4String& description)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	for ( size_t i = 0; i < description.size(); ++i) {
+		hash ^= static_cast<unsigned char>(description[i]);
+		hash *= 1099511628211ULL;
+	}
+
+	std::ostringstream key;
+	key << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return key.str();
+}
+
+// build time and description of the cached tables
+G4bool
+read_cache_info( const G4String& filename, G4double& build_time,
+	G4String& description)
+{
+	std::ifstream file(filename.c_str());
+	std::string tag;
+	if (!(file >> tag >> build_time) || tag != "build_time")
+		return false;
+
+	std::ostringstream text;
+	text << (file >> std::ws).rdbuf();
+	description = text.str();
+	return true;
+}
+
+} // namespace
 
 namespace CarbonIonRadiography {
 
 /////////////////////////////////////////////////////////////////////////////
 PhysicsList::PhysicsList()
 	:
-	G4VModularPhysicsList()
+	G4VModularPhysicsList(),
+	messenger(0)
 {
 	G4LossTableManager::Instance();
+	messenger = new PhysicsListMessenger(this);
 
 	SetVerboseLevel(1);
 
@@ -80,6 +140,7 @@ PhysicsList::PhysicsList()
 /////////////////////////////////////////////////////////////////////////////
 PhysicsList::~PhysicsList()
 {
+	delete messenger;
 	delete emPhysicsList;
 	delete decPhysicsList;
 	delete raddecayList;
@@ -126,6 +187,10 @@ PhysicsList::ConstructProcess()
 
 	theParallelWorldScoringProcess->SetParallelWorld(ParallelWorldStr);
 
+	// Add fast simulation process of the mass geometry (detector regions)
+	G4FastSimulationManagerProcess* theFastSimulationProcess =
+		new G4FastSimulationManagerProcess(FastSimulationProcessStr);
+
 //	theParticleIterator->reset();
 	G4ParticleTable::G4PTblDicIterator* theParticleIterator = GetParticleIterator();
 
@@ -148,6 +213,8 @@ PhysicsList::ConstructProcess()
 			pmanager->SetProcessOrderingToLast( theParallelWorldScoringProcess, idxPostStep);
 		}
 
+		pmanager->AddDiscreteProcess(theFastSimulationProcess);
+
 	}
 }
 
@@ -237,4 +304,163 @@ PhysicsList::SetCuts()
 	SetCutsWithDefault();
 }
 
+/////////////////////////////////////////////////////////////////////////////
+G4String
+PhysicsList::TableDescription() const
+{
+	std::ostringstream desc;
+	desc << "geant4 " << G4Version << "\n";
+	desc << "em " << emName << "\n";
+	for ( size_t i = 0; i < hadronPhys.size(); i++) {
+		desc << "hadron " << hadronPhys[i]->GetPhysicsName() << "\n";
+	}
+	for ( G4int i = 0; GetPhysics(i); i++) {
+		desc << "physics " << GetPhysics(i)->GetPhysicsName() << "\n";
+	}
+	desc << "cut " << GetDefaultCutValue() / mm << "\n";
+
+	const G4MaterialTable* materials = G4Material::GetMaterialTable();
+	for ( size_t i = 0; i < materials->size(); i++) {
+		const G4Material* material = (*materials)[i];
+		desc << "material " << material->GetName()
+			<< " " << material->GetDensity() / (g / cm3)
+			<< " " << material->GetIonisation()->GetMeanExcitationEnergy() / eV;
+
+		const G4double* fractions = material->GetFractionVector();
+		for ( size_t j = 0; j < material->GetNumberOfElements(); j++) {
+			desc << " " << material->GetElement(j)->GetName()
+				<< " " << fractions[j];
+		}
+		desc << "\n";
+	}
+	return desc.str();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+PhysicsList::BuildTables()
+{
+	if (tableCache.empty()) return;
+
+	// the materials are known after the geometry initialization
+	G4String description = TableDescription();
+	G4String dir = tableCache + "/" + description_key(description);
+	G4String infoName = dir + "/" + cache_info_name;
+
+	G4double buildTime = 0.;
+	G4String cachedDescription;
+	G4bool cached = read_cache_info( infoName, buildTime, cachedDescription)
+		&& cachedDescription == description;
+
+	if (cached) {
+		SetPhysicsTableRetrieved(dir);
+	}
+
+	// a run without events builds the tables, G4 falls back to building
+	// the tables which can't be retrieved
+	G4Timer timer;
+	timer.Start();
+	G4RunManager::GetRunManager()->BeamOn(0);
+	timer.Stop();
+
+	G4bool retrieved = cached && IsPhysicsTableRetrieved();
+	// tables of the later runs (new materials) are built
+	ResetPhysicsTableRetrieved();
+
+	if (retrieved) {
+		G4cout << "Physics tables retrieved from " << dir << " in "
+			<< timer.GetRealElapsed() << " s, built in " << buildTime
+			<< " s, initialization time saved: "
+			<< buildTime - timer.GetRealElapsed() << " s" << G4endl;
+		return;
+	}
+
+	if (cached) {
+		G4cerr << "Physics table cache " << dir
+			<< " doesn't match, tables are rebuilt" << G4endl;
+	}
+	G4cout << "Physics tables built in " << timer.GetRealElapsed()
+		<< " s" << G4endl;
+
+	mkdir( tableCache.c_str(), 0755);
+	mkdir( dir.c_str(), 0755);
+	if (!StorePhysicsTable(dir)) {
+		G4cerr << "Can't store physics tables to " << dir << G4endl;
+		return;
+	}
+
+	std::ofstream info(infoName.c_str());
+	info << "build_time " << timer.GetRealElapsed() << "\n" << description;
+	G4cout << "Physics tables stored to " << dir << G4endl;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+G4bool
+PhysicsList::WriteWeplTable( const G4String& filename, G4int Z, G4int A)
+{
+	// the models of the stopping powers are initialized with the tables
+	G4RunManager::GetRunManager()->BeamOn(0);
+
+	G4ParticleDefinition* ion = G4IonTable::GetIonTable()->GetIon( Z, A);
+	G4NistManager* man = G4NistManager::Instance();
+	G4Material* water = man->FindOrBuildMaterial("G4_WATER");
+	G4Material* calorimeter = man->FindOrBuildMaterial("G4_POLYSTYRENE");
+	if (!ion || !water || !calorimeter) {
+		G4cerr << "Can't compute WEPL table of the ion " << Z << " " << A
+			<< G4endl;
+		return false;
+	}
+
+	const GeometryConfig& config = GeometryConfig::instance();
+	G4double emax = config.energy_per_nucleon() * A;
+	G4double emin = wepl_min_energy_per_nucleon * A;
+	G4double ratio = std::pow( emax / emin, 1.0 / (wepl_table_bins - 1));
+
+	// CSDA ranges in water and in the calorimeter on the energy grid
+	G4EmCalculator calculator;
+	std::vector<G4double> energy(wepl_table_bins);
+	std::vector<G4double> rangeWater(wepl_table_bins);
+	std::vector<G4double> rangeCalo(wepl_table_bins);
+	for ( G4int i = 0; i < wepl_table_bins; i++) {
+		energy[i] = emin * std::pow( ratio, i);
+		G4double dedxWater = calculator.ComputeTotalDEDX( energy[i], ion, water);
+		G4double dedxCalo = calculator.ComputeTotalDEDX( energy[i], ion,
+			calorimeter);
+		if (!i) {
+			// stopping power proportional to sqrt(E) below the grid
+			rangeWater[i] = 2.0 * energy[i] / dedxWater;
+			rangeCalo[i] = 2.0 * energy[i] / dedxCalo;
+			continue;
+		}
+		G4double dedxWaterPrev = calculator.ComputeTotalDEDX( energy[i - 1], ion,
+			water);
+		G4double dedxCaloPrev = calculator.ComputeTotalDEDX( energy[i - 1], ion,
+			calorimeter);
+		G4double de = energy[i] - energy[i - 1];
+		rangeWater[i] = rangeWater[i - 1]
+			+ 0.5 * de * (1.0 / dedxWater + 1.0 / dedxWaterPrev);
+		rangeCalo[i] = rangeCalo[i - 1]
+			+ 0.5 * de * (1.0 / dedxCalo + 1.0 / dedxCaloPrev);
+	}
+
+	// the ion leaving the object with the energy E stops at the depth
+	// of its range in the calorimeter, the object WEPL is the water range
+	// lost; position of the depth d is d / slice - 0.5 (slice center)
+	G4double slice = config.calorimeter_slice_thickness();
+	G4double rangeMax = rangeWater.back();
+	WeplCalibration table;
+	for ( G4int i = 0; i < wepl_table_bins; i++) {
+		table.add_point( rangeCalo[i] / slice - 0.5,
+			(rangeMax - rangeWater[i]) / mm);
+	}
+
+	if (!table.save(filename)) {
+		G4cerr << "Can't save WEPL table " << filename << G4endl;
+		return false;
+	}
+	G4cout << "WEPL table of " << ion->GetParticleName() << " saved to "
+		<< filename << G4endl;
+	return true;
+}
+
 } // namespace CarbonIonRadiography
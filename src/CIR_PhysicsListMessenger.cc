@@ -0,0 +1,97 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4UIdirectory.hh>
+#include <G4UIcmdWithAString.hh>
+#include <G4UIcommand.hh>
+#include <G4UIparameter.hh>
+
+#include <sstream>
+
+#include "CIR_PhysicsList.hh"
+#include "CIR_PhysicsListMessenger.hh"
+
+namespace CarbonIonRadiography {
+
+PhysicsListMessenger::PhysicsListMessenger(PhysicsList* list)
+	:
+	physics(list),
+	physics_dir(0),
+	cache_cmd(0),
+	wepl_table_cmd(0)
+{
+	// Physics directory
+	physics_dir = new G4UIdirectory("/physics/");
+	physics_dir->SetGuidance("Physics list commands");
+
+	// Physics table cache
+	cache_cmd = new G4UIcmdWithAString(
+		"/physics/cache", this);
+
+	cache_cmd->SetGuidance("Directory of the physics table cache. The tables");
+	cache_cmd->SetGuidance("are stored in a subdirectory per physics");
+	cache_cmd->SetGuidance("configuration and material set and retrieved on");
+	cache_cmd->SetGuidance("the later starts, \"none\" -- no cache.");
+	cache_cmd->SetParameterName( "CacheDirectory", false);
+	cache_cmd->AvailableForStates(G4State_PreInit);
+	cache_cmd->SetToBeBroadcasted(false);
+
+	// WEPL calibration from the stopping powers
+	wepl_table_cmd = new G4UIcommand( "/physics/weplTable", this);
+	wepl_table_cmd->SetGuidance("Write the WEPL calibration of the calorimeter");
+	wepl_table_cmd->SetGuidance("stopping position of the ion Z A computed with");
+	wepl_table_cmd->SetGuidance("the stopping powers (cir-reco -wepl table).");
+
+	G4UIparameter* param = new G4UIparameter( "File", 's', false);
+	wepl_table_cmd->SetParameter(param);
+	param = new G4UIparameter( "Z", 'i', true);
+	param->SetDefaultValue(6);
+	wepl_table_cmd->SetParameter(param);
+	param = new G4UIparameter( "A", 'i', true);
+	param->SetDefaultValue(12);
+	wepl_table_cmd->SetParameter(param);
+	wepl_table_cmd->AvailableForStates(G4State_Idle);
+	wepl_table_cmd->SetToBeBroadcasted(false);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+PhysicsListMessenger::~PhysicsListMessenger()
+{
+	delete cache_cmd;
+	delete wepl_table_cmd;
+	delete physics_dir;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+PhysicsListMessenger::SetNewValue( G4UIcommand* command, G4String newValue)
+{
+	if (command == cache_cmd) {
+		physics->SetTableCache( (newValue == "none") ? G4String() : newValue);
+	}
+	else if (command == wepl_table_cmd) {
+		std::istringstream fields(newValue);
+		G4String file;
+		G4int Z = 6, A = 12;
+		fields >> file >> Z >> A;
+		physics->WriteWeplTable( file, Z, A);
+	}
+}
+
+} // namespace CarbonIonRadiography
@@ -17,14 +17,21 @@
  * 
  */
 
+#include <G4Event.hh>
 #include <G4SystemOfUnits.hh>
 #include <G4ParticleDefinition.hh>
 #include <G4Geantino.hh>
 #include <G4IonTable.hh>
+#include <G4ParticleTable.hh>
+#include <G4PrimaryVertex.hh>
 
 #include <Randomize.hh>
 
-#include "CIR_Defines.hh"
+#include "CIR_GeometryConfig.hh"
+#include "CIR_EventSeeding.hh"
+#include "CIR_PhaseSpace.hh"
+#include "CIR_RasterScan.hh"
+#include "CIR_PrimaryGeneratorMessenger.hh"
 #include "CIR_PrimaryGeneratorAction.hh"
 
 namespace {
@@ -33,7 +40,22 @@ namespace {
 G4int Z = 6, A = 12;
 G4double ionCharge = 6. * CLHEP::eplus;
 G4double ee = 0. * CLHEP::keV; // excit. energy
-G4double energy = CIR_ENERGY_PER_NUCLEON * A * CLHEP::MeV;
+
+// kinetic energy of the default beam
+inline
+G4double
+beam_energy()
+{
+	return CarbonIonRadiography::GeometryConfig::instance().energy_per_nucleon() * A;
+}
+
+// position z of the beam source
+inline
+G4double
+beam_z()
+{
+	return -CarbonIonRadiography::GeometryConfig::instance().beam_distance();
+}
 
 } // namespace
 
@@ -41,16 +63,26 @@ namespace CarbonIonRadiography {
 
 PrimaryGeneratorAction::PrimaryGeneratorAction()
 	:
-	gun(0)
+	gun(0),
+	messenger(0),
+	ionBeam(false),
+	phaseSpaceGeneration(0),
+	phaseSpaceChunk(1024),
+	chunkBegin(0),
+	chunkEnd(0),
+	particlePDG(0),
+	particle(0)
 {
 	// Definition of the General particle Source
 	gun = new G4ParticleGun();
+	messenger = new PrimaryGeneratorMessenger(this);
 
 	SetDefaultPrimaryParticle();
 }
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
+	delete messenger;
 	delete gun;
 }
 
@@ -61,25 +93,136 @@ PrimaryGeneratorAction::SetDefaultPrimaryParticle()
 	gun->SetParticleDefinition(G4Geantino::Geantino());
 }
 
+void
+PrimaryGeneratorAction::SetIonBeam()
+{
+	// ions can't be defined before the run initialization
+	G4ParticleDefinition* ion = G4IonTable::GetIonTable()->GetIon( Z, A, ee);
+
+	gun->SetParticleDefinition(ion);
+	gun->SetParticleCharge(ionCharge);
+	gun->SetParticleMomentumDirection(G4ThreeVector( 0., 0., 1.));
+	gun->SetParticleEnergy(beam_energy());
+	ionBeam = true;
+}
+
+G4ParticleDefinition*
+PrimaryGeneratorAction::FindParticle(G4int pdg)
+{
+	if (pdg == particlePDG && particle)
+		return particle;
+
+	G4ParticleDefinition* definition =
+		G4ParticleTable::GetParticleTable()->FindParticle(pdg);
+	if (!definition && pdg > 1000000000)
+		definition = G4IonTable::GetIonTable()->GetIon(pdg);
+
+	particlePDG = pdg;
+	particle = definition;
+	return definition;
+}
+
+void
+PrimaryGeneratorAction::SetPhaseSpacePrimary( PhaseSpace* source,
+	G4Event* event)
+{
+	unsigned long long index = 0;
+	if (EventSeeding::IsEnabled()) {
+		// the record depends only on the event
+		index = EventSeeding::GlobalEventID(event->GetEventID());
+	}
+	else {
+		if (source->Generation() != phaseSpaceGeneration ||
+			chunkBegin == chunkEnd) {
+			phaseSpaceGeneration = source->Generation();
+			source->Claim( phaseSpaceChunk, chunkBegin, chunkEnd);
+		}
+		index = chunkBegin++;
+	}
+
+	const PhaseSpaceRecord& record = source->Record(index);
+
+	G4ParticleDefinition* definition = FindParticle(record.pdg);
+	if (!definition) {
+		G4cerr << "Unknown phase space particle " << record.pdg << G4endl;
+		return;
+	}
+
+	gun->SetParticleDefinition(definition);
+	gun->SetParticleCharge(definition->GetPDGCharge());
+	gun->SetParticleMomentumDirection(G4ThreeVector( record.dx, record.dy,
+		record.dz));
+	gun->SetParticleEnergy(record.energy * CLHEP::MeV);
+	gun->SetParticlePosition(G4ThreeVector( record.x * CLHEP::mm,
+		record.y * CLHEP::mm, record.z * CLHEP::mm));
+
+	gun->GeneratePrimaryVertex(event);
+
+	G4PrimaryVertex* vertex =
+		event->GetPrimaryVertex(event->GetNumberOfPrimaryVertex() - 1);
+	vertex->SetWeight(record.weight);
+
+	// the next event from the default beam redefines the ion
+	ionBeam = false;
+}
+
+void
+PrimaryGeneratorAction::SetRasterPrimary(G4Event* event)
+{
+	RasterScan* raster = RasterScan::Instance();
+
+	G4int spot = raster->SpotID(EventSeeding::GlobalEventID(event->GetEventID()));
+	event->SetUserInformation(new SpotInformation(spot));
+
+	// the spot has enough tracks, the event isn't simulated
+	if (raster->SpotDone(spot)) {
+		event->SetEventAborted();
+		return;
+	}
+
+	if (!ionBeam)
+		SetIonBeam();
+	gun->SetParticleEnergy(raster->SpotEnergy(spot) * A);
+
+	G4double x0 = 0.0, y0 = 0.0;
+	raster->SpotCenter( spot, x0, y0);
+	x0 += G4RandGauss::shoot( 0.0, raster->Sigma());
+	y0 += G4RandGauss::shoot( 0.0, raster->Sigma());
+
+	gun->SetParticlePosition(G4ThreeVector( x0, y0, beam_z()));
+
+	gun->GeneratePrimaryVertex(event);
+
+	// energy of the default beam
+	gun->SetParticleEnergy(beam_energy());
+}
+
 void
 PrimaryGeneratorAction::GeneratePrimaries(G4Event* event)
 {
-	G4ParticleDefinition* particle = gun->GetParticleDefinition();
-	if (particle == G4Geantino::Geantino()) {
-		G4ParticleDefinition* ion = G4IonTable::GetIonTable()->GetIon( Z, A, ee);
-
-		gun->SetParticleDefinition(ion);
-		gun->SetParticleCharge(ionCharge);
-		gun->SetParticleMomentumDirection(G4ThreeVector( 0., 0., 1.));
-		gun->SetParticleEnergy(energy);
+	// the whole event is generated from its own random stream
+	if (EventSeeding::IsEnabled())
+		EventSeeding::Reseed(event->GetEventID());
+
+	PhaseSpace* source = PhaseSpace::Instance();
+	if (source) {
+		SetPhaseSpacePrimary( source, event);
+		return;
 	}
 
+	if (RasterScan::Instance()->IsEnabled()) {
+		SetRasterPrimary(event);
+		return;
+	}
+
+	if (!ionBeam)
+		SetIonBeam();
+
 	G4double x0 = 60.0 * (G4UniformRand() - 0.5) * CLHEP::mm;
 //	G4double y0 = 0.0 * CLHEP::mm;
 	G4double y0 = 60.0 * (G4UniformRand() - 0.5) * CLHEP::mm;
 
-	gun->SetParticlePosition(G4ThreeVector( x0, y0,
-		-CIR_DISTANCE_BEAM_Y1 * CLHEP::mm));
+	gun->SetParticlePosition(G4ThreeVector( x0, y0, beam_z()));
 
 //	gun->SetParticlePosition(G4ThreeVector( 0.28 * CLHEP::cm, 0.30 * CLHEP::cm,
 //		-CIR_DISTANCE_BEAM_Y1 * CLHEP::mm));
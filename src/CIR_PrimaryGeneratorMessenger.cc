@@ -0,0 +1,71 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4UIdirectory.hh>
+#include <G4UIcmdWithAnInteger.hh>
+
+#include "CIR_PrimaryGeneratorAction.hh"
+#include "CIR_PrimaryGeneratorMessenger.hh"
+
+namespace CarbonIonRadiography {
+
+PrimaryGeneratorMessenger::PrimaryGeneratorMessenger(
+	PrimaryGeneratorAction* generator)
+	:
+	primary_generator(generator),
+	beam_dir(0),
+	chunk_cmd(0)
+{
+	// Beam directory
+	beam_dir = new G4UIdirectory("/beam/");
+	beam_dir->SetGuidance("Commands to select the primary beam");
+
+	// the phase space source (/beam/phaseSpace) is opened by the master,
+	// see RunActionMessenger
+
+	// Chunk of records
+	chunk_cmd = new G4UIcmdWithAnInteger(
+		"/beam/chunk", this);
+
+	chunk_cmd->SetGuidance("Number of phase space records claimed");
+	chunk_cmd->SetGuidance("by a thread at once.");
+	chunk_cmd->SetParameterName( "PhaseSpaceChunk", false);
+	chunk_cmd->SetRange("PhaseSpaceChunk>0");
+	chunk_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+PrimaryGeneratorMessenger::~PrimaryGeneratorMessenger()
+{
+	delete chunk_cmd;
+	delete beam_dir;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+PrimaryGeneratorMessenger::SetNewValue( G4UIcommand* command,
+	G4String newValue)
+{
+	if (command == chunk_cmd) {
+		G4int chunk = G4UIcmdWithAnInteger::GetNewIntValue(newValue);
+		primary_generator->SetPhaseSpaceChunk(chunk);
+	}
+}
+
+} // namespace CarbonIonRadiography
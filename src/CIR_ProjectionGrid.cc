@@ -0,0 +1,219 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <TH1.h>
+
+#include <fstream>
+#include <algorithm>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_ProjectionGrid.hh"
+
+namespace CarbonIonRadiography {
+
+ProjectionGrid::ProjectionGrid( const HistogramAxis& x, const HistogramAxis& y,
+	G4int slices)
+	:
+	x_(x),
+	y_(y),
+	x_scale_(x.scale()),
+	y_scale_(y.scale()),
+	cells_x_(x.bins + 2),
+	cells_y_(y.bins + 2),
+	slices_(slices),
+	entries_(0.0),
+	counts_( (x.bins + 2) * (y.bins + 2) * (slices + 1), 0.0)
+{
+}
+
+G4int
+ProjectionGrid::calorimeter_slices()
+{
+	return GeometryConfig::instance().calorimeter_slices();
+}
+
+G4bool
+ProjectionGrid::add(const ProjectionGrid& src)
+{
+	if (src.counts_.size() != counts_.size() || src.slices_ != slices_ ||
+		src.x_.min != x_.min || src.x_.max != x_.max ||
+		src.y_.min != y_.min || src.y_.max != y_.max)
+		return false;
+
+	for ( size_t i = 0; i < counts_.size(); ++i)
+		counts_[i] += src.counts_[i];
+	entries_ += src.entries_;
+	return true;
+}
+
+void
+ProjectionGrid::reset()
+{
+	std::fill( counts_.begin(), counts_.end(), 0.0);
+	entries_ = 0.0;
+}
+
+std::vector<G4double>
+ProjectionGrid::position_counts() const
+{
+	std::vector<G4double> counts( positions(), 0.0);
+	for ( G4int pixel = 0; pixel < cells_x_ * cells_y_; ++pixel) {
+		const G4double* c = &counts_[pixel * positions()];
+		for ( G4int i = 0; i < positions(); ++i)
+			counts[i] += c[i];
+	}
+	return counts;
+}
+
+std::vector<G4double>
+ProjectionGrid::slice_contents() const
+{
+	// counts of every stopping position over all pixels
+	std::vector<G4double> counts = position_counts();
+
+	HistogramAxis axis( slices_, 0, slices_ - 1);
+	std::vector<G4double> slices( slices_ + 2, 0.0);
+	for ( G4int i = 0; i < positions(); ++i)
+		slices[axis.find_bin(i - 1)] += counts[i];
+	return slices;
+}
+
+TH1I*
+ProjectionGrid::create_slice_histogram( const char* name,
+	const char* title) const
+{
+	std::vector<G4double> slices = slice_contents();
+
+	TH1I* hist = new TH1I( name, title, slices_, 0, slices_ - 1);
+	for ( size_t i = 0; i < slices.size(); ++i)
+		hist->SetBinContent( i, slices[i]);
+	hist->SetEntries(entries_);
+	return hist;
+}
+
+G4int
+ProjectionGrid::peak_position() const
+{
+	std::vector<G4double> slices = slice_contents();
+	std::vector<G4double>::const_iterator iter = std::max_element(
+		slices.begin() + 1, slices.begin() + 1 + slices_);
+
+	return iter - slices.begin();
+}
+
+void
+ProjectionGrid::form_images( G4int pos_min, G4int pos_max, G4int offset,
+	G4int sign, Histogram2D<G4double>& position,
+	Histogram2D<G4double>& weight) const
+{
+	std::vector<G4double> values(positions());
+	for ( G4int i = 0; i < positions(); ++i)
+		values[i] = offset + sign * (i - 1);
+
+	form_images( pos_min, pos_max, values, position, weight);
+}
+
+void
+ProjectionGrid::form_images( G4int pos_min, G4int pos_max,
+	const std::vector<G4double>& values, Histogram2D<G4double>& position,
+	Histogram2D<G4double>& weight) const
+{
+	std::vector<G4double> slices = slice_contents();
+
+	for ( G4int pixel = 0; pixel < cells_x_ * cells_y_; ++pixel) {
+		const G4double* c = &counts_[pixel * positions()];
+		for ( G4int i = 0; i < positions(); ++i) {
+			G4int pos = i - 1;
+			if (!c[i] || pos < pos_min || pos > pos_max)
+				continue;
+
+			// slice histogram content of bin (pos + 1), as TH1::GetBinContent
+			G4int bin = std::min( std::max( pos + 1, 0), slices_ + 1);
+
+			G4double v = values[i];
+			G4double w = slices[bin];
+			position.add_bin( pixel, c[i] * v, c[i], c[i] * v * v);
+			weight.add_bin( pixel, c[i] * w, c[i], c[i] * w * w);
+		}
+	}
+}
+
+G4bool
+ProjectionGrid::write(std::ostream& dump) const
+{
+	dump.write( (char *)&x_.bins, sizeof(G4int));
+	dump.write( (char *)&x_.min, sizeof(G4double));
+	dump.write( (char *)&x_.max, sizeof(G4double));
+	dump.write( (char *)&y_.bins, sizeof(G4int));
+	dump.write( (char *)&y_.min, sizeof(G4double));
+	dump.write( (char *)&y_.max, sizeof(G4double));
+	dump.write( (char *)&slices_, sizeof(G4int));
+	dump.write( (char *)&entries_, sizeof(G4double));
+	dump.write( (char *)&counts_[0], counts_.size() * sizeof(G4double));
+
+	return dump.good();
+}
+
+G4bool
+ProjectionGrid::read( std::istream& dump, ProjectionGrid& grid)
+{
+	HistogramAxis x, y;
+	G4int slices = 0;
+	G4double entries = 0.0;
+
+	dump.read( (char *)&x.bins, sizeof(G4int));
+	dump.read( (char *)&x.min, sizeof(G4double));
+	dump.read( (char *)&x.max, sizeof(G4double));
+	dump.read( (char *)&y.bins, sizeof(G4int));
+	dump.read( (char *)&y.min, sizeof(G4double));
+	dump.read( (char *)&y.max, sizeof(G4double));
+	dump.read( (char *)&slices, sizeof(G4int));
+	dump.read( (char *)&entries, sizeof(G4double));
+
+	if (!dump || x.bins <= 0 || y.bins <= 0 || slices <= 0)
+		return false;
+
+	ProjectionGrid data( x, y, slices);
+	data.entries_ = entries;
+	dump.read( (char *)&data.counts_[0],
+		data.counts_.size() * sizeof(G4double));
+	if (!dump)
+		return false;
+
+	grid = data;
+	return true;
+}
+
+G4bool
+ProjectionGrid::save(const char* filename) const
+{
+	// dump data
+	std::ofstream dump( filename, std::ios::binary);
+	return write(dump);
+}
+
+G4bool
+ProjectionGrid::load( const char* filename, ProjectionGrid& grid)
+{
+	// dump data
+	std::ifstream dump( filename, std::ios::binary);
+	return read( dump, grid);
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,122 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4ios.hh>
+#include <G4SystemOfUnits.hh>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_RasterScan.hh"
+
+namespace CarbonIonRadiography {
+
+RasterScan::RasterScan()
+	:
+	enabled(false),
+	spotsX(1),
+	spotsY(1),
+	pitchX(0.0),
+	pitchY(0.0),
+	sigma(0.0),
+	particles(1),
+	layers( 1, 0.0),
+	minTracks(0)
+{
+}
+
+RasterScan*
+RasterScan::Instance()
+{
+	static RasterScan instance;
+	return &instance;
+}
+
+void
+RasterScan::SetSpots( G4int nx, G4int ny, G4double px, G4double py)
+{
+	spotsX = nx;
+	spotsY = ny;
+	pitchX = px;
+	pitchY = py;
+}
+
+void
+RasterScan::SetEnergies(const std::vector<G4double>& energies)
+{
+	if (!energies.empty())
+		layers = energies;
+}
+
+G4int
+RasterScan::SpotID(G4int eventID) const
+{
+	G4int spots = NumberOfSpots();
+	if (spots <= 0 || particles <= 0)
+		return 0;
+	return (eventID / particles) % spots;
+}
+
+void
+RasterScan::SpotCenter( G4int spot, G4double& x, G4double& y) const
+{
+	G4int ix = spot % spotsX;
+	G4int iy = (spot / spotsX) % spotsY;
+
+	// the grid is centered on the beam axis
+	x = (ix - 0.5 * (spotsX - 1)) * pitchX;
+	y = (iy - 0.5 * (spotsY - 1)) * pitchY;
+}
+
+G4double
+RasterScan::SpotEnergy(G4int spot) const
+{
+	G4double energy = layers[(spot / (spotsX * spotsY)) % layers.size()];
+	return (energy > 0.0) ? energy : GeometryConfig::instance().energy_per_nucleon();
+}
+
+void
+RasterScan::ResetCounters()
+{
+	std::vector< std::atomic<G4int> > counters( minTracks > 0 ? NumberOfSpots() : 0);
+	for ( size_t i = 0; i < counters.size(); ++i)
+		counters[i] = 0;
+	tracks.swap(counters);
+}
+
+G4bool
+RasterScan::SpotDone(G4int spot) const
+{
+	if (size_t(spot) >= tracks.size())
+		return false;
+	return tracks[spot].load(std::memory_order_relaxed) >= minTracks;
+}
+
+void
+RasterScan::CountTrack(G4int spot)
+{
+	if (size_t(spot) < tracks.size())
+		tracks[spot].fetch_add( 1, std::memory_order_relaxed);
+}
+
+void
+SpotInformation::Print() const
+{
+	G4cout << "Spot " << spotID << G4endl;
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,195 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4UIdirectory.hh>
+#include <G4UIcommand.hh>
+#include <G4UIparameter.hh>
+#include <G4UIcmdWithABool.hh>
+#include <G4UIcmdWithAnInteger.hh>
+#include <G4UIcmdWithAString.hh>
+#include <G4UIcmdWithADoubleAndUnit.hh>
+#include <G4UIcmdWithoutParameter.hh>
+#include <G4SystemOfUnits.hh>
+
+#include <sstream>
+#include <vector>
+
+#include "CIR_RasterScan.hh"
+#include "CIR_RunAction.hh"
+#include "CIR_RasterScanMessenger.hh"
+
+namespace CarbonIonRadiography {
+
+RasterScanMessenger::RasterScanMessenger(RunAction* run)
+	:
+	run_action(run),
+	raster_dir(0),
+	enable_cmd(0),
+	spots_cmd(0),
+	sigma_cmd(0),
+	particles_cmd(0),
+	energies_cmd(0),
+	min_tracks_cmd(0),
+	beam_on_cmd(0)
+{
+	// Raster directory
+	raster_dir = new G4UIdirectory("/raster/");
+	raster_dir->SetGuidance("Commands of the raster scan pencil beam delivery");
+
+	// Raster mode
+	enable_cmd = new G4UIcmdWithABool(
+		"/raster/enable", this);
+
+	enable_cmd->SetGuidance("Deliver the beam as the raster of spots,");
+	enable_cmd->SetGuidance("every event is tagged with its spot ID.");
+	enable_cmd->SetParameterName( "RasterScan", true);
+	enable_cmd->SetDefaultValue(true);
+	enable_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	enable_cmd->SetToBeBroadcasted(false);
+
+	// Spots grid
+	spots_cmd = new G4UIcommand( "/raster/spots", this);
+
+	spots_cmd->SetGuidance("Grid of nx by ny spots with the pitch in mm,");
+	spots_cmd->SetGuidance("centered on the beam axis.");
+
+	G4UIparameter* nx_param = new G4UIparameter( "nx", 'i', false);
+	nx_param->SetParameterRange("nx>0");
+	spots_cmd->SetParameter(nx_param);
+
+	G4UIparameter* ny_param = new G4UIparameter( "ny", 'i', false);
+	ny_param->SetParameterRange("ny>0");
+	spots_cmd->SetParameter(ny_param);
+
+	G4UIparameter* px_param = new G4UIparameter( "pitchX", 'd', false);
+	px_param->SetParameterRange("pitchX>=0.");
+	spots_cmd->SetParameter(px_param);
+
+	G4UIparameter* py_param = new G4UIparameter( "pitchY", 'd', false);
+	py_param->SetParameterRange("pitchY>=0.");
+	spots_cmd->SetParameter(py_param);
+
+	spots_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	spots_cmd->SetToBeBroadcasted(false);
+
+	// Spot size
+	sigma_cmd = new G4UIcmdWithADoubleAndUnit(
+		"/raster/sigma", this);
+
+	sigma_cmd->SetGuidance("Gaussian sigma of the spot.");
+	sigma_cmd->SetParameterName( "SpotSigma", false);
+	sigma_cmd->SetRange("SpotSigma>=0.");
+	sigma_cmd->SetDefaultUnit("mm");
+	sigma_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	sigma_cmd->SetToBeBroadcasted(false);
+
+	// Particles per spot
+	particles_cmd = new G4UIcmdWithAnInteger(
+		"/raster/particles", this);
+
+	particles_cmd->SetGuidance("Number of particles per spot.");
+	particles_cmd->SetParameterName( "SpotParticles", false);
+	particles_cmd->SetRange("SpotParticles>0");
+	particles_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	particles_cmd->SetToBeBroadcasted(false);
+
+	// Energy layers
+	energies_cmd = new G4UIcmdWithAString(
+		"/raster/energies", this);
+
+	energies_cmd->SetGuidance("Kinetic energies per nucleon of the layers");
+	energies_cmd->SetGuidance("in MeV, e.g. \"400 430 455\".");
+	energies_cmd->SetParameterName( "LayerEnergies", false);
+	energies_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	energies_cmd->SetToBeBroadcasted(false);
+
+	// Early stop
+	min_tracks_cmd = new G4UIcmdWithAnInteger(
+		"/raster/minTracks", this);
+
+	min_tracks_cmd->SetGuidance("Stop a spot when it has got the number");
+	min_tracks_cmd->SetGuidance("of full tracks (projection mode only),");
+	min_tracks_cmd->SetGuidance("0 -- every spot gets all its particles.");
+	min_tracks_cmd->SetParameterName( "SpotMinTracks", false);
+	min_tracks_cmd->SetRange("SpotMinTracks>=0");
+	min_tracks_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	min_tracks_cmd->SetToBeBroadcasted(false);
+
+	// Run the whole raster
+	beam_on_cmd = new G4UIcmdWithoutParameter(
+		"/raster/beamOn", this);
+
+	beam_on_cmd->SetGuidance("Run the events of all spots and layers.");
+	beam_on_cmd->AvailableForStates(G4State_Idle);
+	beam_on_cmd->SetToBeBroadcasted(false);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+RasterScanMessenger::~RasterScanMessenger()
+{
+	delete enable_cmd;
+	delete spots_cmd;
+	delete sigma_cmd;
+	delete particles_cmd;
+	delete energies_cmd;
+	delete min_tracks_cmd;
+	delete beam_on_cmd;
+	delete raster_dir;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+RasterScanMessenger::SetNewValue( G4UIcommand* command, G4String newValue)
+{
+	RasterScan* raster = RasterScan::Instance();
+
+	if (command == enable_cmd) {
+		raster->SetEnabled(G4UIcmdWithABool::GetNewBoolValue(newValue));
+	}
+	else if (command == spots_cmd) {
+		G4int nx = 1, ny = 1;
+		G4double px = 0.0, py = 0.0;
+		std::istringstream values(newValue);
+		values >> nx >> ny >> px >> py;
+		raster->SetSpots( nx, ny, px * mm, py * mm);
+	}
+	else if (command == sigma_cmd) {
+		raster->SetSigma(G4UIcmdWithADoubleAndUnit::GetNewDoubleValue(newValue));
+	}
+	else if (command == particles_cmd) {
+		raster->SetParticlesPerSpot(
+			G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+	}
+	else if (command == energies_cmd) {
+		std::vector<G4double> energies;
+		std::istringstream values(newValue);
+		G4double energy = 0.0;
+		while (values >> energy)
+			energies.push_back(energy * MeV);
+		raster->SetEnergies(energies);
+	}
+	else if (command == min_tracks_cmd) {
+		raster->SetMinTracks(G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+	}
+	else if (command == beam_on_cmd) {
+		run_action->runRaster();
+	}
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,162 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4SystemOfUnits.hh>
+#include <G4PhysicalConstants.hh>
+#include <G4TransportationManager.hh>
+#include <G4VPhysicalVolume.hh>
+#include <G4LogicalVolume.hh>
+#include <G4Material.hh>
+
+#include <algorithm>
+#include <cmath>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_RayCaster.hh"
+
+namespace {
+
+// liquid water, ICRU 90
+const G4double water_electron_density = 3.3428e23 / CLHEP::cm3;
+const G4double water_excitation_energy = 78.0 * CLHEP::eV;
+
+// navigation steps of one ray, guard against stuck rays
+const G4int max_ray_steps = 1000000;
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+/////////////////////////////////////////////////////////////////////////////
+RayCaster::RayCaster()
+	:
+	energy(-1.0),
+	beta2(0.0),
+	waterLog(0.0)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+RayCaster::~RayCaster()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+RayCaster::SetVelocity(G4double energyPerNucleon)
+{
+	if (energyPerNucleon == energy)
+		return;
+
+	energy = energyPerNucleon;
+	G4double gamma = 1.0 + energy / CLHEP::amu_c2;
+	beta2 = 1.0 - 1.0 / (gamma * gamma);
+	waterLog = std::log( 2.0 * CLHEP::electron_mass_c2 * beta2 * gamma * gamma
+		/ water_excitation_energy) - beta2;
+	stoppingPowers.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+G4double
+RayCaster::RelativeStoppingPower(const G4Material* material)
+{
+	std::map< const G4Material*, G4double>::iterator it =
+		stoppingPowers.find(material);
+	if (it != stoppingPowers.end())
+		return it->second;
+
+	G4double gamma2 = 1.0 / (1.0 - beta2);
+	G4double excitation = material->GetIonisation()->GetMeanExcitationEnergy();
+	G4double stoppingLog = std::log( 2.0 * CLHEP::electron_mass_c2 * beta2 * gamma2
+		/ excitation) - beta2;
+
+	G4double rsp = material->GetElectronDensity() / water_electron_density
+		* stoppingLog / waterLog;
+	stoppingPowers[material] = rsp;
+	return rsp;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+RayCaster::Cast( const G4ThreeVector& position, const G4ThreeVector& direction,
+	G4double energyPerNucleon, RayRecord& ray)
+{
+	if (!navigator.GetWorldVolume()) {
+		navigator.SetWorldVolume( G4TransportationManager::GetTransportationManager()
+			->GetNavigatorForTracking()->GetWorldVolume());
+	}
+	SetVelocity(energyPerNucleon);
+
+	// water equivalent thickness along the ray up to the front face of
+	// the first XY3 plane, the rear tracker, air and calorimeter behind
+	// the object aren't counted
+	const GeometryConfig& config = GeometryConfig::instance();
+	G4double stop = std::min( config.plane(MSD_Y3).z, config.plane(MSD_X3).z)
+		- config.silicon_thickness() / 2.0;
+
+	ray.wet = 0.0;
+	G4ThreeVector point = position;
+	G4VPhysicalVolume* volume = navigator.LocateGlobalPointAndSetup( point,
+		&direction, false, false);
+	for ( G4int i = 0; volume && i < max_ray_steps; ++i) {
+		// path left to the stop plane, up to the world boundary if the
+		// ray doesn't go downstream
+		G4double left = (direction.z() > 0.0) ?
+			(stop - point.z()) / direction.z() : kInfinity;
+		if (left <= 0.0)
+			break;
+
+		G4double safety = 0.0;
+		G4double step = navigator.ComputeStep( point, direction, left,
+			safety);
+		G4bool last = (step >= left);
+		if (last)
+			step = left;
+		if (step == kInfinity)
+			break;
+
+		// the navigator sets the material of the parameterised voxels
+		const G4Material* material = volume->GetLogicalVolume()->GetMaterial();
+		ray.wet += step * RelativeStoppingPower(material);
+		if (last)
+			break;
+
+		point += step * direction;
+		navigator.SetGeometricallyLimitedStep();
+		volume = navigator.LocateGlobalPointAndSetup( point, &direction, true);
+	}
+
+	// crossing points of the planes at the positions of the detector
+	// construction
+	for ( G4int pos = 0; pos < CIR_NUMBER_OF_SILICON_DETECTORS; ++pos) {
+		G4double t = (direction.z() != 0.0) ?
+			(config.plane(pos).z - position.z()) / direction.z() : 0.0;
+		ray.planes[pos][0] = (position.x() + t * direction.x()) / CLHEP::um;
+		ray.planes[pos][1] = (position.y() + t * direction.y()) / CLHEP::um;
+	}
+
+	const StripGeometry& x2 = config.plane(MSD_X2);
+	const StripGeometry& x3 = config.plane(MSD_X3);
+	G4double z = (x2.z + x3.z) / 2.0;
+	G4double t = (direction.z() != 0.0) ? (z - position.z()) / direction.z() : 0.0;
+	ray.x = (position.x() + t * direction.x()) / CLHEP::um;
+	ray.y = (position.y() + t * direction.y()) / CLHEP::um;
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,334 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <functional>
+
+#include <G4ios.hh>
+
+#include "CIR_Track.hh"
+#include "CIR_TrackFitter.hh"
+#include "CIR_TrackStore.hh"
+#include "CIR_TrackCoordinates.hh"
+#include "CIR_HitsPositions.hh"
+#include "CIR_StripGeometry.hh"
+#include "CIR_ProjectionGrid.hh"
+#include "CIR_BoundedQueue.hh"
+#include "CIR_Parallel.hh"
+#include "CIR_ReconstructionPipeline.hh"
+
+namespace {
+
+using namespace CarbonIonRadiography;
+
+// Every chunk carries the sequence number of its decoding, the workers
+// finish the chunks in any order and the bin stage restores it.
+
+// decoded events
+struct HitsChunk {
+	size_t sequence;
+	std::vector<HitsPositions> events;
+};
+
+// plane XY1, XY2, XY3 coordinates (um) of events with all planes hit
+struct CoordinatesChunk {
+	size_t sequence;
+	std::vector<G4double> x; // 3 per event
+	std::vector<G4double> y; // 3 per event
+	std::vector<G4int> position; // calorimeter stopping position
+};
+
+// fitted tracks with the plane XY3 hits for the trajectory check
+struct TracksChunk {
+	size_t sequence;
+	MainTracksVector main;
+	FullTracksVector full;
+	std::vector<G4double> x3;
+	std::vector<G4double> y3;
+};
+
+// accepted main and full tracks
+struct FilteredChunk {
+	size_t sequence;
+	MainTracksVector main;
+	FullTracksVector full;
+};
+
+size_t
+decode( std::istream& dump, size_t events, size_t chunk_size,
+	BoundedQueue<HitsChunk>& output)
+{
+	size_t done = 0;
+	for ( size_t sequence = 0; done < events && dump; ++sequence) {
+		size_t n = std::min( chunk_size, events - done);
+
+		HitsChunk chunk;
+		chunk.sequence = sequence;
+		chunk.events.resize(n);
+		size_t i = 0;
+		for ( ; i < n && dump; ++i)
+			dump >> chunk.events[i];
+		if (!dump) // truncated file
+			chunk.events.resize(i ? i - 1 : 0);
+
+		done += chunk.events.size();
+		if (chunk.events.empty() || !output.push(std::move(chunk)))
+			break;
+	}
+	return done;
+}
+
+void
+coordinates( BoundedQueue<HitsChunk>& input,
+	BoundedQueue<CoordinatesChunk>& output)
+{
+	HitsChunk chunk_hits;
+	while (input.pop(chunk_hits)) {
+		std::vector<HitsPositions>& hits = chunk_hits.events;
+		CoordinatesChunk chunk;
+		chunk.sequence = chunk_hits.sequence;
+		chunk.x.reserve(3 * hits.size());
+		chunk.y.reserve(3 * hits.size());
+		chunk.position.reserve(hits.size());
+
+		for ( size_t i = 0; i < hits.size(); ++i) {
+			TrackCoordinates coord(hits[i]);
+			coord.calculate_coordinates();
+
+			G4double x[3], y[3];
+			if (!coord.get_coordinates( x, y))
+				continue;
+
+			chunk.x.insert( chunk.x.end(), x, x + 3);
+			chunk.y.insert( chunk.y.end(), y, y + 3);
+			chunk.position.push_back(hits[i].calorimeter_position());
+		}
+		output.push(std::move(chunk));
+	}
+}
+
+void
+fit( BoundedQueue<CoordinatesChunk>& input, BoundedQueue<TracksChunk>& output)
+{
+	const TrackFitter& full_x = full_track_fitter(true);
+	const TrackFitter& full_y = full_track_fitter(false);
+	const TrackFitter& main_x = main_track_fitter(true);
+	const TrackFitter& main_y = main_track_fitter(false);
+
+	CoordinatesChunk coord;
+	std::vector<Track> tracks_x, tracks_y;
+	while (input.pop(coord)) {
+		size_t n = coord.position.size();
+
+		tracks_x.resize(n);
+		tracks_y.resize(n);
+		if (n) {
+			full_x.fit( &coord.x[0], n, &tracks_x[0]);
+			full_y.fit( &coord.y[0], n, &tracks_y[0]);
+		}
+
+		TracksChunk chunk;
+		chunk.sequence = coord.sequence;
+		chunk.main.resize(n);
+		chunk.full.resize(n);
+		chunk.x3.resize(n);
+		chunk.y3.resize(n);
+		for ( size_t i = 0; i < n; ++i) {
+			const G4double* x = &coord.x[3 * i];
+			const G4double* y = &coord.y[3 * i];
+
+			chunk.main[i] = TrackXYPair( main_x.fit(x), main_y.fit(y));
+			chunk.full[i] = TracksPositionPair( TrackXYPair( tracks_x[i],
+				tracks_y[i]), coord.position[i]);
+			chunk.x3[i] = x[2];
+			chunk.y3[i] = y[2];
+		}
+		output.push(std::move(chunk));
+	}
+}
+
+void
+filter( BoundedQueue<TracksChunk>& input, BoundedQueue<FilteredChunk>& output)
+{
+	TracksChunk tracks;
+	while (input.pop(tracks)) {
+		FilteredChunk chunk;
+		chunk.sequence = tracks.sequence;
+		chunk.main.reserve(tracks.main.size());
+		chunk.full.reserve(tracks.full.size());
+		for ( size_t i = 0; i < tracks.full.size(); ++i) {
+			if (TrackCoordinates::within_trajectory( tracks.main[i],
+				tracks.x3[i], tracks.y3[i])) {
+				chunk.main.push_back(tracks.main[i]);
+				chunk.full.push_back(tracks.full[i]);
+			}
+		}
+		output.push(std::move(chunk));
+	}
+}
+
+size_t
+bin( BoundedQueue<FilteredChunk>& input,
+	const ReconstructionPipeline::TracksSink& sink)
+{
+	// chunks ahead of the next one in the decoding order wait, so the
+	// sink gets the tracks in the order of the file
+	size_t tracks = 0;
+	size_t next = 0;
+	std::map< size_t, FilteredChunk> pending;
+	FilteredChunk chunk;
+	while (input.pop(chunk)) {
+		size_t sequence = chunk.sequence;
+		pending[sequence] = std::move(chunk);
+
+		std::map< size_t, FilteredChunk>::iterator it;
+		while ((it = pending.find(next)) != pending.end()) {
+			sink( it->second.main, it->second.full);
+			tracks += it->second.full.size();
+			pending.erase(it);
+			++next;
+		}
+	}
+	return tracks;
+}
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+ReconstructionPipeline::ReconstructionPipeline(G4int threads)
+	:
+	threads_(threads),
+	chunk_size_(4096),
+	queue_size_(0),
+	events_(0),
+	tracks_(0)
+{
+}
+
+size_t
+ReconstructionPipeline::process( const char* filename, ProjectionGrid& grid)
+{
+	std::ifstream dump( filename, std::ios::binary);
+	if (!dump) {
+		G4cerr << "Can't open hits file " << filename << G4endl;
+		events_ = tracks_ = 0;
+		return 0;
+	}
+
+	size_t hits_size = 0;
+	dump.read( (char *)&hits_size, sizeof(size_t));
+
+	return process( dump, hits_size, grid);
+}
+
+size_t
+ReconstructionPipeline::process( std::istream& dump, size_t events,
+	ProjectionGrid& grid)
+{
+	const StripGeometry* plane_y2 = StripGeometry::strip_geometry(MSD_Y2);
+	const StripGeometry* plane_x2 = StripGeometry::strip_geometry(MSD_X2);
+	const StripGeometry* plane_y3 = StripGeometry::strip_geometry(MSD_Y3);
+	const StripGeometry* plane_x3 = StripGeometry::strip_geometry(MSD_X3);
+
+	G4double full_x_z = (plane_x2->z + plane_x3->z) / 2.0;
+	G4double full_y_z = (plane_y2->z + plane_y3->z) / 2.0;
+
+	TrackStore store;
+	std::vector<G4double> full_x, full_y;
+	return process( dump, events,
+		[&]( const MainTracksVector&, const FullTracksVector& full) {
+			store.assign(full);
+			store.extrapolate( full_x_z, full_y_z, full_x, full_y);
+
+			const G4int* position = store.position();
+			for ( size_t i = 0; i < store.size(); ++i)
+				grid.fill( full_x[i], full_y[i], position[i]);
+		});
+}
+
+size_t
+ReconstructionPipeline::process( const char* filename, const TracksSink& sink)
+{
+	std::ifstream dump( filename, std::ios::binary);
+	if (!dump) {
+		G4cerr << "Can't open hits file " << filename << G4endl;
+		events_ = tracks_ = 0;
+		return 0;
+	}
+
+	size_t hits_size = 0;
+	dump.read( (char *)&hits_size, sizeof(size_t));
+
+	return process( dump, hits_size, sink);
+}
+
+size_t
+ReconstructionPipeline::process( std::istream& dump, size_t events,
+	const TracksSink& sink)
+{
+	G4int workers = hardware_threads(threads_);
+	size_t queue_size = queue_size_ ? queue_size_ : 2 * workers;
+
+	BoundedQueue<HitsChunk> hits_queue(queue_size);
+	BoundedQueue<CoordinatesChunk> coordinates_queue(queue_size);
+	BoundedQueue<TracksChunk> tracks_queue(queue_size);
+	BoundedQueue<FilteredChunk> filtered_queue(queue_size);
+
+	std::vector<std::thread> coordinates_workers, fit_workers;
+	for ( G4int i = 0; i < workers; ++i) {
+		coordinates_workers.push_back(std::thread( coordinates,
+			std::ref(hits_queue), std::ref(coordinates_queue)));
+		fit_workers.push_back(std::thread( fit,
+			std::ref(coordinates_queue), std::ref(tracks_queue)));
+	}
+	std::thread filter_worker( filter, std::ref(tracks_queue),
+		std::ref(filtered_queue));
+
+	size_t tracks = 0;
+	std::thread bin_worker( [&]() {
+		tracks = bin( filtered_queue, sink);
+	});
+
+	// decode in the calling thread, then close the stages one by one
+	events_ = decode( dump, events, chunk_size_, hits_queue);
+	hits_queue.close();
+
+	for ( size_t i = 0; i < coordinates_workers.size(); ++i)
+		coordinates_workers[i].join();
+	coordinates_queue.close();
+
+	for ( size_t i = 0; i < fit_workers.size(); ++i)
+		fit_workers[i].join();
+	tracks_queue.close();
+
+	filter_worker.join();
+	filtered_queue.close();
+
+	bin_worker.join();
+	tracks_ = tracks;
+
+	return events_;
+}
+
+} // namespace CarbonIonRadiography
@@ -24,29 +24,156 @@
 #include <G4SystemOfUnits.hh>
 #include <G4DigiManager.hh>
 #include <G4THitsMap.hh>
+#include <G4Threading.hh>
+#include <G4RunManager.hh>
+
+#include <algorithm>
 
 #include "CIR_EventAction.hh"
 #include "CIR_TrackCoordinates.hh"
+#include "CIR_TrackReconstruction.hh"
+#include "CIR_ProjectionGrid.hh"
+#include "CIR_Checkpoint.hh"
+#include "CIR_EventSeeding.hh"
+#include "CIR_RasterScan.hh"
 #include "CIR_Run.hh"
 
 namespace CarbonIonRadiography {
 
-Run::Run(EventAction* fEventAction)
+Run::Run( EventAction* fEventAction, G4int checkpointInterval,
+	const G4String& checkpointPrefix, G4int checkpointGeneration)
 	:
 	G4Run(),
-	eventAction(fEventAction)
+	eventAction(fEventAction),
+	projection_grid(0),
+	ray_image(0),
+	statistics(0),
+	checkpoint_interval(checkpointInterval),
+	checkpoint_prefix(checkpointPrefix),
+	checkpoint_generation(checkpointGeneration),
+	checkpoint_segments(0),
+	checkpoint_hits(0),
+	checkpoint_id_segments(0),
+	checkpoint_ids(0)
 { 
+	if (eventAction->rayCastMode()) {
+		HistogramAxis axis = TrackReconstruction::default_axis();
+		ray_image = new Histogram2D<G4double>( axis, axis);
+	}
+	else if (eventAction->projectionMode()) {
+		HistogramAxis axis = TrackReconstruction::default_axis();
+		projection_grid = new ProjectionGrid( axis, axis);
+		if (ConvergenceMonitor::Instance()->IsEnabled())
+			statistics = new ConvergenceMonitor::Statistics( axis, axis);
+	}
 }
 
 Run::~Run()
 {
+	delete projection_grid;
+	delete ray_image;
+	delete statistics;
 }
 
 void
-Run::RecordEvent(const G4Event* /* event */)
+Run::RecordEvent(const G4Event* event)
 {
-	TREC::HitsPositions pos = eventAction->getPositions();
-	hits_positions.push_back(pos);
+	const SpotInformation* spot =
+		dynamic_cast<const SpotInformation*>(event->GetUserInformation());
+
+	// the event of a finished raster spot isn't simulated
+	if (event->IsAborted() && spot) {
+		G4Run::RecordEvent(event);
+		return;
+	}
+
+	if (ray_image) {
+		if (eventAction->hasRay()) {
+			const RayRecord& ray = eventAction->getRay();
+			ray_image->fill( ray.x, ray.y, ray.wet);
+			ray_records.push_back(ray);
+			ray_events.push_back( std::make_pair( spot ? spot->SpotID() : 0,
+				EventSeeding::IsEnabled() ?
+				EventSeeding::GlobalEventID(event->GetEventID()) : 0));
+		}
+	}
+	else if (projection_grid) {
+		if (eventAction->hasTrack()) {
+			projection_grid->fill( eventAction->trackX(), eventAction->trackY(),
+				eventAction->trackPosition());
+			if (spot)
+				RasterScan::Instance()->CountTrack(spot->SpotID());
+			if (statistics && eventAction->trackPosition() >= 0)
+				statistics->Fill( eventAction->trackX(), eventAction->trackY(),
+					eventAction->trackPosition());
+		}
+	}
+	else {
+		TREC::HitsPositions pos = eventAction->getPositions();
+		hits_positions.push_back(pos);
+	}
+
+	if (EventSeeding::IsEnabled())
+		event_ids.push_back(EventSeeding::GlobalEventID(event->GetEventID()));
+	if (spot)
+		spot_ids.push_back(spot->SpotID());
+
+	G4Run::RecordEvent(event);
+
+	if (checkpoint_interval > 0 && numberOfEvent % checkpoint_interval == 0)
+		WriteCheckpoint();
+
+	if (statistics)
+		UpdateConvergence();
+}
+
+void
+Run::UpdateConvergence()
+{
+	ConvergenceMonitor* monitor = ConvergenceMonitor::Instance();
+	if (numberOfEvent % monitor->Interval() == 0)
+		monitor->Update(*statistics);
+
+	// the other workers stop after their current event
+	if (monitor->IsConverged())
+		G4RunManager::GetRunManager()->AbortRun(true);
+}
+
+void
+Run::WriteCheckpoint()
+{
+	G4int thread = G4Threading::G4GetThreadId();
+	if (thread < 0) // sequential mode
+		thread = 0;
+
+	// hits since the previous checkpoint go to a new segment
+	if (!projection_grid && checkpoint_hits < hits_positions.size()) {
+		TREC::HitsPositionsVector segment(
+			hits_positions.begin() + checkpoint_hits, hits_positions.end());
+		G4String file = Checkpoint::SegmentFile( checkpoint_prefix,
+			checkpoint_generation, thread, checkpoint_segments);
+		if (!Checkpoint::SaveHits( file, segment))
+			return;
+		checkpoint_segments++;
+		checkpoint_hits = hits_positions.size();
+	}
+
+	// so do the event IDs, the resumed run simulates the missing ones
+	if (checkpoint_ids < event_ids.size()) {
+		const G4int* ids = &event_ids[0];
+		G4String file = Checkpoint::IDsFile( checkpoint_prefix,
+			checkpoint_generation, thread, checkpoint_id_segments);
+		if (!Checkpoint::SaveIDs( file, ids + checkpoint_ids,
+			ids + event_ids.size()))
+			return;
+		checkpoint_id_segments++;
+		checkpoint_ids = event_ids.size();
+	}
+
+	// the state refers only to complete segments
+	Checkpoint::SaveState( Checkpoint::StateFile( checkpoint_prefix,
+		checkpoint_generation, thread), numberOfEvent, checkpoint_segments,
+		checkpoint_id_segments, checkpoint_generation, projection_grid);
 }
 
 void
@@ -55,8 +182,40 @@ Run::Merge(const G4Run* aRun)
 	const Run* run = dynamic_cast<const Run*>(aRun);
 	Run* local_run = const_cast<Run*>(run);
 
+	const std::vector<G4int>& local_ids = local_run->eventIDs();
+	event_ids.insert( event_ids.end(), local_ids.begin(), local_ids.end());
+	const std::vector<G4int>& local_spots = local_run->spotIDs();
+	spot_ids.insert( spot_ids.end(), local_spots.begin(), local_spots.end());
+
+	// sum ray images, rays follow the merge order
+	if (ray_image && local_run->rayImage()) {
+		ray_image->add(*local_run->rayImage());
+		const std::vector<RayRecord>& local_rays = local_run->rays();
+		ray_records.insert( ray_records.end(), local_rays.begin(),
+			local_rays.end());
+		ray_events.insert( ray_events.end(), local_run->ray_events.begin(),
+			local_run->ray_events.end());
+		G4Run::Merge(run);
+		return;
+	}
+
+	// sum projection grids
+	if (projection_grid && local_run->projectionGrid()) {
+		projection_grid->add(*local_run->projectionGrid());
+		G4Run::Merge(run);
+		return;
+	}
+
 	const TREC::HitsPositionsVector& local_hits = local_run->hitsPositions();
 
+	// hits positions follow the event and spot IDs, sorted by SortEvents
+	if (!local_ids.empty() || !local_spots.empty()) {
+		hits_positions.insert( hits_positions.end(), local_hits.begin(),
+			local_hits.end());
+		G4Run::Merge(run);
+		return;
+	}
+
 	TREC::HitsPositionsVector new_hits(this->hits_positions.size() + local_hits.size());
 
 	// merge hits positions
@@ -74,4 +233,57 @@ Run::Merge(const G4Run* aRun)
 	G4Run::Merge(run);
 }
 
+void
+Run::SortEvents()
+{
+	size_t n = std::max( event_ids.size(), spot_ids.size());
+
+	// spot, event ID (or the merge order without IDs), index
+	std::vector< std::pair< std::pair< G4int, G4int >, size_t > > order(n);
+	for ( size_t i = 0; i < n; ++i) {
+		G4int spot = spot_ids.empty() ? 0 : spot_ids[i];
+		G4int id = event_ids.empty() ? G4int(i) : event_ids[i];
+		order[i] = std::make_pair( std::make_pair( spot, id), i);
+	}
+	std::sort( order.begin(), order.end());
+
+	for ( size_t i = 0; i < n; ++i) {
+		if (!spot_ids.empty())
+			spot_ids[i] = order[i].first.first;
+		if (!event_ids.empty())
+			event_ids[i] = order[i].first.second;
+	}
+
+	// rays by their own IDs, not every event has a ray
+	if (!ray_records.empty()) {
+		size_t rays = ray_records.size();
+		std::vector< std::pair< std::pair< G4int, G4int >, size_t > >
+			ray_order(rays);
+		for ( size_t i = 0; i < rays; ++i) {
+			std::pair< G4int, G4int > key = ray_events[i];
+			if (event_ids.empty())
+				key.second = G4int(i);
+			ray_order[i] = std::make_pair( key, i);
+		}
+		std::sort( ray_order.begin(), ray_order.end());
+
+		std::vector<RayRecord> sorted_rays;
+		sorted_rays.reserve(rays);
+		for ( size_t i = 0; i < rays; ++i)
+			sorted_rays.push_back(ray_records[ray_order[i].second]);
+		ray_records.swap(sorted_rays);
+		for ( size_t i = 0; i < rays; ++i)
+			ray_events[i] = ray_order[i].first;
+	}
+
+	if (hits_positions.size() != n)
+		return;
+
+	TREC::HitsPositionsVector sorted_hits;
+	sorted_hits.reserve(hits_positions.size());
+	for ( size_t i = 0; i < n; ++i)
+		sorted_hits.push_back(hits_positions[order[i].second]);
+	hits_positions.swap(sorted_hits);
+}
+
 } // namespace CarbonIonRadiography
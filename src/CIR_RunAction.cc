@@ -17,37 +17,106 @@
  * 
  */
 
+#include <G4RunManager.hh>
+#include <G4SystemOfUnits.hh>
+#include <Randomize.hh>
+
 #include <TH1.h>
 #include <TH2.h>
 #include <TFile.h>
 
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <iomanip>
+
 #include "CIR_Run.hh"
-//#include "CIR_TrackReconstruction.hh"
+#include "CIR_EventAction.hh"
+#include "CIR_ProjectionGrid.hh"
+#include "CIR_TrackReconstruction.hh"
+#include "CIR_Checkpoint.hh"
+#include "CIR_Campaign.hh"
+#include "CIR_EventSeeding.hh"
+#include "CIR_RasterScan.hh"
+#include "CIR_ConvergenceMonitor.hh"
+#include "CIR_RasterScanMessenger.hh"
+#include "CIR_DetectorConstruction.hh"
+#include "CIR_RunActionMessenger.hh"
 #include "CIR_RunAction.hh"
 
+namespace {
+
+// generation of the checkpoint files of the current run, set by the master
+// before the run starts and read by the workers in GenerateRun
+G4int checkpointGeneration = 0;
+
+// suffix of the output and checkpoint files of a campaign shard
+G4String shardSuffix;
+
+// configuration of the following runs of a multi-configuration campaign
+G4String configurationTag;
+
+// projection of the CT acquisition being run
+G4String projectionSuffix;
+
+// output and checkpoint files suffix: .configuration.projection.shard
+G4String
+outputSuffix()
+{
+	G4String suffix;
+	if (!configurationTag.empty())
+		suffix = "." + configurationTag;
+	return suffix + projectionSuffix + shardSuffix;
+}
+
+} // namespace
+
 namespace CarbonIonRadiography {
 
 RunAction::RunAction(EventAction* fEventAction)
 	:
 	G4UserRunAction(),
-    eventAction(fEventAction)
+	eventAction(fEventAction),
+	messenger(0),
+	rasterMessenger(0),
+	checkpointInterval(0),
+	checkpointPrefix("checkpoint"),
+	resumedEvents(0),
+	resumedGrid(0),
+	shard(0)
 {
+	messenger = new RunActionMessenger(this);
+	rasterMessenger = new RasterScanMessenger(this);
 }
 
 RunAction::~RunAction()
 {
+	delete messenger;
+	delete rasterMessenger;
+	delete resumedGrid;
+	delete shard;
 }
 
 G4Run*
 RunAction::GenerateRun()
 {
-	return new Run(eventAction);
+	return new Run( eventAction, checkpointInterval, checkpointFiles(),
+		checkpointGeneration);
 }
 
 void
 RunAction::BeginOfRunAction(const G4Run*)
 {
 	// Initiate run parameters
+
+	// before the workers start the events
+	RasterScan* raster = RasterScan::Instance();
+	if (IsMaster() && raster->IsEnabled())
+		raster->ResetCounters();
+
+	if (IsMaster())
+		ConvergenceMonitor::Instance()->Reset();
 }
 
 void
@@ -58,16 +127,435 @@ RunAction::EndOfRunAction(const G4Run* run)
 	const Run* theRun = dynamic_cast<const Run*>(run);
 	 
 	if(IsMaster()) {
-		G4cout << "Global result with " << theRun->GetNumberOfEvent() << G4endl;
-		
-		const TREC::HitsPositionsVector& track_hits = theRun->hitsPositions();
+		G4int events = theRun->GetNumberOfEvent() + resumedEvents;
+		G4cout << "Global result with " << events << G4endl;
+
+		// the adaptive run stops before the cap once converged
+		ConvergenceMonitor* monitor = ConvergenceMonitor::Instance();
+		if (monitor->IsEnabled() && theRun->projectionGrid()) {
+			if (monitor->IsConverged())
+				G4cout << "Converged to the error (slices) "
+					<< monitor->Uncertainty() << " after " << events
+					<< " events" << G4endl;
+			else
+				G4cout << "Not converged to the error (slices) "
+					<< monitor->Target() << ", last error "
+					<< monitor->Uncertainty() << G4endl;
+		}
+
+		if (shard && events != shard->events && !monitor->IsConverged())
+			G4cerr << "Shard " << shard->index << " has " << events
+				<< " events instead of " << shard->events << G4endl;
 
-		TREC::HitsPositions::save( "hits.dat", track_hits);
+		// events grouped by spot and in the order of IDs, independent
+		// of the threads; the resumed events are merged by their IDs
+		G4bool merged = false;
+		if (EventSeeding::IsEnabled() || RasterScan::Instance()->IsEnabled()) {
+			Run* sortedRun = const_cast<Run*>(theRun);
+			sortedRun->SortEvents();
+			if (EventSeeding::IsEnabled() && resumedEvents) {
+				merged = mergeResumedEvents( theRun->eventIDs(),
+					theRun->hitsPositions());
+				saveEventIDs(resumedIDs);
+			}
+			else if (EventSeeding::IsEnabled())
+				saveEventIDs(theRun->eventIDs());
+			if (RasterScan::Instance()->IsEnabled())
+				saveSpots(theRun->spotIDs());
+		}
 
+		if (theRun->rayImage()) {
+			saveRays(theRun);
+			checkpointGeneration = 0;
+			clearResumed();
+			return;
+		}
+
+		// add the data of the resumed checkpoint
+		const ProjectionGrid* grid = theRun->projectionGrid();
+		if (grid && resumedGrid) {
+			resumedGrid->add(*grid);
+			grid = resumedGrid;
+		}
+
+		const TREC::HitsPositionsVector& track_hits = theRun->hitsPositions();
+		if (resumedEvents) {
+			if (!merged)
+				resumedHits.insert( resumedHits.end(), track_hits.begin(),
+					track_hits.end());
+			saveResults( resumedHits, grid);
+		}
+		else
+			saveResults( track_hits, grid);
+
+		// the results are complete, the checkpoint isn't needed anymore
+		if (checkpointInterval > 0 || resumedEvents)
+			Checkpoint::Remove( checkpointFiles(), checkpointGeneration);
+		checkpointGeneration = 0;
+		clearResumed();
 	}
 	else {
 		G4cout << "Local thread result with " << theRun->GetNumberOfEvent() << G4endl;
 	}
 }
 
+void
+RunAction::saveResults( const TREC::HitsPositionsVector& track_hits,
+	const ProjectionGrid* grid)
+{
+	G4String output;
+	if (grid) {
+		G4cout << "Projection with " << grid->entries() << " tracks" << G4endl;
+
+		output = "projection" + outputSuffix() + ".dat";
+		grid->save(output.c_str());
+
+		G4String image = "projection" + outputSuffix() + ".root";
+		TrackReconstruction rec;
+		rec.reconstruct( *grid, image.c_str());
+	}
+	else {
+		output = "hits" + outputSuffix() + ".dat";
+		TREC::HitsPositions::save( output.c_str(), track_hits);
+	}
+	lastOutput = output;
+
+	writeShardManifest( grid ? "projection" : "hits", output);
+}
+
+void
+RunAction::saveRays(const Run* run)
+{
+	const std::vector<RayRecord>& rays = run->rays();
+	G4cout << "Ray casting with " << rays.size() << " rays" << G4endl;
+
+	// water equivalent thickness, plane crossing points
+	G4String output = "rays" + outputSuffix() + ".dat";
+	std::ofstream dump( output.c_str(), std::ios::binary);
+
+	size_t rays_size = rays.size();
+	dump.write( (char *)&rays_size, sizeof(size_t));
+	if (rays_size)
+		dump.write( (char *)&rays[0], rays_size * sizeof(RayRecord));
+	dump.close();
+	lastOutput = output;
+
+	// mean water equivalent thickness image
+	const Histogram2D<G4double>* image = run->rayImage();
+	G4String root = "raycast" + outputSuffix() + ".root";
+	TFile* file = new TFile( root.c_str(), "RECREATE");
+	TH2D* sum = image->create_histogram( "wetsum", "WET sum",
+		Histogram2D<G4double>::content_sum);
+	TH2D* count = image->create_histogram( "rays", "Rays",
+		Histogram2D<G4double>::content_count);
+	TH2D* wet = static_cast<TH2D*>(sum->Clone("wet"));
+	wet->SetTitle("Water equivalent thickness");
+	wet->Divide(count);
+	sum->Write();
+	count->Write();
+	wet->Write();
+	file->Close();
+	delete file;
+
+	writeShardManifest( "rays", output);
+}
+
+void
+RunAction::writeShardManifest( const G4String& type, const G4String& output)
+{
+	if (!shard)
+		return;
+
+	shard->type = type;
+	shard->output = output;
+	G4String name = "shard";
+	if (!configurationTag.empty())
+		name += "." + configurationTag;
+	G4String manifest = shard->file_name( name, ".manifest");
+	if (!shard->write(manifest.c_str()))
+		G4cerr << "Can't write shard manifest " << manifest << G4endl;
+}
+
+void
+RunAction::saveEventIDs(const std::vector<G4int>& ids)
+{
+	G4String output = "events" + outputSuffix() + ".dat";
+	std::ofstream dump( output.c_str(), std::ios::binary);
+
+	size_t ids_size = ids.size();
+	dump.write( (char *)&ids_size, sizeof(size_t));
+	if (ids_size)
+		dump.write( (char *)&ids[0], ids_size * sizeof(G4int));
+}
+
+void
+RunAction::saveSpots(const std::vector<G4int>& spots)
+{
+	// spot ID, first event and number of events of every spot
+	std::vector<G4int> ids;
+	std::vector<size_t> first, count;
+	for ( size_t i = 0; i < spots.size(); ++i) {
+		if (ids.empty() || ids.back() != spots[i]) {
+			ids.push_back(spots[i]);
+			first.push_back(i);
+			count.push_back(0);
+		}
+		count.back()++;
+	}
+
+	G4String output = "spots" + outputSuffix() + ".dat";
+	std::ofstream dump( output.c_str(), std::ios::binary);
+
+	size_t spots_size = ids.size();
+	dump.write( (char *)&spots_size, sizeof(size_t));
+	for ( size_t i = 0; i < spots_size; ++i) {
+		dump.write( (char *)&ids[i], sizeof(G4int));
+		dump.write( (char *)&first[i], sizeof(size_t));
+		dump.write( (char *)&count[i], sizeof(size_t));
+	}
+}
+
+G4bool
+RunAction::mergeResumedEvents( const std::vector<G4int>& ids,
+	const TREC::HitsPositionsVector& hits)
+{
+	// the hits follow the IDs in the hits mode only
+	const G4bool withHits = (hits.size() == ids.size() &&
+		resumedHits.size() == resumedIDs.size());
+
+	const size_t resumed = resumedIDs.size();
+	const size_t n = resumed + ids.size();
+	std::vector< std::pair< G4int, size_t > > order(n);
+	for ( size_t i = 0; i < n; ++i)
+		order[i] = std::make_pair( i < resumed ? resumedIDs[i] :
+			ids[i - resumed], i);
+	std::sort( order.begin(), order.end());
+
+	std::vector<G4int> sorted_ids(n);
+	TREC::HitsPositionsVector sorted_hits;
+	sorted_hits.reserve(withHits ? n : 0);
+	for ( size_t i = 0; i < n; ++i) {
+		sorted_ids[i] = order[i].first;
+		size_t index = order[i].second;
+		if (withHits)
+			sorted_hits.push_back( index < resumed ? resumedHits[index] :
+				hits[index - resumed]);
+	}
+
+	resumedIDs.swap(sorted_ids);
+	if (withHits)
+		resumedHits.swap(sorted_hits);
+	return withHits;
+}
+
+G4String
+RunAction::checkpointFiles() const
+{
+	return checkpointPrefix + outputSuffix();
+}
+
+void
+RunAction::clearResumed()
+{
+	resumedEvents = 0;
+	resumedHits.clear();
+	resumedIDs.clear();
+	delete resumedGrid;
+	resumedGrid = 0;
+}
+
+void
+RunAction::resume(G4int totalEvents)
+{
+	if (!IsMaster())
+		return;
+
+	clearResumed();
+	if (eventAction->projectionMode()) {
+		HistogramAxis axis = TrackReconstruction::default_axis();
+		resumedGrid = new ProjectionGrid( axis, axis);
+	}
+
+	std::string engines;
+	G4int generation = 0;
+	if (!Checkpoint::Load( checkpointFiles(), resumedEvents, resumedHits,
+		resumedIDs, resumedGrid, engines, generation)) {
+		G4cerr << "No checkpoint \"" << checkpointFiles() << "\" to resume" << G4endl;
+		clearResumed();
+		return;
+	}
+	G4cout << "Resume checkpoint with " << resumedEvents << " events" << G4endl;
+
+	// with the per event seeding the workers checkpoint the IDs they were
+	// dealt, the IDs of the run missing from the checkpoint are simulated
+	// (events after the last checkpoint of a worker are lost)
+	const G4bool seeding = EventSeeding::IsEnabled();
+	const G4int offset = EventSeeding::EventOffset();
+	std::vector<G4int> missing;
+	if (seeding) {
+		std::vector<G4bool> done( totalEvents, false);
+		for ( size_t i = 0; i < resumedIDs.size(); ++i) {
+			G4int id = resumedIDs[i] - offset;
+			if (id >= 0 && id < totalEvents)
+				done[id] = true;
+		}
+		for ( G4int id = 0; id < totalEvents; ++id) {
+			if (!done[id])
+				missing.push_back(offset + id);
+		}
+	}
+
+	if (seeding ? missing.empty() : resumedEvents >= totalEvents) {
+		G4cout << "Global result with " << resumedEvents << G4endl;
+		if (seeding) {
+			mergeResumedEvents( std::vector<G4int>(),
+				TREC::HitsPositionsVector());
+			saveEventIDs(resumedIDs);
+		}
+		saveResults( resumedHits, resumedGrid);
+		Checkpoint::Remove( checkpointFiles(), generation);
+		clearResumed();
+		return;
+	}
+
+	// loaded data become the base of the next generation, the files of
+	// the interrupted run are removed after the base is written
+	if (!Checkpoint::SaveBase( checkpointFiles(), resumedEvents, resumedHits,
+		resumedIDs, resumedGrid, generation + 1)) {
+		clearResumed();
+		return;
+	}
+	Checkpoint::Remove( checkpointFiles(), generation, false);
+	checkpointGeneration = generation + 1;
+
+	// seeds of the remaining events depend only on the checkpoint,
+	// the workers are seeded by the master engine
+	size_t hash = std::hash<std::string>()(engines);
+	long seeds[3] = {
+		long(hash & 0x7fffffff) | 1,
+		long(((hash >> 31) ^ size_t(resumedEvents)) & 0x7fffffff) | 1,
+		0 };
+	CLHEP::HepRandom::setTheSeeds(seeds);
+
+	if (seeding) {
+		// exactly the missing events, bitwise identical to an
+		// uninterrupted run
+		EventSeeding::SetEventIDs(missing);
+		G4RunManager::GetRunManager()->BeamOn(G4int(missing.size()));
+		EventSeeding::SetEventIDs(std::vector<G4int>());
+	}
+	else
+		G4RunManager::GetRunManager()->BeamOn(totalEvents - resumedEvents);
+}
+
+void
+RunAction::runRaster()
+{
+	if (!IsMaster())
+		return;
+
+	RasterScan* raster = RasterScan::Instance();
+	raster->SetEnabled(true);
+
+	G4cout << "Raster scan of " << raster->NumberOfSpots() << " spots, "
+		<< raster->NumberOfEvents() << " events" << G4endl;
+
+	G4RunManager::GetRunManager()->BeamOn(raster->NumberOfEvents());
+}
+
+void
+RunAction::runTomography( G4int projections, G4int events, G4double span,
+	G4double start)
+{
+	if (!IsMaster() || projections < 1)
+		return;
+
+	G4RunManager* runManager = G4RunManager::GetRunManager();
+	DetectorConstruction* detector = const_cast<DetectorConstruction*>(
+		static_cast<const DetectorConstruction*>(
+		runManager->GetUserDetectorConstruction()));
+
+	G4cout << "CT acquisition of " << projections << " projections, "
+		<< events << " events each" << G4endl;
+
+	// projection index, angle, events and output file of every projection
+	G4String manifestName = "ct" + outputSuffix() + ".manifest";
+	std::ofstream manifest(manifestName.c_str());
+	manifest << "# projection angle(deg) events output" << G4endl;
+
+	// with the per event seeding every projection has its own events
+	G4int offset = EventSeeding::EventOffset();
+	G4double angle0 = detector->GetPhantomAngle();
+
+	for ( G4int i = 0; i < projections; ++i) {
+		G4double angle = start + span * i / projections;
+
+		std::ostringstream suffix;
+		suffix << ".p" << std::setw(3) << std::setfill('0') << i;
+		projectionSuffix = suffix.str();
+
+		// the geometry is reoptimized, the physics tables are kept
+		detector->SetPhantomAngle(angle);
+		EventSeeding::SetEventOffset(offset + i * events);
+
+		G4cout << "Projection " << i << ": " << angle / CLHEP::deg << " deg"
+			<< G4endl;
+		lastOutput.clear();
+		runManager->BeamOn(events);
+
+		manifest << i << " " << angle / CLHEP::deg << " " << events << " "
+			<< lastOutput << G4endl;
+	}
+
+	projectionSuffix.clear();
+	EventSeeding::SetEventOffset(offset);
+	detector->SetPhantomAngle(angle0);
+}
+
+void
+RunAction::setConfiguration(const G4String& tag)
+{
+	configurationTag = tag;
+	G4cout << "Configuration: " << (tag.empty() ? G4String("none") : tag)
+		<< G4endl;
+}
+
+void
+RunAction::runShard( G4int index, G4int count, G4int totalEvents,
+	G4long seed)
+{
+	if (!IsMaster())
+		return;
+
+	ShardManifest manifest( seed, index, count, totalEvents);
+	if (!manifest.valid()) {
+		G4cerr << "Wrong shard " << index << " of " << count << G4endl;
+		return;
+	}
+
+	delete shard;
+	shard = new ShardManifest(manifest);
+
+	// unique output and checkpoint files of the shard, kept for
+	// the following runs, e.g. /checkpoint/resume of the shard
+	std::ostringstream suffix;
+	suffix << '.' << index;
+	shardSuffix = suffix.str();
+
+	// the workers are seeded by the master engine
+	long seeds[3] = { 0, 0, 0 };
+	shard->seeds(seeds);
+	CLHEP::HepRandom::setTheSeeds(seeds);
+
+	// with the per event seeding the events are the same as of the whole
+	// campaign in one run, whatever the number of shards
+	EventSeeding::SetRunSeed(seed);
+	EventSeeding::SetEventOffset(shard->first);
+
+	G4cout << "Shard " << index << " of " << count << ": "
+		<< shard->events << " events from " << shard->first << G4endl;
+
+	G4RunManager::GetRunManager()->BeamOn(shard->events);
+}
+
 } // namespace CarbonIonRadiography
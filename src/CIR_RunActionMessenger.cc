@@ -0,0 +1,358 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4UIdirectory.hh>
+#include <G4UIcmdWithAnInteger.hh>
+#include <G4UIcmdWithAString.hh>
+#include <G4UIcmdWithABool.hh>
+#include <G4UIcmdWithADouble.hh>
+#include <G4UIcommand.hh>
+#include <G4UIparameter.hh>
+#include <G4SystemOfUnits.hh>
+
+#include <sstream>
+
+#include "CIR_EventSeeding.hh"
+#include "CIR_ConvergenceMonitor.hh"
+#include "CIR_PhaseSpace.hh"
+#include "CIR_RunAction.hh"
+#include "CIR_RunActionMessenger.hh"
+
+namespace CarbonIonRadiography {
+
+RunActionMessenger::RunActionMessenger(RunAction* run)
+	:
+	run_action(run),
+	checkpoint_dir(0),
+	interval_cmd(0),
+	file_cmd(0),
+	resume_cmd(0),
+	campaign_dir(0),
+	shard_cmd(0),
+	configuration_cmd(0),
+	ct_cmd(0),
+	seeding_dir(0),
+	event_seeding_cmd(0),
+	seed_cmd(0),
+	convergence_dir(0),
+	target_cmd(0),
+	update_interval_cmd(0),
+	min_entries_cmd(0),
+	region_cmd(0),
+	phase_space_cmd(0)
+{
+	// Checkpoint directory
+	checkpoint_dir = new G4UIdirectory("/checkpoint/");
+	checkpoint_dir->SetGuidance("Commands to checkpoint and resume long runs");
+
+	// Checkpoint interval
+	interval_cmd = new G4UIcmdWithAnInteger(
+		"/checkpoint/interval", this);
+
+	interval_cmd->SetGuidance("Number of events of a worker thread between");
+	interval_cmd->SetGuidance("two checkpoints, 0 -- no checkpoints.");
+	interval_cmd->SetParameterName( "CheckpointInterval", false);
+	interval_cmd->SetRange("CheckpointInterval>=0");
+	interval_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+	// Checkpoint files prefix
+	file_cmd = new G4UIcmdWithAString(
+		"/checkpoint/file", this);
+
+	file_cmd->SetGuidance("Prefix of the checkpoint files.");
+	file_cmd->SetParameterName( "CheckpointFile", false);
+	file_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+
+	// Resume
+	resume_cmd = new G4UIcmdWithAnInteger(
+		"/checkpoint/resume", this);
+
+	resume_cmd->SetGuidance("Load the checkpoint files and run the events");
+	resume_cmd->SetGuidance("which remain to the total number of events;");
+	resume_cmd->SetGuidance("with /seeding/event the event IDs missing from");
+	resume_cmd->SetGuidance("the checkpoint.");
+	resume_cmd->SetParameterName( "TotalEvents", false);
+	resume_cmd->SetRange("TotalEvents>0");
+	resume_cmd->AvailableForStates(G4State_Idle);
+	resume_cmd->SetToBeBroadcasted(false);
+
+	// Campaign directory
+	campaign_dir = new G4UIdirectory("/campaign/");
+	campaign_dir->SetGuidance("Commands to split a campaign into shards and");
+	campaign_dir->SetGuidance("to run several configurations in one process");
+
+	// Shard run
+	shard_cmd = new G4UIcommand( "/campaign/shard", this);
+
+	shard_cmd->SetGuidance("Run one shard of the campaign of total events.");
+	shard_cmd->SetGuidance("The shard runs its range of events with seeds");
+	shard_cmd->SetGuidance("derived from the campaign seed and the index,");
+	shard_cmd->SetGuidance("the output goes to hits.<index>.dat or");
+	shard_cmd->SetGuidance("projection.<index>.dat and is described by");
+	shard_cmd->SetGuidance("shard.<index>.manifest for cir-merge.");
+
+	G4UIparameter* index_param = new G4UIparameter( "index", 'i', false);
+	index_param->SetParameterRange("index>=0");
+	shard_cmd->SetParameter(index_param);
+
+	G4UIparameter* count_param = new G4UIparameter( "count", 'i', false);
+	count_param->SetParameterRange("count>0");
+	shard_cmd->SetParameter(count_param);
+
+	G4UIparameter* total_param = new G4UIparameter( "total", 'i', false);
+	total_param->SetParameterRange("total>=0");
+	shard_cmd->SetParameter(total_param);
+
+	G4UIparameter* seed_param = new G4UIparameter( "seed", 'i', true);
+	seed_param->SetDefaultValue(1);
+	shard_cmd->SetParameter(seed_param);
+
+	shard_cmd->AvailableForStates(G4State_Idle);
+	shard_cmd->SetToBeBroadcasted(false);
+
+	// Configuration of the following runs
+	configuration_cmd = new G4UIcmdWithAString(
+		"/campaign/configuration", this);
+
+	configuration_cmd->SetGuidance("Tag of the output files of the following");
+	configuration_cmd->SetGuidance("runs (hits.<tag>.dat, ...), so the runs of");
+	configuration_cmd->SetGuidance("several phantoms or thresholds in one process");
+	configuration_cmd->SetGuidance("keep their outputs. \"none\" -- no tag.");
+	configuration_cmd->SetParameterName( "Configuration", false);
+	configuration_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	configuration_cmd->SetToBeBroadcasted(false);
+
+	// CT acquisition
+	ct_cmd = new G4UIcommand( "/campaign/ct", this);
+
+	ct_cmd->SetGuidance("Run the events of every projection of the CT");
+	ct_cmd->SetGuidance("acquisition with the phantom rotated between the");
+	ct_cmd->SetGuidance("runs by span / projections (deg) from the start");
+	ct_cmd->SetGuidance("angle. The outputs are tagged with the projection");
+	ct_cmd->SetGuidance("(hits.p<index>.dat, ...) and listed with their");
+	ct_cmd->SetGuidance("angles in ct.manifest.");
+
+	G4UIparameter* projections_param = new G4UIparameter( "projections", 'i',
+		false);
+	projections_param->SetParameterRange("projections>0");
+	ct_cmd->SetParameter(projections_param);
+
+	G4UIparameter* events_param = new G4UIparameter( "events", 'i', false);
+	events_param->SetParameterRange("events>=0");
+	ct_cmd->SetParameter(events_param);
+
+	G4UIparameter* span_param = new G4UIparameter( "span", 'd', true);
+	span_param->SetDefaultValue(360.0);
+	ct_cmd->SetParameter(span_param);
+
+	G4UIparameter* start_param = new G4UIparameter( "start", 'd', true);
+	start_param->SetDefaultValue(0.0);
+	ct_cmd->SetParameter(start_param);
+
+	ct_cmd->AvailableForStates(G4State_Idle);
+	ct_cmd->SetToBeBroadcasted(false);
+
+	// Seeding directory
+	seeding_dir = new G4UIdirectory("/seeding/");
+	seeding_dir->SetGuidance("Commands to select the seeding of events");
+
+	// Per event seeding
+	event_seeding_cmd = new G4UIcmdWithABool(
+		"/seeding/event", this);
+
+	event_seeding_cmd->SetGuidance("Reseed every event from the run seed and");
+	event_seeding_cmd->SetGuidance("the event ID, so the events don't depend");
+	event_seeding_cmd->SetGuidance("on the number of threads. The events are");
+	event_seeding_cmd->SetGuidance("saved in the order of IDs, and the IDs");
+	event_seeding_cmd->SetGuidance("to \"events.dat\".");
+	event_seeding_cmd->SetParameterName( "EventSeeding", true);
+	event_seeding_cmd->SetDefaultValue(true);
+	event_seeding_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	event_seeding_cmd->SetToBeBroadcasted(false);
+
+	// Run seed
+	seed_cmd = new G4UIcmdWithAnInteger(
+		"/seeding/seed", this);
+
+	seed_cmd->SetGuidance("Run seed of the per event seeding,");
+	seed_cmd->SetGuidance("/campaign/shard uses the campaign seed.");
+	seed_cmd->SetParameterName( "RunSeed", false);
+	seed_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	seed_cmd->SetToBeBroadcasted(false);
+
+	// Convergence directory
+	convergence_dir = new G4UIdirectory("/convergence/");
+	convergence_dir->SetGuidance("Commands to end the runs on the statistical");
+	convergence_dir->SetGuidance("uncertainty of the image (projection mode)");
+
+	// Target uncertainty
+	target_cmd = new G4UIcmdWithADouble(
+		"/convergence/target", this);
+
+	target_cmd->SetGuidance("Stop the run when the standard error of the mean");
+	target_cmd->SetGuidance("stopping position (calorimeter slices) is under");
+	target_cmd->SetGuidance("the target in every pixel of the region, every");
+	target_cmd->SetGuidance("pixel of the region with tracks needs at least");
+	target_cmd->SetGuidance("/convergence/minEntries of them. Without a region");
+	target_cmd->SetGuidance("the beam tails (under 10% of the maximal fluence)");
+	target_cmd->SetGuidance("are skipped. /run/beamOn events is the cap,");
+	target_cmd->SetGuidance("0 -- off.");
+	target_cmd->SetParameterName( "ConvergenceTarget", false);
+	target_cmd->SetRange("ConvergenceTarget>=0.");
+	target_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	target_cmd->SetToBeBroadcasted(false);
+
+	// Update interval
+	update_interval_cmd = new G4UIcmdWithAnInteger(
+		"/convergence/interval", this);
+
+	update_interval_cmd->SetGuidance("Number of events of a worker thread");
+	update_interval_cmd->SetGuidance("between the checks of the uncertainty.");
+	update_interval_cmd->SetParameterName( "ConvergenceInterval", false);
+	update_interval_cmd->SetRange("ConvergenceInterval>0");
+	update_interval_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	update_interval_cmd->SetToBeBroadcasted(false);
+
+	// Minimal tracks of a pixel
+	min_entries_cmd = new G4UIcmdWithAnInteger(
+		"/convergence/minEntries", this);
+
+	min_entries_cmd->SetGuidance("Tracks of a pixel of the region needed");
+	min_entries_cmd->SetGuidance("to estimate its uncertainty, the run goes on");
+	min_entries_cmd->SetGuidance("while a pixel with tracks has fewer of them.");
+	min_entries_cmd->SetParameterName( "ConvergenceMinEntries", false);
+	min_entries_cmd->SetRange("ConvergenceMinEntries>=2");
+	min_entries_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	min_entries_cmd->SetToBeBroadcasted(false);
+
+	// Region of interest
+	region_cmd = new G4UIcommand( "/convergence/region", this);
+
+	region_cmd->SetGuidance("Region of interest of the image in mm,");
+	region_cmd->SetGuidance("an empty region -- the whole image.");
+
+	const char* region_names[4] = { "xMin", "xMax", "yMin", "yMax" };
+	for ( G4int i = 0; i < 4; ++i)
+		region_cmd->SetParameter(new G4UIparameter( region_names[i], 'd',
+			false));
+
+	region_cmd->AvailableForStates( G4State_PreInit, G4State_Idle);
+	region_cmd->SetToBeBroadcasted(false);
+
+	// Phase space source of the primary generators (/beam/ directory of
+	// PrimaryGeneratorMessenger), the master maps the file between runs
+	phase_space_cmd = new G4UIcmdWithAString(
+		"/beam/phaseSpace", this);
+
+	phase_space_cmd->SetGuidance("Read primaries from the phase space file");
+	phase_space_cmd->SetGuidance("mapped into memory and shared by threads,");
+	phase_space_cmd->SetGuidance("\"none\" -- the default carbon ion beam.");
+	phase_space_cmd->SetParameterName( "PhaseSpaceFile", false);
+	phase_space_cmd->AvailableForStates(G4State_Idle);
+	phase_space_cmd->SetToBeBroadcasted(false);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+RunActionMessenger::~RunActionMessenger()
+{
+	delete interval_cmd;
+	delete file_cmd;
+	delete resume_cmd;
+	delete checkpoint_dir;
+	delete shard_cmd;
+	delete configuration_cmd;
+	delete ct_cmd;
+	delete campaign_dir;
+	delete event_seeding_cmd;
+	delete seed_cmd;
+	delete seeding_dir;
+	delete target_cmd;
+	delete update_interval_cmd;
+	delete min_entries_cmd;
+	delete region_cmd;
+	delete convergence_dir;
+	delete phase_space_cmd;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+RunActionMessenger::SetNewValue( G4UIcommand* command, G4String newValue)
+{
+	if (command == interval_cmd) {
+		G4int interval = G4UIcmdWithAnInteger::GetNewIntValue(newValue);
+		run_action->setCheckpointInterval(interval);
+	}
+	else if (command == file_cmd) {
+		run_action->setCheckpointPrefix(newValue);
+	}
+	else if (command == resume_cmd) {
+		G4int events = G4UIcmdWithAnInteger::GetNewIntValue(newValue);
+		run_action->resume(events);
+	}
+	else if (command == shard_cmd) {
+		G4int index = 0, count = 1, total = 0;
+		G4long seed = 1;
+		std::istringstream values(newValue);
+		values >> index >> count >> total >> seed;
+		run_action->runShard( index, count, total, seed);
+	}
+	else if (command == configuration_cmd) {
+		run_action->setConfiguration( (newValue == "none") ? G4String() : newValue);
+	}
+	else if (command == ct_cmd) {
+		G4int projections = 1, events = 0;
+		G4double span = 360.0, start = 0.0;
+		std::istringstream values(newValue);
+		values >> projections >> events >> span >> start;
+		run_action->runTomography( projections, events, span * CLHEP::deg,
+			start * CLHEP::deg);
+	}
+	else if (command == event_seeding_cmd) {
+		G4bool flag = G4UIcmdWithABool::GetNewBoolValue(newValue);
+		EventSeeding::SetEnabled(flag);
+	}
+	else if (command == seed_cmd) {
+		G4int seed = G4UIcmdWithAnInteger::GetNewIntValue(newValue);
+		EventSeeding::SetRunSeed(seed);
+	}
+	else if (command == target_cmd) {
+		ConvergenceMonitor::Instance()->SetTarget(
+			G4UIcmdWithADouble::GetNewDoubleValue(newValue));
+	}
+	else if (command == update_interval_cmd) {
+		ConvergenceMonitor::Instance()->SetInterval(
+			G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+	}
+	else if (command == min_entries_cmd) {
+		ConvergenceMonitor::Instance()->SetMinEntries(
+			G4UIcmdWithAnInteger::GetNewIntValue(newValue));
+	}
+	else if (command == phase_space_cmd) {
+		PhaseSpace::Open( newValue == "none" ? G4String() : newValue);
+	}
+	else if (command == region_cmd) {
+		G4double x0 = 0.0, x1 = 0.0, y0 = 0.0, y1 = 0.0;
+		std::istringstream values(newValue);
+		values >> x0 >> x1 >> y0 >> y1;
+		ConvergenceMonitor::Instance()->SetRegion( x0 * CLHEP::mm,
+			x1 * CLHEP::mm, y0 * CLHEP::mm, y1 * CLHEP::mm);
+	}
+}
+
+} // namespace CarbonIonRadiography
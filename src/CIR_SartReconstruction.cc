@@ -0,0 +1,452 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4ios.hh>
+
+#include <TH3.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+
+#include "CIR_Parallel.hh"
+#include "CIR_BoundedQueue.hh"
+#include "CIR_AlignedArray.hh"
+#include "CIR_MostLikelyPath.hh"
+#include "CIR_SartReconstruction.hh"
+
+namespace {
+
+// histories of a block of the matrix file
+const size_t matrix_block = 1 << 16;
+
+// ions of a block of the most likely paths, one vectorized loop per step
+const size_t path_block = 256;
+
+// blocks read ahead of the projection
+const size_t read_ahead = 2;
+
+G4int
+common_divisor( G4int a, G4int b)
+{
+	while (b) {
+		G4int r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+// order of the subsets with distant consecutive projections: steps of
+// the golden ratio of the subsets number, coprime with it
+std::vector<G4int>
+subset_order(G4int subsets)
+{
+	G4int step = std::max( 1, G4int(0.618 * subsets + 0.5));
+	while (common_divisor( step, subsets) != 1)
+		++step;
+
+	std::vector<G4int> order(subsets);
+	for ( G4int i = 0; i < subsets; ++i)
+		order[i] = G4int((size_t(i) * step) % subsets);
+	return order;
+}
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+// CSR rows: voxels and path lengths (mm) of row i are the entries
+// row[i] ... row[i + 1] - 1; float values halve the matrix file
+struct SartReconstruction::MatrixBlock {
+	MatrixBlock() : last(false), value_sum(0.0), length_sum(0.0), row(1, 0) {}
+
+	G4bool last; // last block of the subset
+	G4double value_sum;
+	G4double length_sum;
+	std::vector<uint32_t> row;
+	std::vector<uint32_t> voxel;
+	std::vector<float> length;
+	std::vector<float> value;
+
+	size_t rows() const { return value.size(); }
+
+	void write(std::ostream& file) const;
+	G4bool read(std::istream& file);
+};
+
+void
+SartReconstruction::MatrixBlock::write(std::ostream& file) const
+{
+	uint32_t n[2] = { uint32_t(value.size()), uint32_t(voxel.size()) };
+	file.write( (const char *)n, sizeof(n));
+	file.write( (const char *)&row[0], row.size() * sizeof(uint32_t));
+	if (n[1]) {
+		file.write( (const char *)&voxel[0], n[1] * sizeof(uint32_t));
+		file.write( (const char *)&length[0], n[1] * sizeof(float));
+	}
+	if (n[0])
+		file.write( (const char *)&value[0], n[0] * sizeof(float));
+}
+
+G4bool
+SartReconstruction::MatrixBlock::read(std::istream& file)
+{
+	uint32_t n[2] = { 0, 0 };
+	if (!file.read( (char *)n, sizeof(n)))
+		return false;
+
+	row.resize(n[0] + 1);
+	voxel.resize(n[1]);
+	length.resize(n[1]);
+	value.resize(n[0]);
+	file.read( (char *)&row[0], row.size() * sizeof(uint32_t));
+	if (n[1]) {
+		file.read( (char *)&voxel[0], n[1] * sizeof(uint32_t));
+		file.read( (char *)&length[0], n[1] * sizeof(float));
+	}
+	if (n[0])
+		file.read( (char *)&value[0], n[0] * sizeof(float));
+	return static_cast<G4bool>(file);
+}
+
+SartReconstruction::SartReconstruction( const HistogramAxis& u,
+	const HistogramAxis& v, const MostLikelyPath& path, const char* matrix)
+	:
+	u_(u),
+	v_(v),
+	path_(path),
+	axis_z_((path.z_in() + path.z_out()) / 2.0),
+	threads_(0),
+	relaxation_(0.5),
+	matrix_name_(matrix),
+	matrix_( matrix, std::ios::binary | std::ios::trunc),
+	cos_(1.0),
+	sin_(0.0),
+	histories_(0),
+	value_sum_(0.0),
+	length_sum_(0.0)
+{
+	if (!matrix_)
+		G4cerr << "Can't create SART matrix file " << matrix_name_ << G4endl;
+}
+
+SartReconstruction::~SartReconstruction()
+{
+	matrix_.close();
+	std::remove(matrix_name_.c_str());
+}
+
+void
+SartReconstruction::begin_projection(G4double angle)
+{
+	end_projection();
+
+	blocks_.push_back(std::vector<std::streamoff>());
+	cos_ = std::cos(angle);
+	sin_ = std::sin(angle);
+}
+
+void
+SartReconstruction::add_histories( const MainTracksVector& main,
+	const FullTracksVector& full, const std::vector<G4double>& values)
+{
+	if (blocks_.empty())
+		begin_projection(0.0);
+
+	const G4int last = G4int(values.size()) - 1;
+	const size_t n = std::min( main.size(), full.size());
+	for ( size_t i = 0; i < n; ++i) {
+		G4double value = values[std::min( std::max( full[i].second + 1, 0),
+			last)];
+		if (value < 0.0)
+			continue;
+
+		G4double x0, tx0, x1, tx1, y0, ty0, y1, ty1;
+		path_.states( true, main[i].first, full[i].first.first,
+			x0, tx0, x1, tx1);
+		path_.states( false, main[i].second, full[i].first.second,
+			y0, ty0, y1, ty1);
+
+		pending_.x0.push_back(x0);
+		pending_.tx0.push_back(tx0);
+		pending_.x1.push_back(x1);
+		pending_.tx1.push_back(tx1);
+		pending_.y0.push_back(y0);
+		pending_.ty0.push_back(ty0);
+		pending_.y1.push_back(y1);
+		pending_.ty1.push_back(ty1);
+		pending_.value.push_back(value);
+
+		if (pending_.value.size() >= matrix_block)
+			write_block();
+	}
+}
+
+void
+SartReconstruction::end_projection()
+{
+	if (!pending_.value.empty())
+		write_block();
+}
+
+void
+SartReconstruction::build_rows( size_t begin, size_t end,
+	MatrixBlock& rows) const
+{
+	const G4int steps = path_.steps();
+	const G4double step = path_.step_length() / 1000.0; // mm
+	const G4int n = u_.bins;
+	const G4double u_scale = u_.scale();
+	const G4double v_scale = v_.scale();
+
+	AlignedArray<G4double> px( steps * path_block), py( steps * path_block);
+	std::vector<G4double> depth(steps);
+	for ( G4int k = 0; k < steps; ++k)
+		depth[k] = path_.depth(k) - axis_z_;
+
+	for ( size_t first = begin; first < end; first += path_block) {
+		const size_t m = std::min( first + path_block, end) - first;
+		for ( G4int k = 0; k < steps; ++k) {
+			path_.estimate( k, &pending_.x0[first], &pending_.tx0[first],
+				&pending_.x1[first], &pending_.tx1[first], m, &px[k * path_block]);
+			path_.estimate( k, &pending_.y0[first], &pending_.ty0[first],
+				&pending_.y1[first], &pending_.ty1[first], m, &py[k * path_block]);
+		}
+
+		for ( size_t j = 0; j < m; ++j) {
+			const size_t row_begin = rows.voxel.size();
+			G4int previous = -1;
+			for ( G4int k = 0; k < steps; ++k) {
+				// laboratory -> phantom frame rotated by the angle
+				G4double x = px[k * path_block + j];
+				G4double ox = x * cos_ - depth[k] * sin_;
+				G4double oz = x * sin_ + depth[k] * cos_;
+
+				G4int ix = u_.find_bin( ox, u_scale) - 1;
+				G4int iz = u_.find_bin( oz, u_scale) - 1;
+				G4int iy = v_.find_bin( py[k * path_block + j], v_scale) - 1;
+				if (ix < 0 || ix >= n || iz < 0 || iz >= n || iy < 0 || iy >= v_.bins)
+					continue;
+
+				// steps in the same voxel are one entry
+				G4int voxel = (iy * n + iz) * n + ix;
+				if (voxel == previous)
+					rows.length.back() += step;
+				else {
+					rows.voxel.push_back(voxel);
+					rows.length.push_back(step);
+					previous = voxel;
+				}
+			}
+
+			if (rows.voxel.size() == row_begin)
+				continue;
+
+			G4double value = pending_.value[first + j];
+			G4double length = 0.0;
+			for ( size_t e = row_begin; e < rows.voxel.size(); ++e)
+				length += rows.length[e];
+			rows.row.push_back(rows.voxel.size());
+			rows.value.push_back(value);
+			rows.value_sum += value;
+			rows.length_sum += length;
+		}
+	}
+}
+
+void
+SartReconstruction::write_block()
+{
+	const size_t n = pending_.value.size();
+	G4int threads = parallel_threads( n, threads_);
+	std::vector<MatrixBlock> parts(threads);
+
+	parallel_for( n, threads,
+		[&]( G4int t, size_t begin, size_t end) {
+			build_rows( begin, end, parts[t]);
+		});
+
+	// rows of the threads in the thread order
+	MatrixBlock& block = parts[0];
+	for ( G4int t = 1; t < threads; ++t) {
+		const MatrixBlock& part = parts[t];
+		const uint32_t offset = block.voxel.size();
+		for ( size_t i = 1; i < part.row.size(); ++i)
+			block.row.push_back(offset + part.row[i]);
+		block.voxel.insert( block.voxel.end(), part.voxel.begin(),
+			part.voxel.end());
+		block.length.insert( block.length.end(), part.length.begin(),
+			part.length.end());
+		block.value.insert( block.value.end(), part.value.begin(),
+			part.value.end());
+		block.value_sum += part.value_sum;
+		block.length_sum += part.length_sum;
+	}
+
+	if (block.rows()) {
+		blocks_.back().push_back(matrix_.tellp());
+		block.write(matrix_);
+		histories_ += block.rows();
+		value_sum_ += block.value_sum;
+		length_sum_ += block.length_sum;
+	}
+
+	pending_ = PathStates();
+}
+
+void
+SartReconstruction::project( const MatrixBlock& block,
+	const std::vector<G4double>& volume,
+	std::vector< std::vector<G4double> >& delta,
+	std::vector< std::vector<G4double> >& weight) const
+{
+	parallel_for( block.rows(), G4int(delta.size()),
+		[&]( G4int t, size_t begin, size_t end) {
+			G4double* d = &delta[t][0];
+			G4double* w = &weight[t][0];
+			for ( size_t i = begin; i < end; ++i) {
+				const uint32_t first = block.row[i];
+				const uint32_t last = block.row[i + 1];
+
+				G4double sum = 0.0, length = 0.0;
+				for ( uint32_t e = first; e < last; ++e) {
+					sum += block.length[e] * volume[block.voxel[e]];
+					length += block.length[e];
+				}
+
+				// residual per path length back along the row
+				G4double residual = (block.value[i] - sum) / length;
+				for ( uint32_t e = first; e < last; ++e) {
+					d[block.voxel[e]] += block.length[e] * residual;
+					w[block.voxel[e]] += block.length[e];
+				}
+			}
+		});
+}
+
+void
+SartReconstruction::update( std::vector<G4double>& volume,
+	std::vector< std::vector<G4double> >& delta,
+	std::vector< std::vector<G4double> >& weight) const
+{
+	const size_t threads = delta.size();
+	parallel_for( volume.size(), G4int(threads),
+		[&]( G4int, size_t begin, size_t end) {
+			for ( size_t j = begin; j < end; ++j) {
+				G4double d = 0.0, w = 0.0;
+				for ( size_t t = 0; t < threads; ++t) {
+					d += delta[t][j];
+					w += weight[t][j];
+					delta[t][j] = 0.0;
+					weight[t][j] = 0.0;
+				}
+				if (w > 0.0)
+					volume[j] = std::max( volume[j] + relaxation_ * d / w, 0.0);
+			}
+		});
+}
+
+G4bool
+SartReconstruction::reconstruct( G4int iterations,
+	std::vector<G4double>& volume)
+{
+	end_projection();
+	matrix_.flush();
+	if (!matrix_) {
+		G4cerr << "Can't write SART matrix file " << matrix_name_ << G4endl;
+		return false;
+	}
+
+	const size_t voxels = size_t(v_.bins) * u_.bins * u_.bins;
+	volume.assign( voxels, length_sum_ > 0.0 ? value_sum_ / length_sum_ : 0.0);
+
+	const G4int threads = hardware_threads(threads_);
+	std::vector< std::vector<G4double> > delta( threads,
+		std::vector<G4double>( voxels, 0.0));
+	std::vector< std::vector<G4double> > weight(delta);
+
+	const std::vector<G4int> order = subset_order(subsets());
+	for ( G4int iteration = 0; iteration < iterations; ++iteration) {
+		std::ifstream file( matrix_name_.c_str(), std::ios::binary);
+		if (!file) {
+			G4cerr << "Can't open SART matrix file " << matrix_name_ << G4endl;
+			return false;
+		}
+
+		// the reader thread streams the blocks of the subsets in order
+		BoundedQueue<MatrixBlock> queue(read_ahead);
+		G4bool read = true;
+		std::thread reader( [&]() {
+			for ( size_t s = 0; s < order.size() && read; ++s) {
+				const std::vector<std::streamoff>& offsets = blocks_[order[s]];
+				for ( size_t b = 0; b < offsets.size(); ++b) {
+					MatrixBlock block;
+					file.seekg(offsets[b]);
+					if (!block.read(file)) {
+						read = false;
+						break;
+					}
+					block.last = (b + 1 == offsets.size());
+					queue.push(std::move(block));
+				}
+			}
+			queue.close();
+		});
+
+		MatrixBlock block;
+		while (queue.pop(block)) {
+			project( block, volume, delta, weight);
+			if (block.last)
+				update( volume, delta, weight);
+		}
+		reader.join();
+
+		if (!read) {
+			G4cerr << "Can't read SART matrix file " << matrix_name_ << G4endl;
+			return false;
+		}
+		G4cout << "SART iteration " << iteration + 1 << " of " << iterations
+			<< G4endl;
+	}
+	return true;
+}
+
+TH3D*
+SartReconstruction::create_volume( const char* name, const char* title,
+	const std::vector<G4double>& volume) const
+{
+	// x, slice (y) and z axes of the volume, um
+	const G4int n = u_.bins;
+	TH3D* hist = new TH3D( name, title, n, u_.min, u_.max,
+		v_.bins, v_.min, v_.max, n, u_.min, u_.max);
+
+	for ( G4int s = 0; s < v_.bins; ++s) {
+		for ( G4int z = 0; z < n; ++z) {
+			for ( G4int x = 0; x < n; ++x)
+				hist->SetBinContent( x + 1, s + 1, z + 1,
+					volume[(size_t(s) * n + z) * n + x]);
+		}
+	}
+	return hist;
+}
+
+} // namespace CarbonIonRadiography
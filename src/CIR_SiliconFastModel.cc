@@ -0,0 +1,262 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4SystemOfUnits.hh>
+#include <G4PhysicalConstants.hh>
+#include <G4FastTrack.hh>
+#include <G4FastStep.hh>
+#include <G4Track.hh>
+#include <G4DynamicParticle.hh>
+#include <G4Material.hh>
+#include <G4ParticleDefinition.hh>
+#include <G4EmCalculator.hh>
+#include <G4EventManager.hh>
+#include <G4VSolid.hh>
+#include <Randomize.hh>
+
+#include <algorithm>
+#include <cmath>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_EventAction.hh"
+#include "CIR_SiliconFastModel.hh"
+
+namespace {
+
+// energy grid of the stopping power tables per nucleon
+const G4double min_energy_per_nucleon = 0.1 * CLHEP::MeV;
+const G4double max_energy_per_nucleon = 1.0 * CLHEP::GeV;
+const G4int stopping_table_bins = 256;
+
+// Landau (kappa below) and Gaussian (kappa above) energy loss
+const G4double gaussian_kappa = 10.0;
+const G4int landau_max_tries = 100;
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+/////////////////////////////////////////////////////////////////////////////
+G4double
+SiliconFastModel::StoppingTable::DEDX(G4double kinEnergy) const
+{
+	if (kinEnergy <= energy.front())
+		return dedx.front();
+	if (kinEnergy >= energy.back())
+		return dedx.back();
+
+	size_t i = std::upper_bound( energy.begin(), energy.end(), kinEnergy)
+		- energy.begin();
+	G4double w = (kinEnergy - energy[i - 1]) / (energy[i] - energy[i - 1]);
+	return dedx[i - 1] + w * (dedx[i] - dedx[i - 1]);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+SiliconFastModel::SiliconFastModel( const G4String& name, G4Region* envelope,
+	G4int pos)
+	:
+	G4VFastSimulationModel( name, envelope),
+	plane(pos),
+	halfSize(0.5 * GeometryConfig::instance().silicon_size()),
+	pitch(GeometryConfig::instance().strip_pitch()),
+	strips(GeometryConfig::instance().silicon_strips())
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+SiliconFastModel::~SiliconFastModel()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+G4bool
+SiliconFastModel::IsApplicable(const G4ParticleDefinition& particle)
+{
+	// protons and ions
+	return particle.GetPDGCharge() > 0.0 && particle.GetBaryonNumber() > 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+G4bool
+SiliconFastModel::ModelTrigger(const G4FastTrack&)
+{
+	const EventAction* eventAction = static_cast<const EventAction*>(
+		G4EventManager::GetEventManager()->GetUserEventAction());
+	return eventAction && eventAction->siliconFastSimulation();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+const SiliconFastModel::StoppingTable&
+SiliconFastModel::Table( const G4ParticleDefinition* particle,
+	const G4Material* material)
+{
+	TableKey key( particle, material);
+	std::map< TableKey, StoppingTable>::iterator it = tables.find(key);
+	if (it != tables.end())
+		return it->second;
+
+	StoppingTable& table = tables[key];
+	table.energy.resize(stopping_table_bins);
+	table.dedx.resize(stopping_table_bins);
+
+	G4int nucleons = particle->GetBaryonNumber();
+	G4double emin = min_energy_per_nucleon * nucleons;
+	G4double emax = max_energy_per_nucleon * nucleons;
+	G4double ratio = std::pow( emax / emin, 1.0 / (stopping_table_bins - 1));
+
+	G4EmCalculator calculator;
+	G4double energy = emin;
+	for ( G4int i = 0; i < stopping_table_bins; ++i, energy *= ratio) {
+		table.energy[i] = energy;
+		table.dedx[i] = calculator.ComputeTotalDEDX( energy, particle, material);
+	}
+	return table;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+G4double
+SiliconFastModel::SampleEnergyLoss( G4double meanLoss, G4double xi,
+	G4double tmax, G4double beta2) const
+{
+	G4double kappa = xi / tmax;
+	G4double loss = 0.0;
+
+	if (kappa >= gaussian_kappa) {
+		G4double sigma = std::sqrt( xi * tmax * (1.0 - 0.5 * beta2));
+		loss = meanLoss + sigma * G4RandGauss::shoot();
+	}
+	else {
+		// Landau distribution truncated to keep the mean loss
+		G4double lambdaMean = -0.422784 - beta2 - std::log(kappa);
+		G4double lambdaMax = 0.60715 + 1.1934 * lambdaMean
+			+ (0.67794 + 0.052382 * lambdaMean)
+			* std::exp(0.94753 + 0.74442 * lambdaMean);
+
+		G4double lambda = lambdaMax;
+		for ( G4int i = 0; i < landau_max_tries; ++i) {
+			G4double sample = CLHEP::RandLandau::shoot();
+			if (sample <= lambdaMax) {
+				lambda = sample;
+				break;
+			}
+		}
+		loss = meanLoss + xi * (lambda - lambdaMean);
+	}
+	return std::max( loss, 0.0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+SiliconFastModel::DepositEnergy( G4double y0, G4double y1,
+	G4double energy) const
+{
+	EventAction* eventAction = static_cast<EventAction*>(
+		G4EventManager::GetEventManager()->GetUserEventAction());
+
+	G4double low = std::min( y0, y1) + halfSize;
+	G4double high = std::max( y0, y1) + halfSize;
+	G4int first = std::max( 0, G4int(std::floor(low / pitch)));
+	G4int last = std::min( strips - 1, G4int(std::floor(high / pitch)));
+
+	// normal incidence, one strip
+	if (first >= last || high - low <= 0.0) {
+		eventAction->addSiliconEnergy( plane, std::min( first, strips - 1),
+			energy);
+		return;
+	}
+
+	for ( G4int strip = first; strip <= last; ++strip) {
+		G4double begin = std::max( low, strip * pitch);
+		G4double end = std::min( high, (strip + 1) * pitch);
+		if (end > begin)
+			eventAction->addSiliconEnergy( plane, strip,
+				energy * (end - begin) / (high - low));
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+void
+SiliconFastModel::DoIt( const G4FastTrack& fastTrack, G4FastStep& fastStep)
+{
+	const G4Track* track = fastTrack.GetPrimaryTrack();
+	const G4DynamicParticle* particle = track->GetDynamicParticle();
+	const G4Material* material = track->GetMaterial();
+	const G4ThreeVector& position = fastTrack.GetPrimaryTrackLocalPosition();
+	const G4ThreeVector& direction = fastTrack.GetPrimaryTrackLocalDirection();
+	const G4VSolid* solid = fastTrack.GetEnvelopeSolid();
+
+	G4double path = solid->DistanceToOut( position, direction);
+	G4double kinEnergy = track->GetKineticEnergy();
+	G4double mass = particle->GetMass();
+	G4double charge = particle->GetCharge() / CLHEP::eplus;
+
+	G4double gamma = 1.0 + kinEnergy / mass;
+	G4double beta2 = 1.0 - 1.0 / (gamma * gamma);
+	G4double ratio = CLHEP::electron_mass_c2 / mass;
+	G4double tmax = 2.0 * CLHEP::electron_mass_c2 * beta2 * gamma * gamma
+		/ (1.0 + 2.0 * gamma * ratio + ratio * ratio);
+	G4double xi = CLHEP::twopi_mc2_rcl2 * material->GetElectronDensity()
+		* charge * charge * path / beta2;
+
+	const StoppingTable& table = Table( particle->GetDefinition(), material);
+	G4double meanLoss = table.DEDX(kinEnergy) * path;
+	G4double loss = std::min( SampleEnergyLoss( meanLoss, xi, tmax, beta2),
+		kinEnergy);
+
+	G4ThreeVector exit = position + path * direction;
+	DepositEnergy( position.y(), exit.y(), loss);
+
+	fastStep.ProposePrimaryTrackPathLength(path);
+	fastStep.ProposePrimaryTrackFinalTime( track->GetGlobalTime()
+		+ path / (std::sqrt(beta2) * CLHEP::c_light));
+
+	if (loss >= kinEnergy) {
+		fastStep.KillPrimaryTrack();
+		return;
+	}
+
+	// Highland multiple scattering angle of the plane
+	G4double momentum = particle->GetTotalMomentum();
+	G4double thickness = path / material->GetRadlen();
+	G4double theta0 = 13.6 * CLHEP::MeV / (std::sqrt(beta2) * momentum)
+		* std::fabs(charge) * std::sqrt(thickness)
+		* (1.0 + 0.038 * std::log( thickness * charge * charge / beta2));
+
+	// correlated deflection and displacement in two orthogonal planes
+	G4ThreeVector u = direction.orthogonal().unit();
+	G4ThreeVector v = direction.cross(u);
+	G4double z1 = G4RandGauss::shoot(), z2 = G4RandGauss::shoot();
+	G4double z3 = G4RandGauss::shoot(), z4 = G4RandGauss::shoot();
+	G4double shift = path * theta0;
+
+	G4ThreeVector displaced = exit
+		+ shift * (z1 / std::sqrt(12.0) + z2 / 2.0) * u
+		+ shift * (z3 / std::sqrt(12.0) + z4 / 2.0) * v;
+	if (solid->Inside(displaced) != kOutside)
+		exit = displaced;
+
+	G4ThreeVector deflected = (direction + theta0 * z2 * u
+		+ theta0 * z4 * v).unit();
+
+	fastStep.ProposePrimaryTrackFinalPosition( exit, true);
+	fastStep.ProposePrimaryTrackFinalMomentumDirection( deflected, true);
+	fastStep.ProposePrimaryTrackFinalKineticEnergy(kinEnergy - loss);
+}
+
+} // namespace CarbonIonRadiography
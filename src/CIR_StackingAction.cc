@@ -28,11 +28,17 @@
 #include <G4Alpha.hh>
 #include <G4GenericIon.hh>
 
+#include <algorithm>
+
+#include "CIR_EventAction.hh"
 #include "CIR_StackingAction.hh"
 
 namespace CarbonIonRadiography {
 
-StackingAction::StackingAction()
+StackingAction::StackingAction(EventAction* fEventAction)
+	:
+	G4UserStackingAction(),
+	eventAction(fEventAction)
 {
 }
 
@@ -45,6 +51,16 @@ StackingAction::ClassifyNewTrack(const G4Track* aTrack)
 {
 	G4ParticleDefinition* particleDef = aTrack->GetDefinition();
 
+	// cast the ray of the primary particle instead of the transport
+	if (aTrack->GetParentID() == 0 && eventAction->rayCastMode()) {
+		G4int nucleons = std::max( 1, particleDef->GetBaryonNumber());
+		RayRecord ray;
+		rayCaster.Cast( aTrack->GetPosition(), aTrack->GetMomentumDirection(),
+			aTrack->GetKineticEnergy() / nucleons, ray);
+		eventAction->setRay(ray);
+		return fKill;
+	}
+
 	// keep primary particle
 	if (aTrack->GetParentID() == 0)
 		return fUrgent;
@@ -19,6 +19,7 @@
 
 #include "CIR_GlobalStrings.hh"
 
+#include "CIR_GeometryConfig.hh"
 #include "CIR_StripGeometry.hh"
 
 namespace {
@@ -31,6 +32,19 @@ const G4String Division("Division");
 const G4String Sensitive("Sensitive");
 const G4String Detector("Detector");
 
+// default plane geometry, CIR_Defines.hh
+const CarbonIonRadiography::StripGeometry
+strip_geometry_[CIR_NUMBER_OF_SILICON_DETECTORS] = {
+	{  -52000., 180.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
+	{  -50000.,  90.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
+	{  298000., 180.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
+	{  300000.,  90.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
+	{ 1300000., 180.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
+	{ 1302000.,  90.0, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
+	{ 1320000., -10.5, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. },
+	{ 1322000.,  10.5, 0.0, 0.0, 0.0, 0.0, 300., 30000., 300, 200., 0. }
+};
+
 } // namespace
 
 namespace CarbonIonRadiography {
@@ -38,16 +52,17 @@ namespace CarbonIonRadiography {
 StripGeometryMap
 StripGeometry::create()
 {
+	const GeometryConfig& config = GeometryConfig::instance();
 	StripGeometryMap map;
-	
-	map[MSD_Y1] = StripGeometryPair( strip_geometry_[0], create(MSD_Y1));
-	map[MSD_X1] = StripGeometryPair( strip_geometry_[1], create(MSD_X1));
-	map[MSD_Y2] = StripGeometryPair( strip_geometry_[2], create(MSD_Y2));
-	map[MSD_X2] = StripGeometryPair( strip_geometry_[3], create(MSD_X2));
-	map[MSD_Y3] = StripGeometryPair( strip_geometry_[4], create(MSD_Y3));
-	map[MSD_X3] = StripGeometryPair( strip_geometry_[5], create(MSD_X3));
-	map[MSD__U] = StripGeometryPair( strip_geometry_[6], create(MSD__U));
-	map[MSD__V] = StripGeometryPair( strip_geometry_[7], create(MSD__V));
+
+	map[MSD_Y1] = StripGeometryPair( config.plane(MSD_Y1), create(MSD_Y1));
+	map[MSD_X1] = StripGeometryPair( config.plane(MSD_X1), create(MSD_X1));
+	map[MSD_Y2] = StripGeometryPair( config.plane(MSD_Y2), create(MSD_Y2));
+	map[MSD_X2] = StripGeometryPair( config.plane(MSD_X2), create(MSD_X2));
+	map[MSD_Y3] = StripGeometryPair( config.plane(MSD_Y3), create(MSD_Y3));
+	map[MSD_X3] = StripGeometryPair( config.plane(MSD_X3), create(MSD_X3));
+	map[MSD__U] = StripGeometryPair( config.plane(MSD__U), create(MSD__U));
+	map[MSD__V] = StripGeometryPair( config.plane(MSD__V), create(MSD__V));
 
 	return map;
 }
@@ -55,39 +70,17 @@ StripGeometry::create()
 const StripGeometry*
 StripGeometry::strip_geometry(StripGeometryType type)
 {
-	const StripGeometry* geom = 0;
+	G4int pos = index(type);
+	if (pos < 0) // error - no value
+		return 0;
 
-	switch (type) {
-	case MSD_Y1:
-		geom = &strip_geometry_[0];
-		break;
-	case MSD_X1:
-		geom = &strip_geometry_[1];
-		break;
-	case MSD_Y2:
-		geom = &strip_geometry_[2];
-		break;
-	case MSD_X2:
-		geom = &strip_geometry_[3];
-		break;
-	case MSD_Y3:
-		geom = &strip_geometry_[4];
-		break;
-	case MSD_X3:
-		geom = &strip_geometry_[5];
-		break;
-	case MSD__U:
-		geom = &strip_geometry_[6];
-		break;
-	case MSD__V:
-		geom = &strip_geometry_[7];
-		break;
-	case MSD_ER: // error - no value
-	default:
-		break;
-	}
+	return &GeometryConfig::instance().plane(pos);
+}
 
-	return geom;
+StripGeometry
+StripGeometry::default_geometry(G4int pos)
+{
+	return strip_geometry_[pos];
 }
 
 StripNamesMap
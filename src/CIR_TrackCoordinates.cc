@@ -23,23 +23,14 @@
 #include <numeric>
 
 #include "CIR_Constants.hh"
+#include "CIR_GeometryConfig.hh"
+#include "CIR_TrackFitter.hh"
 #include "CIR_TrackCoordinates.hh"
 
 namespace {
 
 const std::pair< G4bool, G4bool> pair_ok( true, true);
 
-// sigma^2 = pitch^2 / 12
-const G4double sigma_xy1 = CIR_SIZE_SILICON_STRIP / sqrt(12.0); // sigma on 1 module (Y1-X1 planes) in (um) 
-const G4double sigma_xy2 = 94.0; // sigma on 2 module (Y2-X2 planes) in (um) 
-const G4double sigma_xy3 = 1000.0; // sigma on 3 module (Y3-X3 planes) in (um) 
-
-void
-output_test(G4bool v)
-{
-	G4cout << v << " ";
-}
-
 } // namespace
 
 namespace CarbonIonRadiography {
@@ -65,10 +56,6 @@ TrackCoordinates::calculate_coordinates()
 		
 		HitsVector si_plane_hits = hits.numbers_2_hits(it->first);
 
-		G4cout << "Plane1: " << StripGeometry::index(it->first) << G4endl;
-		std::for_each( si_plane_hits.begin(), si_plane_hits.end(), output_test);
-		G4cout << G4endl;
-
 		G4int res = find_coordinate( it->first, si_plane_hits);
 		if (res == -1) {
 			; // Can't finding coordinates in silicon detector
@@ -297,62 +284,69 @@ TrackCoordinates::calculate_full_track(G4bool type)
 	Track& full_y = full_track.second;
 
 	G4double f[3] = {}; // x coord for "true", y for "false"
-	G4double z[3] = {}; // z coord
-	G4double w[3] = { 58., 94., 1000. }; // sigma
-	const StripGeometry* f1 = 0;
-	const StripGeometry* f2 = 0;
-	const StripGeometry* f3 = 0;
 
 	if (type) { // x coordinate (um)
-		f1 = StripGeometry::strip_geometry(MSD_X1);
-		f2 = StripGeometry::strip_geometry(MSD_X2);
-		f3 = StripGeometry::strip_geometry(MSD_X3);
 		f[0] = xy1.first / CLHEP::um;
 		f[1] = xy2.first / CLHEP::um;
 		f[2] = xy3.first / CLHEP::um;
 	}
 	else { // y coordinate (um)
-		f1 = StripGeometry::strip_geometry(MSD_Y1);
-		f2 = StripGeometry::strip_geometry(MSD_Y2);
-		f3 = StripGeometry::strip_geometry(MSD_Y3);
 		f[0] = xy1.second / CLHEP::um;
 		f[1] = xy2.second / CLHEP::um;
 		f[2] = xy3.second / CLHEP::um;
 	}
-	
-	if (f1 && f2 && f3) {
-		z[0] = f1->z;
-		z[1] = f2->z;
-		z[2] = f3->z;
 
-		// GSL least squares fit function
-		if (type) // x coordinate
-			full_x = Track::create( z, f, w, 3);
-		else // y coordinate
-			full_y = Track::create( z, f, w, 3);
-	}
+	// weighted least squares fit with precalculated geometry
+	if (type) // x coordinate
+		full_x = full_track_fitter(type).fit(f);
+	else // y coordinate
+		full_y = full_track_fitter(type).fit(f);
+}
+
+G4bool
+TrackCoordinates::get_coordinates( G4double* x, G4double* y) const
+{
+	if (xy1_ok != pair_ok || xy2_ok != pair_ok || xy3_ok != pair_ok)
+		return false;
+
+	x[0] = xy1.first / CLHEP::um;
+	x[1] = xy2.first / CLHEP::um;
+	x[2] = xy3.first / CLHEP::um;
+	y[0] = xy1.second / CLHEP::um;
+	y[1] = xy2.second / CLHEP::um;
+	y[2] = xy3.second / CLHEP::um;
+	return true;
 }
 
 G4bool
 TrackCoordinates::check_tracks_within_trajectory()
+{
+	// x, y positions in plane XY3 by hit (um)
+	G4double mx3 = xy3.first / CLHEP::um;
+	G4double my3 = xy3.second / CLHEP::um;
+
+	return within_trajectory( main_track, mx3, my3);
+}
+
+G4bool
+TrackCoordinates::within_trajectory( const TrackXYPair& main_track,
+	G4double mx3, G4double my3)
 {
 	const StripGeometry* x3 = StripGeometry::strip_geometry(MSD_X3);
 	const StripGeometry* y3 = StripGeometry::strip_geometry(MSD_Y3);
 
-	Track& main_x = main_track.first;
-	Track& main_y = main_track.second;
+	const Track& main_x = main_track.first;
+	const Track& main_y = main_track.second;
 
 	// x, y positions in plane XY3 by track (um)
 	G4double main_x3 = main_x.fit(x3->z);
 	G4double main_y3 = main_y.fit(y3->z);
 
-	// x, y positions in plane XY3 by hit (um)
-	G4double mx3 = xy3.first / CLHEP::um;
-	G4double my3 = xy3.second / CLHEP::um;
-	
 	G4double dist_x3 = sqrt( (mx3 - main_x3) * (mx3 - main_x3) +
 		(my3 - main_y3) * (my3 - main_y3));
 
+	const G4double sigma_xy3 =
+		GeometryConfig::instance().third_plane_sigma() / CLHEP::um;
 	return (dist_x3 <= 2 * sigma_xy3);
 }
 
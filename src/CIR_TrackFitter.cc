@@ -0,0 +1,193 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4ios.hh>
+#include <G4SystemOfUnits.hh>
+
+#include "CIR_GeometryConfig.hh"
+#include "CIR_TrackFitter.hh"
+
+namespace CarbonIonRadiography {
+
+TrackFitter::TrackFitter( const G4double* z, G4int n)
+	:
+	n_(n),
+	weighted_(false),
+	valid_(false),
+	cov00_(0.0),
+	cov01_(0.0),
+	cov11_(0.0)
+{
+	precompute( z, 0);
+}
+
+TrackFitter::TrackFitter( const G4double* z, const G4double* w, G4int n)
+	:
+	n_(n),
+	weighted_(true),
+	valid_(false),
+	cov00_(0.0),
+	cov01_(0.0),
+	cov11_(0.0)
+{
+	precompute( z, w);
+}
+
+void
+TrackFitter::precompute( const G4double* z, const G4double* w)
+{
+	for ( G4int i = 0; i < max_points; ++i) {
+		ca_[i] = 0.0;
+		cb_[i] = 0.0;
+	}
+
+	if (n_ < 2 || n_ > max_points) {
+		G4cerr << "TrackFitter: wrong number of planes " << n_ << G4endl;
+		n_ = 0;
+		return;
+	}
+
+	// weighted mean of z, points with non-positive weight are skipped (GSL)
+	G4double W = 0.0, mz = 0.0;
+	for ( G4int i = 0; i < n_; ++i) {
+		G4double wi = w ? w[i] : 1.0;
+		if (wi > 0.0) {
+			W += wi;
+			mz += wi * z[i];
+		}
+	}
+	if (W <= 0.0)
+		return;
+	mz /= W;
+
+	// weighted sum of squared deviations of z
+	G4double S = 0.0;
+	for ( G4int i = 0; i < n_; ++i) {
+		G4double wi = w ? w[i] : 1.0;
+		if (wi > 0.0)
+			S += wi * (z[i] - mz) * (z[i] - mz);
+	}
+	if (S <= 0.0) // all planes at the same z
+		return;
+
+	// a = sum(cb[i] * f[i]), b = sum(ca[i] * f[i])
+	for ( G4int i = 0; i < n_; ++i) {
+		G4double wi = w ? w[i] : 1.0;
+		if (wi > 0.0) {
+			cb_[i] = wi * (z[i] - mz) / S;
+			ca_[i] = wi / W - mz * cb_[i];
+		}
+	}
+
+	// the covariance depends only on the geometry and the weights
+	if (weighted_) {
+		cov00_ = 1.0 / W + mz * mz / S;
+		cov01_ = -mz / S;
+		cov11_ = 1.0 / S;
+	}
+	valid_ = true;
+}
+
+void
+TrackFitter::fit( const G4double* f, size_t events, Track* tracks) const
+{
+	if (!valid_) {
+		for ( size_t i = 0; i < events; ++i)
+			tracks[i] = Track();
+		return;
+	}
+
+	switch (n_) {
+	case 2:
+		for ( size_t i = 0; i < events; ++i, f += 2) {
+			G4double a = cb_[0] * f[0] + cb_[1] * f[1];
+			G4double b = ca_[0] * f[0] + ca_[1] * f[1];
+			tracks[i] = Track( a, b, cov00_, cov01_, cov11_);
+		}
+		break;
+	case 3:
+		for ( size_t i = 0; i < events; ++i, f += 3) {
+			G4double a = cb_[0] * f[0] + cb_[1] * f[1] + cb_[2] * f[2];
+			G4double b = ca_[0] * f[0] + ca_[1] * f[1] + ca_[2] * f[2];
+			tracks[i] = Track( a, b, cov00_, cov01_, cov11_);
+		}
+		break;
+	default:
+		for ( size_t i = 0; i < events; ++i, f += n_)
+			tracks[i] = fit(f);
+		break;
+	}
+}
+
+namespace {
+
+// full track fitter for X (true) or Y (false) planes (xy1-xy2-xy3)
+TrackFitter
+create_full_track_fitter(G4bool type)
+{
+	const GeometryConfig& config = GeometryConfig::instance();
+
+	// sigma (um)
+	G4double w[3] = {
+		config.first_plane_sigma() / CLHEP::um,
+		config.second_plane_sigma() / CLHEP::um,
+		config.third_plane_sigma() / CLHEP::um
+	};
+	G4double z[3] = {};
+
+	z[0] = StripGeometry::strip_geometry(type ? MSD_X1 : MSD_Y1)->z;
+	z[1] = StripGeometry::strip_geometry(type ? MSD_X2 : MSD_Y2)->z;
+	z[2] = StripGeometry::strip_geometry(type ? MSD_X3 : MSD_Y3)->z;
+
+	return TrackFitter( z, w, 3);
+}
+
+// main track fitter for X (true) or Y (false) planes (xy1-xy2)
+TrackFitter
+create_main_track_fitter(G4bool type)
+{
+	G4double z[2] = {};
+
+	z[0] = StripGeometry::strip_geometry(type ? MSD_X1 : MSD_Y1)->z;
+	z[1] = StripGeometry::strip_geometry(type ? MSD_X2 : MSD_Y2)->z;
+
+	return TrackFitter( z, 2);
+}
+
+} // namespace
+
+const TrackFitter&
+full_track_fitter(G4bool type)
+{
+	static const TrackFitter fitter_x = create_full_track_fitter(true);
+	static const TrackFitter fitter_y = create_full_track_fitter(false);
+
+	return type ? fitter_x : fitter_y;
+}
+
+const TrackFitter&
+main_track_fitter(G4bool type)
+{
+	static const TrackFitter fitter_x = create_main_track_fitter(true);
+	static const TrackFitter fitter_y = create_main_track_fitter(false);
+
+	return type ? fitter_x : fitter_y;
+}
+
+} // namespace CarbonIonRadiography
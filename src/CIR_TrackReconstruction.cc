@@ -22,6 +22,7 @@
 #include <TFile.h>
 
 #include <fstream>
+#include <sstream>
 #include <iomanip>
 #include <algorithm>
 #include <numeric>
@@ -31,29 +32,135 @@
 #include <G4UnitsTable.hh>
 #include <G4DataVector.hh>
 
-#include "CIR_Defines.hh"
+#include "CIR_GeometryConfig.hh"
 #include "CIR_StripGeometry.hh"
+#include "CIR_TrackStore.hh"
+#include "CIR_AlignedArray.hh"
+#include "CIR_Parallel.hh"
+#include "CIR_Histogram2D.hh"
+#include "CIR_ProjectionGrid.hh"
+#include "CIR_WeplCalibration.hh"
+#include "CIR_MostLikelyPath.hh"
 #include "CIR_TrackReconstruction.hh"
 
 namespace {
 
-const G4double calo_x = CIR_SIZE_CALORIMETER * CLHEP::mm / 2.0;  // half size
-const G4double calo_y = calo_x;  // half size
-const G4double calo_z = CIR_SIZE_CALORIMETER_THICKNESS * CLHEP::mm / 2.0; // half size
-const G4double calo_slice_z = CIR_SIZE_CALORIMETER_SLICE_THICKNESS * CLHEP::um / 2.0; // half size
-const G4int calo_slices = calo_z / calo_slice_z;
+// first stopping position of the object images
+const G4int object_position_min = 180;
 
-const G4int sizeX1 = -29000;
-const G4int sizeX2 = 29000;
-const G4int sizeY1 = -29000;
-const G4int sizeY2 = 29000;
-const G4int binX = 60;
-const G4int binY = 60;
+// calorimeter slices of the run geometry
+inline
+G4int
+calo_slices()
+{
+	return CarbonIonRadiography::GeometryConfig::instance().calorimeter_slices();
+}
+
+// same binning as TH1I( "slice", "Slice", calo_slices, 0, calo_slices - 1)
+inline
+CarbonIonRadiography::HistogramAxis
+slice_axis()
+{
+	return CarbonIonRadiography::HistogramAxis( calo_slices(),
+		0, calo_slices() - 1);
+}
+
+// Same as TH1::GetBinContent(bin) of the slice histogram,
+// slices with underflow and overflow
+inline
+G4double
+slice_content( const std::vector<G4double>& slices, G4int bin)
+{
+	G4int slice_cells = G4int(slices.size());
+	if (bin < 0)
+		bin = 0;
+	if (bin >= slice_cells)
+		bin = slice_cells - 1;
+	return slices[bin];
+}
+
+typedef CarbonIonRadiography::Histogram2D<G4double> ImageHistogram;
+
+// ions of a block of the most likely paths, one vectorized loop per step
+const size_t path_block = 256;
+
+// no tracks, reconstruction from projection grids
+const CarbonIonRadiography::MainTracksVector no_main_tracks;
+const CarbonIonRadiography::FullTracksVector no_full_tracks;
+
+// Slice histogram contents of the positions
+std::vector<G4double>
+fill_slices( const G4int* position, size_t n, G4int threads)
+{
+	const CarbonIonRadiography::HistogramAxis axis = slice_axis();
+	const G4int slice_cells = axis.bins + 2; // with underflow and overflow
+
+	threads = CarbonIonRadiography::parallel_threads( n, threads);
+	std::vector< std::vector<G4double> > partial( threads,
+		std::vector<G4double>( slice_cells, 0.0));
+
+	CarbonIonRadiography::parallel_for( n, threads,
+		[&]( G4int t, size_t begin, size_t end) {
+			std::vector<G4double>& slices = partial[t];
+			for ( size_t i = begin; i < end; ++i)
+				slices[axis.find_bin(position[i])] += 1.0;
+		});
+
+	for ( G4int t = 1; t < threads; ++t) {
+		for ( G4int i = 0; i < slice_cells; ++i)
+			partial[0][i] += partial[t][i];
+	}
+	return partial[0];
+}
+
+// Sum the private images of the threads in the thread order
+void
+reduce_images(std::vector<ImageHistogram>& partial)
+{
+	for ( size_t t = 1; t < partial.size(); ++t)
+		partial[0].add(partial[t]);
+}
+
+TH1I*
+create_slice_histogram( const char* name, const char* title,
+	const std::vector<G4double>& slices, size_t entries)
+{
+	G4int slices_number = calo_slices();
+	TH1I* hist = new TH1I( name, title, slices_number, 0, slices_number - 1);
+	for ( size_t i = 0; i < slices.size(); ++i)
+		hist->SetBinContent( i, slices[i]);
+	hist->SetEntries(entries);
+	return hist;
+}
 
 } // namespace
 
 namespace CarbonIonRadiography {
 
+TrackReconstruction::TrackReconstruction()
+	:
+	tracks_main_(no_main_tracks),
+	tracks_full_(no_full_tracks),
+	clear_slice_(0),
+	object_slice_(0),
+	clear_position_(0),
+	object_position_(0),
+	clear_fluence_(0),
+	object_fluence_(0),
+	clear_weight_(0),
+	object_weight_(0),
+	clear_pos_min_(-1),
+	clear_pos_max_(-1),
+	object_pos_min_(-1),
+	object_pos_max_(-1),
+	clear_peak_(-1.0),
+	calibration_(0),
+	threads_(0),
+	axis_x_(default_axis()),
+	axis_y_(default_axis())
+{
+}
+
 TrackReconstruction::~TrackReconstruction()
 {
 	if (clear_slice_) delete clear_slice_;
@@ -177,23 +284,6 @@ TrackReconstruction::load( const char* filename, MainTracksVector& data)
 void
 TrackReconstruction::reconstruct(const char* filename)
 {
-	TFile* file = new TFile( filename, "RECREATE");
-
-	TH2D* hist0 = new TH2D( "histpr", "Primary Fluence",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
-
-	TH2D* hist1 = new TH2D( "histfp", "Fluence with position",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
-
-	TH2D* hist2 = new TH2D( "histfw", "Fluence with weight",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
-
-	TH2D* hist3 = new TH2D( "histf", "Fluence",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
-	
-	TH1I* slice = new TH1I( "slice", "Slice Position",
-		calo_slices, 0, calo_slices - 1);
-
 	const StripGeometry* plane_y1 = StripGeometry::strip_geometry(MSD_Y1);
 	const StripGeometry* plane_x1 = StripGeometry::strip_geometry(MSD_X1);
 	const StripGeometry* plane_y2 = StripGeometry::strip_geometry(MSD_Y2);
@@ -201,39 +291,69 @@ TrackReconstruction::reconstruct(const char* filename)
 	const StripGeometry* plane_y3 = StripGeometry::strip_geometry(MSD_Y3);
 	const StripGeometry* plane_x3 = StripGeometry::strip_geometry(MSD_X3);
 
-	for ( size_t i = 0; i < tracks_full_.size(); ++i) {
-		const G4int& position = tracks_full_[i].second;
-		slice->Fill(position);
-	}
+	G4double full_x_z = (plane_x2->z + plane_x3->z) / 2.0;
+	G4double full_y_z = (plane_y2->z + plane_y3->z) / 2.0;
+
+	G4double main_x_z = (plane_x1->z + plane_x2->z) / 2.0;
+	G4double main_y_z = (plane_y1->z + plane_y2->z) / 2.0;
+
+	// full track (xy1-xy2-xy3) coordinates of all tracks
+	TrackStore store(tracks_full_);
+	G4DataVector full_x, full_y;
+	store.extrapolate( full_x_z, full_y_z, full_x, full_y);
+
+	const size_t n = store.size();
+	const G4int* position = store.position();
+	std::vector<G4double> slices = fill_slices( position, n, threads_);
+
+	G4int threads = parallel_threads( n, threads_);
+	const ImageHistogram image( axis_x_, axis_y_);
+	std::vector<ImageHistogram> main_images( threads, image);
+	std::vector<ImageHistogram> position_images( threads, image);
+	std::vector<ImageHistogram> weight_images( threads, image);
+
+	parallel_for( n, threads,
+		[&]( G4int t, size_t begin, size_t end) {
+			ImageHistogram& main = main_images[t];
+			ImageHistogram& full_position = position_images[t];
+			ImageHistogram& full_weight = weight_images[t];
+			for ( size_t i = begin; i < end; ++i) {
+				const Track& main_x = tracks_main_[i].first;
+				const Track& main_y = tracks_main_[i].second;
+
+				// main track (xy1-xy2) coordinates
+				G4double mx = main_x.a() * main_x_z + main_x.b();
+				G4double my = main_y.a() * main_y_z + main_y.b();
+
+				main.fill( mx, my);
+
+				// full track (xy1-xy2-xy3) coordinates
+				G4int bin = full_position.find_bin( full_x[i], full_y[i]);
+				full_position.fill_bin( bin, position[i]);
+				full_weight.fill_bin( bin, slice_content( slices, position[i] + 1));
+			}
+		});
+
+	reduce_images(main_images);
+	reduce_images(position_images);
+	reduce_images(weight_images);
 
-	for ( size_t i = 0; i < tracks_full_.size(); ++i) {
-		const Track& main_x = tracks_main_[i].first;
-		const Track& main_y = tracks_main_[i].second;
-		const Track& full_x = tracks_full_[i].first.first;
-		const Track& full_y = tracks_full_[i].first.second;
-		const G4int& position = tracks_full_[i].second;
+	TFile* file = new TFile( filename, "RECREATE");
 
-		G4double full_x_z = (plane_x2->z + plane_x3->z) / 2.0;
-		G4double full_y_z = (plane_y2->z + plane_y3->z) / 2.0;
+	TH2D* hist0 = main_images[0].create_histogram( "histpr", "Primary Fluence",
+		ImageHistogram::content_count);
 
-		G4double main_x_z = (plane_x1->z + plane_x2->z) / 2.0;
-		G4double main_y_z = (plane_y1->z + plane_y2->z) / 2.0;
+	TH2D* hist1 = position_images[0].create_histogram( "histfp",
+		"Fluence with position");
 
-		// main track (xy1-xy2) coordinates
-		G4double mx = main_x.a() * main_x_z + main_x.b();
-		G4double my = main_y.a() * main_y_z + main_y.b();
+	TH2D* hist2 = weight_images[0].create_histogram( "histfw",
+		"Fluence with weight", ImageHistogram::content_sum, n ? 1.0 / n : 0.0);
 
-		// full track (xy1-xy2-xy3) coordinates
-		G4double fx = full_x.fit(full_x_z);
-		G4double fy = full_y.fit(full_y_z);
-
-		G4double w = slice->GetBinContent(position + 1) / tracks_full_.size();
+	TH2D* hist3 = position_images[0].create_histogram( "histf", "Fluence",
+		ImageHistogram::content_count);
 
-		hist0->Fill( mx, my);
-		hist1->Fill( fx, fy, position);
-		hist2->Fill( fx, fy, w);
-		hist3->Fill( fx, fy);
-	}
+	TH1I* slice = create_slice_histogram( "slice", "Slice Position",
+		slices, n);
 
 	hist0->Write();
 	hist1->Write();
@@ -248,122 +368,393 @@ TrackReconstruction::reconstruct(const char* filename)
 void
 TrackReconstruction::formClearTracksData(const FullTracksVector& clear_tracks)
 {
-	clear_slice_ = new TH1I( "slice_clear", "Slice",
-		calo_slices, 0, calo_slices - 1);
+	const StripGeometry* plane_y2 = StripGeometry::strip_geometry(MSD_Y2);
+	const StripGeometry* plane_x2 = StripGeometry::strip_geometry(MSD_X2);
+	const StripGeometry* plane_y3 = StripGeometry::strip_geometry(MSD_Y3);
+	const StripGeometry* plane_x3 = StripGeometry::strip_geometry(MSD_X3);
 
-	for ( size_t i = 0; i < clear_tracks.size(); ++i) {
-		const G4int& position = clear_tracks[i].second;
-		clear_slice_->Fill(position);
-	}
+	G4double full_x_z = (plane_x2->z + plane_x3->z) / 2.0;
+	G4double full_y_z = (plane_y2->z + plane_y3->z) / 2.0;
 
-	G4DataVector slices(calo_slices);
-	for ( G4int i = 1; i <= calo_slices; ++i)
-		slices[i - 1] = clear_slice_->GetBinContent(i);
+	// full track (xy1-xy2-xy3) coordinates of all tracks
+	TrackStore store(clear_tracks);
+	G4DataVector full_x, full_y;
+	store.extrapolate( full_x_z, full_y_z, full_x, full_y);
 
-	G4DataVector::iterator iter = std::max_element( slices.begin(), slices.end());
-	
-	clear_pos_max_ = iter - slices.begin() + 1;
+	const size_t n = store.size();
+	const G4int* position = store.position();
+	std::vector<G4double> slices = fill_slices( position, n, threads_);
 
-	clear_position_ = new TH2D( "position_clear", "Position",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
+	clear_slice_ = create_slice_histogram( "slice_clear", "Slice", slices, n);
 
-	clear_fluence_ = new TH2D( "fluence_clear", "Fluence",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
+	std::vector<G4double>::iterator iter = std::max_element(
+		slices.begin() + 1, slices.begin() + 1 + calo_slices());
+	
+	clear_pos_max_ = iter - slices.begin();
+
+	// counts of the stopping positions -1 ... slices - 1
+	std::vector<G4double> counts( calo_slices() + 1, 0.0);
+	for ( size_t i = 0; i < n; ++i)
+		counts[std::min( std::max( position[i] + 1, 0), calo_slices())] += 1.0;
+	clear_peak_ = WeplCalibration::peak_position(counts);
+
+	G4int threads = parallel_threads( n, threads_);
+	const ImageHistogram image( axis_x_, axis_y_);
+	std::vector<ImageHistogram> position_images( threads, image);
+	std::vector<ImageHistogram> weight_images( threads, image);
+
+	parallel_for( n, threads,
+		[&]( G4int t, size_t begin, size_t end) {
+			ImageHistogram& clear_position = position_images[t];
+			ImageHistogram& clear_weight = weight_images[t];
+			for ( size_t i = begin; i < end; ++i) {
+//				if (position[i] > clear_pos_max_)
+//					continue;
+
+				// full track (xy1-xy2-xy3) coordinates
+				G4int bin = clear_position.find_bin( full_x[i], full_y[i]);
+				clear_position.fill_bin( bin, position[i]);
+				clear_weight.fill_bin( bin, slice_content( slices, position[i] + 1));
+			}
+		});
+
+	reduce_images(position_images);
+	reduce_images(weight_images);
+
+	clear_position_ = position_images[0].create_histogram( "position_clear",
+		"Position");
+
+	clear_fluence_ = position_images[0].create_histogram( "fluence_clear",
+		"Fluence", ImageHistogram::content_count);
+
+	clear_weight_ = weight_images[0].create_histogram( "weight_clear",
+		"Weight", ImageHistogram::content_sum, n ? 1.0 / n : 0.0);
+}
 
-	clear_weight_ = new TH2D( "weight_clear", "Weight",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
+
+void
+TrackReconstruction::formObjectTracksData(const FullTracksVector& clear_tracks)
+{
+	formClearTracksData(clear_tracks);
 
 	const StripGeometry* plane_y2 = StripGeometry::strip_geometry(MSD_Y2);
 	const StripGeometry* plane_x2 = StripGeometry::strip_geometry(MSD_X2);
 	const StripGeometry* plane_y3 = StripGeometry::strip_geometry(MSD_Y3);
 	const StripGeometry* plane_x3 = StripGeometry::strip_geometry(MSD_X3);
 
-	for ( size_t i = 0; i < clear_tracks.size(); ++i) {
-		const Track& full_x = clear_tracks[i].first.first;
-		const Track& full_y = clear_tracks[i].first.second;
-		const G4int& position = clear_tracks[i].second;
+	G4double full_x_z = (plane_x2->z + plane_x3->z) / 2.0;
+	G4double full_y_z = (plane_y2->z + plane_y3->z) / 2.0;
 
-//		if (position > clear_pos_max_)
-//			continue;
-	
-		G4double w = clear_slice_->GetBinContent(position + 1) / clear_tracks.size();
+	// full track (xy1-xy2-xy3) coordinates of all tracks
+	TrackStore store(tracks_full_);
+	G4DataVector full_x, full_y;
+	store.extrapolate( full_x_z, full_y_z, full_x, full_y);
 
-		G4double full_x_z = (plane_x2->z + plane_x3->z) / 2.0;
-		G4double full_y_z = (plane_y2->z + plane_y3->z) / 2.0;
+	const size_t n = store.size();
+	const G4int* position = store.position();
 
-		// full track (xy1-xy2-xy3) coordinates
-		G4double fx = full_x.fit(full_x_z);
-		G4double fy = full_y.fit(full_y_z);
+	// all tracks, without position cuts
+	std::vector<G4double> slices = fill_slices( position, n, threads_);
 
-		clear_position_->Fill( fx, fy, position);
-		clear_fluence_->Fill( fx, fy);
-		clear_weight_->Fill( fx, fy, w);
-	}
+	object_slice_ = create_slice_histogram( "slice_object", "Slice", slices, n);
+
+	// image value of the positions -1 ... slices - 1
+	const G4int calo = calo_slices();
+	std::vector<G4double> values = wepl_table(calo);
+
+	G4int threads = parallel_threads( n, threads_);
+	const ImageHistogram image( axis_x_, axis_y_);
+	std::vector<ImageHistogram> position_images( threads, image);
+	std::vector<ImageHistogram> weight_images( threads, image);
+
+	parallel_for( n, threads,
+		[&]( G4int t, size_t begin, size_t end) {
+			ImageHistogram& object_position = position_images[t];
+			ImageHistogram& object_weight = weight_images[t];
+			for ( size_t i = begin; i < end; ++i) {
+				if (position[i] > clear_pos_max_ || position[i] < object_pos_min_)
+					continue;
+
+				// full track (xy1-xy2-xy3) coordinates
+				G4int bin = object_position.find_bin( full_x[i], full_y[i]);
+				object_position.fill_bin( bin, values.empty() ?
+					clear_pos_max_ - position[i] :
+					values[std::min( std::max( position[i] + 1, 0), calo)]);
+				object_weight.fill_bin( bin, slice_content( slices, position[i] + 1));
+			}
+		});
+
+	reduce_images(position_images);
+	reduce_images(weight_images);
+
+	object_fluence_ = position_images[0].create_histogram( "fluence_object",
+		"Fluence", ImageHistogram::content_count);
+
+	object_position_ = position_images[0].create_histogram( "position_object",
+		"Position");
+
+	object_weight_ = weight_images[0].create_histogram( "weight_object",
+		"Weight", ImageHistogram::content_sum, n ? 1.0 / n : 0.0);
 }
 
+void
+TrackReconstruction::reconstruct( const FullTracksVector& clear_tracks,
+	const char* filename)
+{
+	object_pos_min_ = object_position_min;
+
+	formObjectTracksData(clear_tracks);
+
+	write_image(filename);
+}
 
 void
-TrackReconstruction::formObjectTracksData(const FullTracksVector& clear_tracks)
+TrackReconstruction::reconstruct( const FullTracksVector& clear_tracks,
+	const MostLikelyPath& path, const char* filename)
 {
+	object_pos_min_ = object_position_min;
+
 	formClearTracksData(clear_tracks);
 
-	object_slice_ = new TH1I( "slice_object", "Slice",
-		calo_slices, 0, calo_slices - 1);
+	// image value of the positions -1 ... slices - 1
+	const G4int calo = calo_slices();
+	std::vector<G4double> values = wepl_table(calo);
+
+	const size_t n = std::min( tracks_main_.size(), tracks_full_.size());
+	const G4int steps = path.steps();
+	const G4double step = path.step_length();
+
+	G4int threads = parallel_threads( n, threads_);
+	const ImageHistogram image( axis_x_, axis_y_);
+	std::vector< std::vector<ImageHistogram> > slabs( threads,
+		std::vector<ImageHistogram>( steps, image));
+
+	parallel_for( n, threads,
+		[&]( G4int t, size_t begin, size_t end) {
+			std::vector<ImageHistogram>& slab = slabs[t];
+
+			// entrance and exit states of the block, X and Y
+			AlignedArray<G4double> x0(path_block), tx0(path_block);
+			AlignedArray<G4double> x1(path_block), tx1(path_block);
+			AlignedArray<G4double> y0(path_block), ty0(path_block);
+			AlignedArray<G4double> y1(path_block), ty1(path_block);
+			AlignedArray<G4double> px(path_block), py(path_block);
+			std::vector<G4double> value(path_block);
+
+			for ( size_t first = begin; first < end; first += path_block) {
+				const size_t last = std::min( first + path_block, end);
+				size_t m = 0;
+				for ( size_t i = first; i < last; ++i) {
+					const G4int position = tracks_full_[i].second;
+					if (position > clear_pos_max_ || position < object_pos_min_)
+						continue;
+
+					const TrackXYPair& main = tracks_main_[i];
+					const TrackXYPair& full = tracks_full_[i].first;
+					path.states( true, main.first, full.first,
+						x0[m], tx0[m], x1[m], tx1[m]);
+					path.states( false, main.second, full.second,
+						y0[m], ty0[m], y1[m], ty1[m]);
+					value[m] = values.empty() ? clear_pos_max_ - position :
+						values[std::min( std::max( position + 1, 0), calo)];
+					++m;
+				}
+
+				for ( G4int k = 0; k < steps; ++k) {
+					path.estimate( k, x0.data(), tx0.data(), x1.data(), tx1.data(),
+						m, px.data());
+					path.estimate( k, y0.data(), ty0.data(), y1.data(), ty1.data(),
+						m, py.data());
+
+					ImageHistogram& hist = slab[k];
+					for ( size_t j = 0; j < m; ++j) {
+						G4double v = value[j];
+						hist.add_bin( hist.find_bin( px[j], py[j]),
+							v * step, step, v * v * step);
+					}
+				}
+			}
+		});
+
+	for ( G4int k = 0; k < steps; ++k) {
+		for ( G4int t = 1; t < threads; ++t)
+			slabs[0][k].add(slabs[t][k]);
+	}
 
-	for ( size_t i = 0; i < tracks_full_.size(); ++i) {
-		const G4int& position = tracks_full_[i].second;
-//		if (position > clear_pos_max_ || position < object_pos_min_)
-//			continue;
-		object_slice_->Fill(position);
+	TFile* file = new TFile( filename, "RECREATE");
+
+	for ( G4int k = 0; k < steps; ++k) {
+		std::ostringstream name, title;
+		name << "mlp_" << k;
+		title << "Most likely path, z " << path.depth(k) << " um";
+
+		// path length and mean value of the step
+		TH2D* length = slabs[0][k].create_histogram(
+			(name.str() + "_length").c_str(), title.str().c_str(),
+			ImageHistogram::content_count);
+		TH2D* mean = slabs[0][k].create_histogram( name.str().c_str(),
+			title.str().c_str());
+		mean->Divide(length);
+
+		mean->Write();
+		length->Write();
+		delete mean;
+		delete length;
 	}
+	clear_slice_->Write();
+	clear_fluence_->Write();
+	file->Close();
 
-	object_fluence_ = new TH2D( "fluence_object", "Fluence",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
+	delete file;
+}
 
-	object_position_ = new TH2D( "position_object", "Position",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
+void
+TrackReconstruction::formClearGridData(const ProjectionGrid& clear)
+{
+	clear_slice_ = clear.create_slice_histogram( "slice_clear", "Slice");
 
-	object_weight_ = new TH2D( "weight_object", "Weight",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
+	set_clear_peak(clear);
 
-	const StripGeometry* plane_y2 = StripGeometry::strip_geometry(MSD_Y2);
-	const StripGeometry* plane_x2 = StripGeometry::strip_geometry(MSD_X2);
-	const StripGeometry* plane_y3 = StripGeometry::strip_geometry(MSD_Y3);
-	const StripGeometry* plane_x3 = StripGeometry::strip_geometry(MSD_X3);
+	const G4double n = clear.entries();
+	const ImageHistogram image( clear.axis_x(), clear.axis_y());
+	ImageHistogram position(image), weight(image);
 
-	for ( size_t i = 0; i < tracks_full_.size(); ++i) {
-		const Track& full_x = tracks_full_[i].first.first;
-		const Track& full_y = tracks_full_[i].first.second;
-		const G4int& position = tracks_full_[i].second;
+	// all tracks, position as is
+	clear.form_images( -1, clear.slices(), 0, 1, position, weight);
 
-		if (position > clear_pos_max_ || position < object_pos_min_)
-			continue;
+	clear_position_ = position.create_histogram( "position_clear",
+		"Position");
 
-		G4double full_x_z = (plane_x2->z + plane_x3->z) / 2.0;
-		G4double full_y_z = (plane_y2->z + plane_y3->z) / 2.0;
+	clear_fluence_ = position.create_histogram( "fluence_clear",
+		"Fluence", ImageHistogram::content_count);
 
-		G4double w = object_slice_->GetBinContent(position + 1) / tracks_full_.size();
+	clear_weight_ = weight.create_histogram( "weight_clear",
+		"Weight", ImageHistogram::content_sum, n ? 1.0 / n : 0.0);
+}
 
-		// full track (xy1-xy2-xy3) coordinates
-		G4double fx = full_x.fit(full_x_z);
-		G4double fy = full_y.fit(full_y_z);
+void
+TrackReconstruction::formObjectGridData( const ProjectionGrid& clear,
+	const ProjectionGrid& object)
+{
+	formClearGridData(clear);
 
-		G4int pos = clear_pos_max_ - position;
+	object_slice_ = object.create_slice_histogram( "slice_object", "Slice");
 
-		object_position_->Fill( fx, fy, pos);
-		object_fluence_->Fill( fx, fy);
-		object_weight_->Fill( fx, fy, w);
+	const G4double n = object.entries();
+	const ImageHistogram image( object.axis_x(), object.axis_y());
+	ImageHistogram position(image), weight(image);
+	form_object_images( object, position, weight);
+
+	object_fluence_ = position.create_histogram( "fluence_object",
+		"Fluence", ImageHistogram::content_count);
+
+	object_position_ = position.create_histogram( "position_object",
+		"Position");
+
+	object_weight_ = weight.create_histogram( "weight_object",
+		"Weight", ImageHistogram::content_sum, n ? 1.0 / n : 0.0);
+}
+
+void
+TrackReconstruction::reconstruct( const ProjectionGrid& clear,
+	const ProjectionGrid& object, const char* filename)
+{
+	object_pos_min_ = object_position_min;
+
+	set_binning( object.axis_x(), object.axis_y());
+	formObjectGridData( clear, object);
+
+	write_image(filename);
+}
+
+void
+TrackReconstruction::form_projection_image( const ProjectionGrid& clear,
+	const ProjectionGrid& object, ImageHistogram& image)
+{
+	object_pos_min_ = object_position_min;
+	set_clear_peak(clear);
+
+	ImageHistogram weight( object.axis_x(), object.axis_y());
+	image = ImageHistogram( object.axis_x(), object.axis_y());
+	form_object_images( object, image, weight);
+}
+
+std::vector<G4double>
+TrackReconstruction::position_values(const ProjectionGrid& clear)
+{
+	object_pos_min_ = object_position_min;
+	set_clear_peak(clear);
+
+	const G4int slices = clear.slices();
+	std::vector<G4double> values = object_values(slices);
+	for ( G4int i = 0; i <= slices; ++i) {
+		if (i - 1 < object_pos_min_ || i - 1 > clear_pos_max_)
+			values[i] = -1.0;
 	}
+	return values;
 }
 
 void
-TrackReconstruction::reconstruct( const FullTracksVector& clear_tracks,
+TrackReconstruction::reconstruct( const ProjectionGrid& projection,
 	const char* filename)
 {
-	object_pos_min_ = 180;
+	set_binning( projection.axis_x(), projection.axis_y());
+	formClearGridData(projection);
 
-	formObjectTracksData(clear_tracks);
+	TFile* file = new TFile( filename, "RECREATE");
+
+	clear_slice_->Write();
+	clear_position_->Write();
+	clear_fluence_->Write();
+	clear_weight_->Write();
+	file->Close();
 
+	delete file;
+}
+
+std::vector<G4double>
+TrackReconstruction::wepl_table(G4int slices) const
+{
+	if (!calibration_)
+		return std::vector<G4double>();
+
+	WeplCalibration calibration(*calibration_);
+	calibration.align(clear_peak_);
+	calibration.build(slices);
+	return calibration.table();
+}
+
+void
+TrackReconstruction::set_clear_peak(const ProjectionGrid& clear)
+{
+	clear_pos_max_ = clear.peak_position();
+	clear_peak_ = WeplCalibration::peak_position(clear.position_counts());
+}
+
+std::vector<G4double>
+TrackReconstruction::object_values(G4int slices) const
+{
+	// position from the clear peak position or WEPL
+	std::vector<G4double> values = wepl_table(slices);
+	if (values.empty()) {
+		values.resize(slices + 1);
+		for ( G4int i = 0; i <= slices; ++i)
+			values[i] = clear_pos_max_ - (i - 1);
+	}
+	return values;
+}
+
+void
+TrackReconstruction::form_object_images( const ProjectionGrid& object,
+	ImageHistogram& position, ImageHistogram& weight) const
+{
+	object.form_images( object_pos_min_, clear_pos_max_,
+		object_values(object.slices()), position, weight);
+}
+
+void
+TrackReconstruction::write_image(const char* filename)
+{
 	G4DataVector positions;
 	G4DataVector fluences;
 	G4double p, f, w, r, w1;
@@ -378,11 +769,11 @@ TrackReconstruction::reconstruct( const FullTracksVector& clear_tracks,
 		}
 	}
 
-	TH2D* hist1 = new TH2D( "pos", "Positions",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
+	TH2D* hist1 = new TH2D( "pos", "Positions", axis_x_.bins,
+		axis_x_.min, axis_x_.max, axis_y_.bins, axis_y_.min, axis_y_.max);
 
-	TH2D* hist2 = new TH2D( "flu", "Fluence",
-		binX, sizeX1, sizeX2, binY, sizeY1, sizeY2);
+	TH2D* hist2 = new TH2D( "flu", "Fluence", axis_x_.bins,
+		axis_x_.min, axis_x_.max, axis_y_.bins, axis_y_.min, axis_y_.max);
 
 	G4double min = *std::min_element( positions.begin(), positions.end());
 	G4double max = *std::max_element( positions.begin(), positions.end());
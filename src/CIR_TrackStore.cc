@@ -0,0 +1,109 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include "CIR_TrackStore.hh"
+
+namespace CarbonIonRadiography {
+
+TrackStore::TrackStore(const FullTracksVector& tracks)
+	:
+	size_(0)
+{
+	assign(tracks);
+}
+
+void
+TrackStore::resize(size_t n)
+{
+	ax_.resize(n);
+	bx_.resize(n);
+	cov00x_.resize(n);
+	cov01x_.resize(n);
+	cov11x_.resize(n);
+	ay_.resize(n);
+	by_.resize(n);
+	cov00y_.resize(n);
+	cov01y_.resize(n);
+	cov11y_.resize(n);
+	position_.resize(n);
+	size_ = n;
+}
+
+void
+TrackStore::assign(const FullTracksVector& tracks)
+{
+	resize(tracks.size());
+	for ( size_t i = 0; i < tracks.size(); ++i)
+		set( i, tracks[i]);
+}
+
+void
+TrackStore::set( size_t i, const TracksPositionPair& track)
+{
+	const Track& x = track.first.first;
+	const Track& y = track.first.second;
+
+	ax_[i] = x.a();
+	bx_[i] = x.b();
+	cov00x_[i] = x.cov00();
+	cov01x_[i] = x.cov01();
+	cov11x_[i] = x.cov11();
+
+	ay_[i] = y.a();
+	by_[i] = y.b();
+	cov00y_[i] = y.cov00();
+	cov01y_[i] = y.cov01();
+	cov11y_[i] = y.cov11();
+
+	position_[i] = track.second;
+}
+
+TracksPositionPair
+TrackStore::get(size_t i) const
+{
+	Track x( ax_[i], bx_[i], cov00x_[i], cov01x_[i], cov11x_[i]);
+	Track y( ay_[i], by_[i], cov00y_[i], cov01y_[i], cov11y_[i]);
+
+	return TracksPositionPair( TrackXYPair( x, y), position_[i]);
+}
+
+void
+TrackStore::extrapolate( G4double z_x, G4double z_y,
+	G4double* out_x, G4double* out_y) const
+{
+	// same as gsl_fit_linear_est: y = c0 + c1 * x
+	const G4double* __restrict__ ax =
+		static_cast<const G4double*>(__builtin_assume_aligned( ax_.data(), 64));
+	const G4double* __restrict__ bx =
+		static_cast<const G4double*>(__builtin_assume_aligned( bx_.data(), 64));
+	const G4double* __restrict__ ay =
+		static_cast<const G4double*>(__builtin_assume_aligned( ay_.data(), 64));
+	const G4double* __restrict__ by =
+		static_cast<const G4double*>(__builtin_assume_aligned( by_.data(), 64));
+	G4double* __restrict__ x = out_x;
+	G4double* __restrict__ y = out_y;
+
+	const size_t n = size_;
+	for ( size_t i = 0; i < n; ++i)
+		x[i] = bx[i] + ax[i] * z_x;
+	for ( size_t i = 0; i < n; ++i)
+		y[i] = by[i] + ay[i] * z_y;
+}
+
+} // namespace CarbonIonRadiography
@@ -0,0 +1,340 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4Box.hh>
+#include <G4LogicalVolume.hh>
+#include <G4PVPlacement.hh>
+#include <G4PVParameterised.hh>
+#include <G4PhantomParameterisation.hh>
+#include <G4Material.hh>
+#include <G4NistManager.hh>
+#include <G4VisAttributes.hh>
+#include <G4Colour.hh>
+#include <G4SystemOfUnits.hh>
+#include <G4ios.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "CIR_VoxelPhantom.hh"
+
+namespace {
+
+bool
+by_density( const G4double& density, const G4double& min_density)
+{
+	return density < min_density;
+}
+
+// order of the density ranges by the minimal density
+template<class Range>
+bool
+by_min_density( const Range& a, const Range& b)
+{
+	return a.minDensity < b.minDensity;
+}
+
+// directory of the file with the trailing slash
+G4String
+directory(const G4String& file)
+{
+	size_t slash = file.rfind('/');
+	return (slash == std::string::npos) ? G4String() : G4String(file.substr( 0, slash + 1));
+}
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+VoxelPhantom::VoxelPhantom()
+	:
+	voxelsX(0),
+	voxelsY(0),
+	voxelsZ(0),
+	voxelX(0.0),
+	voxelY(0.0),
+	voxelZ(0.0),
+	densityStep(0.01)
+{
+}
+
+VoxelPhantom::~VoxelPhantom()
+{
+}
+
+G4bool
+VoxelPhantom::Load(const G4String& header)
+{
+	std::ifstream file(header.c_str());
+	if (!file) {
+		G4cerr << "Can't open phantom header " << header << G4endl;
+		return false;
+	}
+
+	G4String data, format = "id";
+	materialEntries.clear();
+	densityRanges.clear();
+
+	std::string line;
+	while (std::getline( file, line)) {
+		std::istringstream fields(line);
+		std::string key;
+		if (!(fields >> key) || key[0] == '#')
+			continue;
+
+		if (key == "voxels")
+			fields >> voxelsX >> voxelsY >> voxelsZ;
+		else if (key == "size")
+			fields >> voxelX >> voxelY >> voxelZ;
+		else if (key == "data")
+			fields >> data;
+		else if (key == "format")
+			fields >> format;
+		else if (key == "step")
+			fields >> densityStep;
+		else if (key == "material") {
+			MaterialEntry entry = { -1, "", 0.0 };
+			if (fields >> entry.id >> entry.name) {
+				// optional density
+				if (!(fields >> entry.density))
+					entry.density = 0.0;
+				materialEntries.push_back(entry);
+				continue;
+			}
+		}
+		else if (key == "range") {
+			DensityRange range = { 0.0, "" };
+			fields >> range.minDensity >> range.name;
+			densityRanges.push_back(range);
+		}
+
+		if (fields.fail()) {
+			G4cerr << "Wrong phantom header line: " << line << G4endl;
+			return false;
+		}
+	}
+
+	if (voxelsX <= 0 || voxelsY <= 0 || voxelsZ <= 0 ||
+		voxelX <= 0.0 || voxelY <= 0.0 || voxelZ <= 0.0 || data.empty()) {
+		G4cerr << "Incomplete phantom header " << header << G4endl;
+		return false;
+	}
+	voxelX *= mm;
+	voxelY *= mm;
+	voxelZ *= mm;
+
+	if (data[0] != '/')
+		data = directory(header) + data;
+
+	materials.clear();
+	G4bool res = (format == "density") ? LoadDensities(data) : LoadIDs(data);
+	if (!res)
+		return false;
+
+	fileName = header;
+	G4cout << "Phantom " << header << ": " << voxelsX << " x " << voxelsY
+		<< " x " << voxelsZ << " voxels, " << materials.size()
+		<< " materials" << G4endl;
+	return true;
+}
+
+G4Material*
+VoxelPhantom::FindMaterial( const G4String& name, G4double density)
+{
+	G4NistManager* man = G4NistManager::Instance();
+	G4Material* material = man->FindOrBuildMaterial(name);
+	if (!material || density <= 0.0)
+		return material;
+
+	// the same NIST material with another density, shared by name
+	std::ostringstream derived;
+	derived << name << "_" << density;
+	G4Material* result = G4Material::GetMaterial( derived.str(), false);
+	if (!result)
+		result = new G4Material( derived.str(), density * g/cm3, material);
+	return result;
+}
+
+G4bool
+VoxelPhantom::LoadIDs(const G4String& data)
+{
+	// compact table: ID -> material index, one index per material
+	std::vector<G4int> table( 65536, -1);
+	for ( size_t i = 0; i < materialEntries.size(); ++i) {
+		const MaterialEntry& entry = materialEntries[i];
+		if (entry.id < 0 || entry.id >= G4int(table.size()))
+			continue;
+
+		G4Material* material = FindMaterial( entry.name, entry.density);
+		if (!material) {
+			G4cerr << "Unknown phantom material " << entry.name << G4endl;
+			return false;
+		}
+
+		std::vector<G4Material*>::iterator iter =
+			std::find( materials.begin(), materials.end(), material);
+		table[entry.id] = G4int(iter - materials.begin());
+		if (iter == materials.end())
+			materials.push_back(material);
+	}
+
+	size_t n = size_t(voxelsX) * voxelsY * voxelsZ;
+	std::vector<unsigned short> ids(n);
+
+	std::ifstream raw( data.c_str(), std::ios::binary);
+	raw.read( (char *)&ids[0], n * sizeof(unsigned short));
+	if (!raw) {
+		G4cerr << "Can't read phantom data " << data << G4endl;
+		return false;
+	}
+
+	indices.resize(n);
+	for ( size_t i = 0; i < n; ++i) {
+		G4int index = table[ids[i]];
+		if (index < 0) {
+			G4cerr << "Phantom material ID " << ids[i] << " isn't defined"
+				<< G4endl;
+			return false;
+		}
+		indices[i] = index;
+	}
+	return true;
+}
+
+G4bool
+VoxelPhantom::LoadDensities(const G4String& data)
+{
+	if (densityRanges.empty() || densityStep <= 0.0) {
+		G4cerr << "No density ranges of the phantom" << G4endl;
+		return false;
+	}
+
+	// the ranges may be listed in any order in the header
+	std::stable_sort( densityRanges.begin(), densityRanges.end(),
+		by_min_density<DensityRange>);
+
+	std::vector<G4double> minDensities(densityRanges.size());
+	for ( size_t i = 0; i < densityRanges.size(); ++i)
+		minDensities[i] = densityRanges[i].minDensity;
+
+	size_t n = size_t(voxelsX) * voxelsY * voxelsZ;
+	std::vector<G4float> densities(n);
+
+	std::ifstream raw( data.c_str(), std::ios::binary);
+	raw.read( (char *)&densities[0], n * sizeof(G4float));
+	if (!raw) {
+		G4cerr << "Can't read phantom data " << data << G4endl;
+		return false;
+	}
+
+	// material index of every density bin of every range
+	std::vector< std::vector<G4int> > bins(densityRanges.size());
+
+	indices.resize(n);
+	for ( size_t i = 0; i < n; ++i) {
+		G4double density = std::max( G4double(densities[i]), 0.0);
+
+		// the last range starting below the density
+		size_t range = std::upper_bound( minDensities.begin(),
+			minDensities.end(), density, by_density) - minDensities.begin();
+		range = (range > 0) ? range - 1 : 0;
+
+		size_t bin = size_t(density / densityStep);
+		std::vector<G4int>& range_bins = bins[range];
+		if (bin >= range_bins.size())
+			range_bins.resize( bin + 1, -1);
+
+		if (range_bins[bin] < 0) {
+			G4double bin_density = (bin + 0.5) * densityStep;
+			G4Material* material = FindMaterial( densityRanges[range].name,
+				bin_density);
+			if (!material) {
+				G4cerr << "Unknown phantom material " << densityRanges[range].name
+					<< G4endl;
+				return false;
+			}
+			range_bins[bin] = G4int(materials.size());
+			materials.push_back(material);
+		}
+		indices[i] = range_bins[bin];
+	}
+	return true;
+}
+
+G4VPhysicalVolume*
+VoxelPhantom::Construct( G4LogicalVolume* mother,
+	const G4ThreeVector& position, G4Material* containerMaterial)
+{
+	if (indices.empty())
+		return 0;
+
+	G4double halfX = 0.5 * voxelX, halfY = 0.5 * voxelY, halfZ = 0.5 * voxelZ;
+
+	G4Box* containerBox = new G4Box( "PhantomContainer",
+		voxelsX * halfX, voxelsY * halfY, voxelsZ * halfZ);
+	G4LogicalVolume* containerLogicalVolume = new G4LogicalVolume(
+		containerBox, containerMaterial, "PhantomContainerLog");
+	G4VPhysicalVolume* containerPhysicalVolume = new G4PVPlacement(
+		0,
+		position,
+		containerLogicalVolume,
+		"PhantomContainerPhys",
+		mother,
+		false,
+		0);
+
+	G4Box* voxelBox = new G4Box( "PhantomVoxel", halfX, halfY, halfZ);
+	G4LogicalVolume* voxelLogicalVolume = new G4LogicalVolume(
+		voxelBox, materials.front(), "PhantomVoxelLog");
+
+	G4PhantomParameterisation* param = new G4PhantomParameterisation;
+	param->SetVoxelDimensions( halfX, halfY, halfZ);
+	param->SetNoVoxel( voxelsX, voxelsY, voxelsZ);
+	param->SetMaterials(materials);
+	param->SetMaterialIndices(&indices[0]);
+	param->BuildContainerSolid(containerPhysicalVolume);
+	param->CheckVoxelsFillContainer( containerBox->GetXHalfLength(),
+		containerBox->GetYHalfLength(), containerBox->GetZHalfLength());
+	// neighbour voxels of the same material are crossed in one step
+	param->SetSkipEqualMaterials(true);
+
+	G4PVParameterised* voxels = new G4PVParameterised(
+		"PhantomVoxelPhys",
+		voxelLogicalVolume,
+		containerLogicalVolume,
+		kUndefined,
+		G4int(indices.size()),
+		param);
+
+	// regular navigation instead of the smart voxels of the container
+	voxels->SetRegularStructureId(1);
+
+	voxelLogicalVolume->SetVisAttributes(G4VisAttributes::Invisible);
+
+	G4VisAttributes* attr = new G4VisAttributes(G4Colour::Blue());
+	attr->SetVisibility(true);
+	attr->SetForceWireframe(true);
+	containerLogicalVolume->SetVisAttributes(attr);
+
+	return containerPhysicalVolume;
+}
+
+} // namespace CarbonIonRadiography
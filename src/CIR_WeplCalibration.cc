@@ -0,0 +1,203 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ * 
+ * 
+ */
+
+#include <G4ios.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+#include "CIR_ProjectionGrid.hh"
+#include "CIR_WeplCalibration.hh"
+
+namespace {
+
+// positions on each side of the peak of the centroid
+const G4int peak_half_width = 2;
+
+} // namespace
+
+namespace CarbonIonRadiography {
+
+WeplCalibration::WeplCalibration()
+{
+}
+
+void
+WeplCalibration::add_point( G4double position, G4double wepl)
+{
+	points_.push_back(std::make_pair( position, wepl));
+	sort_points();
+}
+
+void
+WeplCalibration::add_run( const ProjectionGrid& grid, G4double wepl)
+{
+	add_point( peak_position(grid.position_counts()), wepl);
+}
+
+void
+WeplCalibration::clear()
+{
+	points_.clear();
+	table_.clear();
+}
+
+void
+WeplCalibration::sort_points()
+{
+	std::sort( points_.begin(), points_.end());
+}
+
+G4double
+WeplCalibration::position_of(G4double wepl) const
+{
+	if (points_.size() < 2)
+		return points_.empty() ? 0.0 : points_.front().first;
+
+	// segment crossing the WEPL, else the segment of the nearest point
+	size_t segment = 1;
+	G4double nearest = -1.0;
+	for ( size_t i = 1; i < points_.size(); ++i) {
+		const std::pair< G4double, G4double>& a = points_[i - 1];
+		const std::pair< G4double, G4double>& b = points_[i];
+		if ((a.second - wepl) * (b.second - wepl) <= 0.0 && a.second != b.second) {
+			segment = i;
+			break;
+		}
+		G4double distance = std::min( std::fabs(a.second - wepl),
+			std::fabs(b.second - wepl));
+		if (nearest < 0.0 || distance < nearest) {
+			nearest = distance;
+			segment = i;
+		}
+	}
+
+	const std::pair< G4double, G4double>& a = points_[segment - 1];
+	const std::pair< G4double, G4double>& b = points_[segment];
+	if (a.second == b.second)
+		return a.first;
+	return a.first + (b.first - a.first) * (wepl - a.second)
+		/ (b.second - a.second);
+}
+
+void
+WeplCalibration::align(G4double clear_position)
+{
+	if (points_.size() < 2)
+		return;
+
+	G4double shift = clear_position - position_of(0.0);
+	for ( size_t i = 0; i < points_.size(); ++i)
+		points_[i].first += shift;
+}
+
+G4double
+WeplCalibration::interpolate(G4double position) const
+{
+	if (points_.empty())
+		return 0.0;
+	if (points_.size() == 1)
+		return points_.front().second;
+
+	// segment of the position, the first or the last one outside
+	size_t i = std::upper_bound( points_.begin(), points_.end(),
+		std::make_pair( position, 0.0)) - points_.begin();
+	if (i < 1)
+		i = 1;
+	else if (i > points_.size() - 1)
+		i = points_.size() - 1;
+
+	const std::pair< G4double, G4double>& a = points_[i - 1];
+	const std::pair< G4double, G4double>& b = points_[i];
+	if (b.first == a.first)
+		return a.second;
+	return a.second + (b.second - a.second) * (position - a.first)
+		/ (b.first - a.first);
+}
+
+void
+WeplCalibration::build(G4int slices)
+{
+	table_.resize(slices + 1);
+	for ( G4int i = 0; i <= slices; ++i)
+		table_[i] = interpolate(i - 1);
+}
+
+G4double
+WeplCalibration::peak_position(const std::vector<G4double>& counts)
+{
+	if (counts.size() < 2)
+		return -1.0;
+
+	// peak of the positions 0 ... slices - 1
+	G4int peak = std::max_element( counts.begin() + 1, counts.end())
+		- counts.begin();
+
+	G4int first = std::max( 1, peak - peak_half_width);
+	G4int last = std::min( G4int(counts.size()) - 1, peak + peak_half_width);
+
+	G4double sum = 0.0, sum_position = 0.0;
+	for ( G4int i = first; i <= last; ++i) {
+		sum += counts[i];
+		sum_position += counts[i] * (i - 1);
+	}
+	return sum ? sum_position / sum : peak - 1;
+}
+
+G4bool
+WeplCalibration::save(const char* filename) const
+{
+	std::ofstream file(filename);
+	file << "# stopping position, WEPL (mm)\n";
+	for ( size_t i = 0; i < points_.size(); ++i)
+		file << "point " << points_[i].first << " " << points_[i].second << "\n";
+	return file.good();
+}
+
+G4bool
+WeplCalibration::load( const char* filename, WeplCalibration& calibration)
+{
+	std::ifstream file(filename);
+	if (!file) {
+		G4cerr << "Can't open WEPL calibration " << filename << G4endl;
+		return false;
+	}
+
+	calibration.clear();
+	std::string line;
+	while (std::getline( file, line)) {
+		std::istringstream fields(line);
+		std::string key;
+		if (!(fields >> key) || key[0] == '#')
+			continue;
+
+		G4double position = 0.0, wepl = 0.0;
+		if (key != "point" || !(fields >> position >> wepl)) {
+			G4cerr << "Wrong WEPL calibration line: " << line << G4endl;
+			return false;
+		}
+		calibration.points_.push_back(std::make_pair( position, wepl));
+	}
+	calibration.sort_points();
+	return !calibration.empty();
+}
+
+} // namespace CarbonIonRadiography